@@ -0,0 +1,286 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "body.h"
+#include "ship.h"
+#include "physics.h"
+#include "quadtree.h"
+
+/*
+    Barnes-Hut accuracy and speed benchmark
+    For each synthetic distribution and body count, the quadtree is built and probed at a fixed set of ship positions
+    for a sweep of theta, and compared against brute-force computeShipGravity
+    Errors are relative to a double precision direct sum, so the float error of computeShipGravity itself is reported
+    alongside as the floor any theta can reach
+
+    Usage: quadtree_bench [maxBodies] > results.json
+*/
+
+#define BENCH_PROBES 256
+#define BENCH_MIN_SECONDS 0.05
+#define BENCH_WORLD_SIZE 1e7f
+
+typedef enum
+{
+    DIST_UNIFORM,
+    DIST_CLUSTERED,
+    DIST_DISC,
+    DIST_HIERARCHICAL,
+    DIST_COUNT
+} Distribution;
+
+static const char *distributionNames[DIST_COUNT] = {"uniform", "clustered", "disc", "hierarchical"};
+static const float thetas[] = {0.1f, 0.2f, 0.3f, 0.5f, 0.7f, 1.0f, 1.5f};
+static const int numThetas = sizeof(thetas) / sizeof(thetas[0]);
+
+static unsigned long long rngState = 0x9e3779b97f4a7c15ULL;
+
+static double randomUniform(void)
+{
+    // xorshift64* - fixed seed so every run sees the same bodies
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (double)((rngState * 0x2545f4914f6cdd1dULL) >> 11) / 9007199254740992.0;
+}
+
+static double randomGaussian(void)
+{
+    double u = fmax(randomUniform(), 1e-300);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * PI * randomUniform());
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static Vector2 polar(float radius, float angle)
+{
+    return (Vector2){radius * cosf(angle), radius * sinf(angle)};
+}
+
+static void placeBody(celestialbody_t *body, Vector2 position, float mass)
+{
+    memset(body, 0, sizeof(celestialbody_t));
+    body->type = TYPE_PLANET;
+    body->position = position;
+    body->mass = mass;
+    body->radius = 1.0f;
+}
+
+static void generateBodies(Distribution distribution, celestialbody_t *store, int count)
+{
+    float half = BENCH_WORLD_SIZE / 2;
+    switch (distribution)
+    {
+    case DIST_UNIFORM:
+        for (int i = 0; i < count; i++)
+        {
+            Vector2 p = {(randomUniform() * 2 - 1) * half, (randomUniform() * 2 - 1) * half};
+            placeBody(&store[i], p, 1e6f + randomUniform() * 1e7f);
+        }
+        break;
+    case DIST_CLUSTERED:
+    {
+        // Gaussian blobs of very different sizes
+        Vector2 centres[16];
+        float spreads[16];
+        for (int c = 0; c < 16; c++)
+        {
+            centres[c] = (Vector2){(randomUniform() * 2 - 1) * half * 0.8f, (randomUniform() * 2 - 1) * half * 0.8f};
+            spreads[c] = half * powf(10.0f, -1.0f - 2.0f * randomUniform());
+        }
+        for (int i = 0; i < count; i++)
+        {
+            int c = (int)(randomUniform() * 16);
+            Vector2 p = {centres[c].x + randomGaussian() * spreads[c], centres[c].y + randomGaussian() * spreads[c]};
+            placeBody(&store[i], p, 1e6f + randomUniform() * 1e7f);
+        }
+        break;
+    }
+    case DIST_DISC:
+        // Exponential disc around a heavy central mass
+        placeBody(&store[0], Vector2Zero(), 1e12f);
+        for (int i = 1; i < count; i++)
+        {
+            float r = -logf(fmaxf(randomUniform(), 1e-7f)) * half * 0.15f;
+            placeBody(&store[i], polar(r, randomUniform() * 2 * PI), 1e5f + randomUniform() * 1e6f);
+        }
+        break;
+    case DIST_HIERARCHICAL:
+    {
+        // Star systems, each with planets, each with moons, at game-like scales
+        int i = 0;
+        while (i < count)
+        {
+            Vector2 star = {(randomUniform() * 2 - 1) * half, (randomUniform() * 2 - 1) * half};
+            placeBody(&store[i++], star, 1e11f);
+            int planets = 2 + (int)(randomUniform() * 8);
+            for (int p = 0; p < planets && i < count; p++)
+            {
+                Vector2 planet = Vector2Add(star, polar(2e4f * powf(1.8f, p) * (1 + randomUniform()), randomUniform() * 2 * PI));
+                placeBody(&store[i++], planet, 1e9f * (0.1f + randomUniform() * 5));
+                int moons = (int)(randomUniform() * 6);
+                for (int m = 0; m < moons && i < count; m++)
+                {
+                    Vector2 moon = Vector2Add(planet, polar(1e3f * (2 + m * 3 + randomUniform()), randomUniform() * 2 * PI));
+                    placeBody(&store[i++], moon, 1e7f * (0.1f + randomUniform()));
+                }
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static Vector2 directAccelerationExact(celestialbody_t **bodies, int count, Vector2 position)
+{
+    double ax = 0, ay = 0;
+    for (int i = 0; i < count; i++)
+    {
+        double dx = (double)bodies[i]->position.x - position.x;
+        double dy = (double)bodies[i]->position.y - position.y;
+        double distSqr = fmax(dx * dx + dy * dy, 1e-10);
+        double invDist3 = 1.0 / (distSqr * sqrt(distSqr));
+        ax += bodies[i]->mass * dx * invDist3;
+        ay += bodies[i]->mass * dy * invDist3;
+    }
+    return (Vector2){(float)(G * ax), (float)(G * ay)};
+}
+
+static void relativeError(const Vector2 *approx, const Vector2 *exact, int count, double *rms, double *max)
+{
+    double sum = 0;
+    *max = 0;
+    for (int i = 0; i < count; i++)
+    {
+        double err = Vector2Distance(approx[i], exact[i]) / fmax(Vector2Length(exact[i]), 1e-30);
+        sum += err * err;
+        *max = fmax(*max, err);
+    }
+    *rms = sqrt(sum / count);
+}
+
+static void runCase(Distribution distribution, int count, bool first)
+{
+    celestialbody_t *store = malloc(sizeof(celestialbody_t) * count);
+    celestialbody_t **bodies = malloc(sizeof(celestialbody_t *) * count);
+    ship_t *probes = calloc(BENCH_PROBES, sizeof(ship_t));
+    Vector2 *exact = malloc(sizeof(Vector2) * BENCH_PROBES);
+    Vector2 *approx = malloc(sizeof(Vector2) * BENCH_PROBES);
+    if (!store || !bodies || !probes || !exact || !approx)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate benchmark buffers for %i bodies", count);
+        exit(1);
+    }
+
+    generateBodies(distribution, store, count);
+    for (int i = 0; i < count; i++)
+        bodies[i] = &store[i];
+
+    // Probe next to random bodies so dense regions are sampled as often as the ships would visit them
+    for (int i = 0; i < BENCH_PROBES; i++)
+    {
+        Vector2 anchor = bodies[(int)(randomUniform() * count)]->position;
+        Vector2 offset = polar(1e3f * (1 + randomUniform() * 100), randomUniform() * 2 * PI);
+        probes[i].position = Vector2Add(anchor, offset);
+        probes[i].mass = 1.0f;
+        exact[i] = directAccelerationExact(bodies, count, probes[i].position);
+    }
+
+    // Direct summation - ship mass 1 so force equals acceleration
+    int reps = 0;
+    double start = now(), elapsed;
+    do
+    {
+        for (int i = 0; i < BENCH_PROBES; i++)
+            approx[i] = computeShipGravity(&probes[i], bodies, count);
+        reps++;
+        elapsed = now() - start;
+    } while (elapsed < BENCH_MIN_SECONDS);
+    double directPerProbe = elapsed / (reps * BENCH_PROBES);
+    double directRms, directMax;
+    relativeError(approx, exact, BENCH_PROBES, &directRms, &directMax);
+
+    // Tree build, repeated for small N so timer resolution does not dominate
+    QuadTreeNode *root = NULL;
+    reps = 0;
+    start = now();
+    do
+    {
+        freeQuadTree(root);
+        root = buildQuadTree(bodies, count);
+        reps++;
+        elapsed = now() - start;
+    } while (elapsed < BENCH_MIN_SECONDS);
+    double buildSeconds = elapsed / reps;
+
+    printf("%s    {\"distribution\": \"%s\", \"bodies\": %i, \"probes\": %i, \"buildSeconds\": %.9g, "
+           "\"directSecondsPerProbe\": %.9g, \"directRmsError\": %.6g, \"directMaxError\": %.6g, \"thetas\": [",
+           first ? "" : ",\n", distributionNames[distribution], count, BENCH_PROBES, buildSeconds,
+           directPerProbe, directRms, directMax);
+
+    for (int t = 0; t < numThetas; t++)
+    {
+        reps = 0;
+        start = now();
+        do
+        {
+            for (int i = 0; i < BENCH_PROBES; i++)
+                approx[i] = computeQuadTreeAcceleration(root, probes[i].position, NULL, thetas[t]);
+            reps++;
+            elapsed = now() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+        double treePerProbe = elapsed / (reps * BENCH_PROBES);
+        double rms, max;
+        relativeError(approx, exact, BENCH_PROBES, &rms, &max);
+
+        // Probes per rebuild at which the tree pays for itself
+        double breakEven = directPerProbe > treePerProbe ? buildSeconds / (directPerProbe - treePerProbe) : -1;
+
+        printf("%s\n      {\"theta\": %.3g, \"secondsPerProbe\": %.9g, \"rmsError\": %.6g, \"maxError\": %.6g, "
+               "\"speedup\": %.6g, \"breakEvenProbes\": %.6g}",
+               t == 0 ? "" : ",", thetas[t], treePerProbe, rms, max, directPerProbe / treePerProbe, breakEven);
+    }
+    printf("]}");
+    fflush(stdout);
+
+    fprintf(stderr, "%-12s N=%-8i build %.3gms direct %.3gus/probe\n", distributionNames[distribution], count,
+            buildSeconds * 1e3, directPerProbe * 1e6);
+
+    freeQuadTree(root);
+    free(store);
+    free(bodies);
+    free(probes);
+    free(exact);
+    free(approx);
+}
+
+int main(int argc, char **argv)
+{
+    int maxBodies = argc > 1 ? atoi(argv[1]) : 1000000;
+    SetTraceLogLevel(LOG_WARNING);
+
+    printf("{\n  \"benchmark\": \"quadtree\",\n  \"G\": %g,\n  \"runs\": [\n", (double)G);
+    bool first = true;
+    for (int d = 0; d < DIST_COUNT; d++)
+    {
+        for (int count = 100; count <= maxBodies; count *= 10)
+        {
+            runCase((Distribution)d, count, first);
+            first = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
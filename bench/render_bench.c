@@ -0,0 +1,354 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "body.h"
+#include "ship.h"
+#include "game.h"
+#include "ui.h"
+#include "spatial.h"
+#include "rendering.h"
+#include "trajectory.h"
+#include "shiprenderer.h"
+#include "grid.h"
+#include "drawlist.h"
+
+/*
+    Headless render-path benchmark
+    Builds a fixed scene of star systems and ships, records a frame into a draw list at several zoom levels and reports
+    the command count per op type, the list hash and the time to record. Nothing is replayed, so no window or GL context
+    is needed - the counts and hashes double as golden values for catching draw-call regressions
+    Pass --dump to also write every op of every case to stderr
+    Pass --golden to compare every case against a golden file and exit non-zero on a mismatch, or --write-golden to
+    regenerate it after an intended change to what gets drawn
+
+    Usage: render_bench [numShips] [--dump] [--golden file | --write-golden file] > results.json
+*/
+
+#define BENCH_MIN_SECONDS 0.05
+#define BENCH_SYSTEMS 8
+#define BENCH_TRAJECTORY_POINTS 4096
+
+static const float zooms[] = {1.0f, 0.05f, 0.001f, 0.00001f};
+static const int numZooms = sizeof(zooms) / sizeof(zooms[0]);
+
+static unsigned long long rngState = 0x9e3779b97f4a7c15ULL;
+
+static double randomUniform(void)
+{
+    // xorshift64* - fixed seed so every run records the same scene
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (double)((rngState * 0x2545f4914f6cdd1dULL) >> 11) / 9007199254740992.0;
+}
+
+typedef struct
+{
+    int numShips;
+    float zoom;
+    int numCommands;
+    int numInstances;
+    int numPoints;
+    unsigned long long hash;
+    int counts[DRAW_OP_COUNT];
+} goldenrun_t;
+
+static void writeGoldenRun(FILE *file, goldenrun_t *run)
+{
+    fprintf(file, "%i %g %i %i %i %016llx", run->numShips, run->zoom, run->numCommands, run->numInstances, run->numPoints, run->hash);
+    for (int op = 0; op < DRAW_OP_COUNT; op++)
+    {
+        fprintf(file, " %i", run->counts[op]);
+    }
+    fprintf(file, "\n");
+}
+
+static bool readGoldenRun(FILE *file, goldenrun_t *run)
+{
+    // Lines starting with # are comments
+    int c;
+    while ((c = fgetc(file)) == '#')
+    {
+        while ((c = fgetc(file)) != '\n' && c != EOF)
+            ;
+    }
+    if (c == EOF)
+        return false;
+    ungetc(c, file);
+
+    if (fscanf(file, "%i %f %i %i %i %llx", &run->numShips, &run->zoom, &run->numCommands, &run->numInstances, &run->numPoints, &run->hash) != 6)
+        return false;
+    for (int op = 0; op < DRAW_OP_COUNT; op++)
+    {
+        if (fscanf(file, "%i", &run->counts[op]) != 1)
+            return false;
+    }
+    // Consume the rest of the line so a trailing comment cannot start the next read
+    while ((c = fgetc(file)) != '\n' && c != EOF)
+        ;
+    return true;
+}
+
+static bool compareGoldenRun(goldenrun_t *expected, goldenrun_t *actual)
+{
+    bool match = expected->numShips == actual->numShips && expected->zoom == actual->zoom &&
+                 expected->numCommands == actual->numCommands && expected->numInstances == actual->numInstances &&
+                 expected->numPoints == actual->numPoints && expected->hash == actual->hash;
+    for (int op = 0; op < DRAW_OP_COUNT; op++)
+    {
+        if (expected->counts[op] != actual->counts[op])
+        {
+            TraceLog(LOG_ERROR, "Golden mismatch at zoom %g: %s count %i, expected %i", actual->zoom,
+                     getDrawOpName((DrawOpType)op), actual->counts[op], expected->counts[op]);
+            match = false;
+        }
+    }
+    if (!match)
+    {
+        TraceLog(LOG_ERROR, "Golden mismatch at zoom %g with %i ships: %i commands, %i instances, %i points, hash %016llx - "
+                            "expected %i ships, %i commands, %i instances, %i points, hash %016llx",
+                 actual->zoom, actual->numShips, actual->numCommands, actual->numInstances, actual->numPoints, actual->hash,
+                 expected->numShips, expected->numCommands, expected->numInstances, expected->numPoints, expected->hash);
+    }
+    return match;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static Vector2 polar(float radius, float angle)
+{
+    return (Vector2){radius * cosf(angle), radius * sinf(angle)};
+}
+
+static int buildBodies(celestialbody_t *store, celestialbody_t **bodies, int capacity)
+{
+    // Star systems, each with planets on rings, laid out around the origin
+    int count = 0;
+    for (int s = 0; s < BENCH_SYSTEMS && count < capacity; s++)
+    {
+        int starIndex = count;
+        celestialbody_t *star = &store[count];
+        memset(star, 0, sizeof(celestialbody_t));
+        star->type = TYPE_STAR;
+        strcpy(star->name, "Star");
+        star->parentIndex = -1;
+        star->position = polar(s == 0 ? 0 : 1e8f * (1 + randomUniform()), randomUniform() * 2 * PI);
+        star->radius = 5e4f;
+        // Untextured - textures need the asset loader and a GL context
+        star->textureId = TEXTURE_NONE;
+        bodies[count++] = star;
+        int planets = 3 + (int)(randomUniform() * 6);
+        for (int p = 0; p < planets && count < capacity; p++)
+        {
+            celestialbody_t *planet = &store[count];
+            memset(planet, 0, sizeof(celestialbody_t));
+            planet->type = TYPE_PLANET;
+            strcpy(planet->name, "Planet");
+            planet->parentIndex = starIndex;
+            planet->orbitalRadius = 2e5f * powf(1.8f, p) * (1 + randomUniform());
+            planet->position = Vector2Add(star->position, polar(planet->orbitalRadius, randomUniform() * 2 * PI));
+            planet->radius = 2e3f + randomUniform() * 8e3f;
+            planet->textureId = TEXTURE_NONE;
+            planet->atmosphereRadius = planet->radius * 1.2f;
+            planet->atmosphereColour = (Color){100, 150, 255, 80};
+            bodies[count++] = planet;
+        }
+    }
+    return count;
+}
+
+static void buildShips(ship_t *store, ship_t **ships, Vector2 *paths, int count, celestialbody_t **bodies, int numBodies)
+{
+    // Ships near random bodies, each with a spiral path so trajectory chunks span a range of sizes
+    for (int i = 0; i < count; i++)
+    {
+        ship_t *ship = &store[i];
+        memset(ship, 0, sizeof(ship_t));
+        Vector2 anchor = bodies[(int)(randomUniform() * numBodies)]->position;
+        ship->position = Vector2Add(anchor, polar(1e4f * (1 + randomUniform() * 10), randomUniform() * 2 * PI));
+        ship->rotation = randomUniform() * 360;
+        ship->radius = 16;
+        ship->textureScale = 1;
+        ship->baseTextureId = i % 2 == 0 ? 0 : 8;
+        ship->engineTextureId = i % 2 == 0 ? 1 : TEXTURE_NONE;
+        ship->mainEnginesOn = randomUniform() < 0.5;
+        ship->thrusterRotateLeft = randomUniform() < 0.25;
+        // Only the first few ships carry a path, like the player's own fleet
+        ship->drawTrajectory = i < 4;
+        ship->trajectorySize = BENCH_TRAJECTORY_POINTS;
+        ship->futurePositions = &paths[i % 4 * BENCH_TRAJECTORY_POINTS];
+        ship->trajectoryRevision = 1;
+        ships[i] = ship;
+    }
+    for (int p = 0; p < 4 * BENCH_TRAJECTORY_POINTS; p++)
+    {
+        int k = p % BENCH_TRAJECTORY_POINTS;
+        paths[p] = Vector2Add(store[p / BENCH_TRAJECTORY_POINTS].position, polar(1e3f * k, k * 0.01f));
+    }
+}
+
+static void recordFrame(drawlist_t *list, Vector2 screenSize, trajectoryrenderer_t *trajectories, shiprenderer_t *shipRenderer,
+                        gridrenderer_t *gridRenderer, renderview_t *view, spatialindex_t *index, celestialbody_t **bodies, int numBodies,
+                        ship_t **ships, int numShips, Camera2D camera, ColourScheme *colourScheme, HUD *hud)
+{
+    // Same order as the game loop
+    clearDrawList(list, screenSize);
+    cullRenderView(view, index, camera, screenSize);
+    drawListBeginCamera(list, camera);
+    drawCelestialGrid(list, gridRenderer, camera, view->bounds, 1.0f, colourScheme);
+    drawOrbits(list, bodies, numBodies, view, &camera, ORBIT_TOLERANCE, colourScheme);
+    drawTrajectories(list, trajectories, ships, numShips, &camera, view->bounds, colourScheme);
+    drawBodies(list, bodies, numBodies, view);
+    drawShips(list, shipRenderer, ships, numShips, &camera, view, SHIP_ICON_ZOOM);
+    drawListEndCamera(list);
+    hud->zoom = camera.zoom;
+    drawPlayerHUD(list, hud);
+}
+
+int main(int argc, char **argv)
+{
+    int numShips = 10000;
+    bool dump = false;
+    const char *goldenPath = NULL;
+    bool writeGolden = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--dump") == 0)
+            dump = true;
+        else if ((strcmp(argv[i], "--golden") == 0 || strcmp(argv[i], "--write-golden") == 0) && i + 1 < argc)
+        {
+            writeGolden = strcmp(argv[i], "--write-golden") == 0;
+            goldenPath = argv[++i];
+        }
+        else
+            numShips = atoi(argv[i]);
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    FILE *golden = NULL;
+    if (goldenPath)
+    {
+        golden = fopen(goldenPath, writeGolden ? "w" : "r");
+        if (!golden)
+        {
+            TraceLog(LOG_ERROR, "Failed to open golden file %s", goldenPath);
+            return 1;
+        }
+        if (writeGolden)
+            fprintf(golden, "# ships zoom commands instances points hash, then the count of each draw op in enum order\n");
+    }
+    int mismatches = 0;
+
+    int bodyCapacity = BENCH_SYSTEMS * 9;
+    celestialbody_t *bodyStore = malloc(sizeof(celestialbody_t) * bodyCapacity);
+    celestialbody_t **bodies = malloc(sizeof(celestialbody_t *) * bodyCapacity);
+    ship_t *shipStore = malloc(sizeof(ship_t) * numShips);
+    ship_t **ships = malloc(sizeof(ship_t *) * numShips);
+    Vector2 *paths = malloc(sizeof(Vector2) * 4 * BENCH_TRAJECTORY_POINTS);
+    if (!bodyStore || !bodies || !shipStore || !ships || !paths || numShips < 4)
+    {
+        TraceLog(LOG_ERROR, "Failed to set up a scene with %i ships", numShips);
+        return 1;
+    }
+    int numBodies = buildBodies(bodyStore, bodies, bodyCapacity);
+    buildShips(shipStore, ships, paths, numShips, bodies, numBodies);
+
+    spatialindex_t *index = createSpatialIndex(SPATIAL_NODE_CAPACITY);
+    buildSpatialIndex(index, bodies, numBodies, ships, numShips);
+    renderview_t view = createRenderView();
+    drawlist_t list = createDrawList();
+    trajectoryrenderer_t *trajectories = createTrajectoryRenderer();
+    shiprenderer_t *shipRenderer = createShipRenderer();
+    gridrenderer_t *gridRenderer = createGridRenderer();
+    ColourScheme colourScheme = {.gridColour = DARKGRAY, .orbitColour = GRAY};
+    Vector2 screenSize = {1280, 720};
+    HUD hud = {.speed = 1234.5f, .playerRotation = 45.0f, .velocityTarget = bodies[0], .timeScale = 1.0f, .paused = true};
+
+    printf("{\n  \"benchmark\": \"render\",\n  \"bodies\": %i,\n  \"ships\": %i,\n  \"runs\": [\n", numBodies, numShips);
+    for (int z = 0; z < numZooms; z++)
+    {
+        Camera2D camera = {.offset = {screenSize.x / 2, screenSize.y / 2}, .target = ships[0]->position, .rotation = 0, .zoom = zooms[z]};
+
+        int reps = 0;
+        double start = now(), elapsed;
+        do
+        {
+            recordFrame(&list, screenSize, trajectories, shipRenderer, gridRenderer, &view, index, bodies, numBodies, ships, numShips, camera, &colourScheme, &hud);
+            reps++;
+            elapsed = now() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+
+        drawliststats_t stats = recordDrawList(&list);
+        printf("%s    {\"zoom\": %g, \"recordSeconds\": %.9g, \"commands\": %i, \"instances\": %i, \"points\": %i, "
+               "\"hash\": \"%016llx\", \"counts\": {",
+               z == 0 ? "" : ",\n", zooms[z], elapsed / reps, stats.numCommands, list.numInstances, list.numPoints,
+               (unsigned long long)stats.hash);
+        for (int op = 0; op < DRAW_OP_COUNT; op++)
+        {
+            printf("%s\"%s\": %i", op == 0 ? "" : ", ", getDrawOpName((DrawOpType)op), stats.counts[op]);
+        }
+        printf("}}");
+        fflush(stdout);
+
+        if (golden)
+        {
+            goldenrun_t run = {
+                .numShips = numShips,
+                .zoom = zooms[z],
+                .numCommands = stats.numCommands,
+                .numInstances = list.numInstances,
+                .numPoints = list.numPoints,
+                .hash = (unsigned long long)stats.hash};
+            memcpy(run.counts, stats.counts, sizeof(run.counts));
+            goldenrun_t expected;
+            if (writeGolden)
+                writeGoldenRun(golden, &run);
+            else if (!readGoldenRun(golden, &expected))
+            {
+                TraceLog(LOG_ERROR, "Golden file %s has no entry for zoom %g", goldenPath, zooms[z]);
+                mismatches++;
+            }
+            else if (!compareGoldenRun(&expected, &run))
+                mismatches++;
+        }
+
+        if (dump)
+        {
+            fprintf(stderr, "# zoom %g\n", zooms[z]);
+            dumpDrawList(&list, stderr);
+        }
+    }
+    printf("\n  ]\n}\n");
+    if (golden)
+    {
+        fclose(golden);
+        if (mismatches > 0)
+            TraceLog(LOG_ERROR, "%i of %i cases differ from %s", mismatches, numZooms, goldenPath);
+    }
+
+    freeHudLayer(&hud.staticLayer);
+    freeHudLayer(&hud.pauseLayer);
+    freeDrawList(&list);
+    freeRenderView(&view);
+    freeSpatialIndex(index);
+    freeTrajectoryRenderer(trajectories);
+    freeShipRenderer(shipRenderer);
+    freeGridRenderer(gridRenderer);
+    freeOrbitCache();
+    free(bodyStore);
+    free(bodies);
+    free(shipStore);
+    free(ships);
+    free(paths);
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "config.h"
+
+/*
+    Asset pack
+    One file holding every texture in the texture map already decoded to RGBA8, built from assets/ by `make pack`. The
+    header is followed by an index sorted by path hash, then each image's pixels at ASSET_PACK_ALIGNMENT. At runtime the
+    file is mapped read-only and a packed image's data points straight into the mapping, so textures upload without
+    decoding a PNG or copying the pixels first
+    Loose files are still used for anything missing from the pack, so rebuild it after changing assets/
+*/
+
+#define ASSET_PACK_MAGIC 0x4B504147 // "GAPK" in a little-endian file
+#define ASSET_PACK_VERSION 1
+
+typedef struct AssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t reserved;
+} assetpackheader_t;
+
+typedef struct AssetPackEntry
+{
+    uint64_t pathHash; // hashAssetPath of the filename in the texture map
+    uint64_t offset;   // Pixel data from the start of the file
+    uint64_t size;
+    int32_t id; // Texture map id
+    uint32_t width;
+    uint32_t height;
+    uint32_t format; // Raylib PixelFormat
+} assetpackentry_t;
+
+uint64_t hashAssetPath(const char *path);
+bool openAssetPack(const char *path);
+void closeAssetPack(void);
+bool findPackedImage(const char *filename, Image *image);
+bool findPackedImageById(int id, Image *image);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "raylib.h"
+#include "config.h"
+
+/*
+    Asynchronous asset loader
+    Files are decoded into images on a pool of worker threads. Texture requests then wait in an upload queue that the
+    main thread drains with processAssetUploads, spending at most a fixed time per frame so streaming never hitches
+    rendering. Until a texture is ready its handle returns a placeholder, so callers can draw straight away
+    Image requests stop after decoding and hand their image to the caller - the sprite atlas uses these to decode every
+    sprite in parallel at startup
+    Requests, uploads and releases happen on the main thread - only decoding runs on the workers
+    Files found in the asset pack skip the workers entirely, their textures uploading straight from the mapped pack
+    Generated assets run a generator on the workers in place of the file decode, with a copy of its parameters
+*/
+
+typedef enum
+{
+    ASSET_PENDING, // Queued or decoding, or decoded and waiting for its upload
+    ASSET_READY,
+    ASSET_FAILED
+} AssetState;
+
+typedef enum
+{
+    ASSET_TEXTURE, // Decoded then uploaded, owned by the loader until released
+    ASSET_IMAGE    // Decoded only, taken by the caller with takeAssetImage
+} AssetKind;
+
+// Builds an image from its parameters on a worker thread - it must not touch raylib's GL state or shared buffers
+typedef Image (*AssetGenerator)(const void *params);
+
+bool initAssetLoader(void);
+void shutdownAssetLoader(void);
+int requestAsset(const char *filename, AssetKind kind);
+int requestGeneratedAsset(const char *name, AssetGenerator generate, const void *params, size_t paramsSize, AssetKind kind);
+AssetState getAssetState(int handle);
+void waitForAsset(int handle);
+Texture2D getAssetTexture(int handle);
+Texture2D getPlaceholderTexture(void);
+Image takeAssetImage(int handle);
+void releaseAsset(int handle);
+int processAssetUploads(double budgetSeconds);
+
+#endif
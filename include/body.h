@@ -19,19 +19,25 @@ typedef enum
     TYPE_SPACESTATION
 } CelestialType;
 
+#define BODY_NAME_LENGTH 32
+
 typedef struct CelestialBody celestialbody_t;
 
+/*
+    Bodies hold no pointers, so a save can store them as they are and a load can use them straight out of the mapped
+    file. The name is NUL-padded but may fill the whole array, so print it with a precision of BODY_NAME_LENGTH
+*/
 typedef struct CelestialBody
 {
     CelestialType type;
-    char *name;
+    char name[BODY_NAME_LENGTH];
     Vector2 position;
     float mass; // Kg
     float radius;
     float rotation;
-    Texture2D *texture;
-    float textureScale;
-    celestialbody_t *parentBody;
+    int textureId;      // Streamed in by the residency manager while on screen, TEXTURE_NONE for a plain circle, or TEXTURE_PROCEDURAL
+    float textureScale; // Texture diameter as a multiple of the body's
+    int parentIndex;     // Resolved with getBodyPtr, -1 for none
     float orbitalRadius; // Distance from center for orbits (0 for black hole/ship)
     float angularSpeed;  // Radians per second (0 for black hole/ship)
     float initialAngle;  // Starting angle for orbit
@@ -42,7 +48,6 @@ typedef struct CelestialBody
 
 float getBodyAngle(celestialbody_t *body, float gameTime);
 celestialbody_t **initBodies(int *numBodies);
-bool saveBody(celestialbody_t *body, FILE *file, gamestate_t *state);
 int getBodyIndex(celestialbody_t *body, celestialbody_t **bodies, int numBodies);
 celestialbody_t* getBodyPtr(int index, celestialbody_t **bodies, int numBodies);
 void freeCelestialBodies(celestialbody_t **bodies, int numBodies);
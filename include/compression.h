@@ -0,0 +1,22 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+    Block compression
+    An LZ77 codec in the LZ4 block format - a run of tokens, each some literal bytes followed by a copy of at least
+    COMPRESSION_MIN_MATCH bytes from up to 64KiB back. Matches are found through a hash of the next four bytes in a
+    single pass with no entropy coding, so compressing is cheap enough for every autosave and decompressing is a copy
+    loop. Blocks are independent of each other
+*/
+
+#define COMPRESSION_MIN_MATCH 4
+#define COMPRESSION_MAX_OFFSET 65535
+
+size_t compressBound(size_t size);
+size_t compressBlock(const unsigned char *src, size_t size, unsigned char *dst, size_t capacity);
+bool decompressBlock(const unsigned char *src, size_t size, unsigned char *dst, size_t dstSize);
+
+#endif
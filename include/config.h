@@ -32,6 +32,216 @@
 #ifndef MAX_CAPACITY
 #define MAX_CAPACITY 100
 #endif
+#ifndef SPATIAL_NODE_CAPACITY
+#define SPATIAL_NODE_CAPACITY 8
+#endif
+#ifndef SPATIAL_MAX_DEPTH
+#define SPATIAL_MAX_DEPTH 24
+#endif
+// Default number of results a spatial query buffer can hold
+#ifndef SPATIAL_QUERY_CAPACITY
+#define SPATIAL_QUERY_CAPACITY 1024
+#endif
+// Screen-space radius in pixels used when picking with the mouse
+#ifndef PICK_RADIUS
+#define PICK_RADIUS 8
+#endif
+// Screen-space padding in pixels around the view when culling, covers the zoomed-out ship icon
+#ifndef CULL_MARGIN
+#define CULL_MARGIN 32.0f
+#endif
+// Sprite atlas size limits in pixels, and the transparent gap between packed sprites
+#ifndef ATLAS_MIN_SIZE
+#define ATLAS_MIN_SIZE 128
+#endif
+#ifndef ATLAS_MAX_SIZE
+#define ATLAS_MAX_SIZE 4096
+#endif
+#ifndef ATLAS_PADDING
+#define ATLAS_PADDING 2
+#endif
+// Camera zoom at or below which ships are drawn as their logo icon instead of their sprite layers
+#ifndef SHIP_ICON_ZOOM
+#define SHIP_ICON_ZOOM 0.05f
+#endif
+// Trajectory line thickness in screen pixels
+#ifndef TRAJECTORY_LINE_WIDTH
+#define TRAJECTORY_LINE_WIDTH 2.0f
+#endif
+// Orbit rings - maximum chord error in screen pixels and segment limits
+#ifndef ORBIT_TOLERANCE
+#define ORBIT_TOLERANCE 0.5f
+#endif
+#ifndef ORBIT_MIN_SEGMENTS
+#define ORBIT_MIN_SEGMENTS 16
+#endif
+#ifndef ORBIT_MAX_SEGMENTS
+#define ORBIT_MAX_SEGMENTS 16384
+#endif
+// Zoom change that triggers retessellating a cached orbit
+#ifndef ORBIT_RETESSELLATE_FACTOR
+#define ORBIT_RETESSELLATE_FACTOR 2.0f
+#endif
+// Segments per trajectory mesh chunk - chunks are culled and uploaded independently
+#ifndef TRAJECTORY_CHUNK_SEGMENTS
+#define TRAJECTORY_CHUNK_SEGMENTS 1024
+#endif
+// Celestial grid - hidden at or above GRID_MAX_ZOOM, tile size in cells, line thickness in screen pixels
+#ifndef GRID_MAX_ZOOM
+#define GRID_MAX_ZOOM 0.01f
+#endif
+#ifndef GRID_TILE_CELLS
+#define GRID_TILE_CELLS 16
+#endif
+#ifndef GRID_LINE_PIXELS
+#define GRID_LINE_PIXELS 1.0f
+#endif
+// Zoom range over which neighbouring grid bands fade in and out
+#ifndef GRID_FADE_FACTOR
+#define GRID_FADE_FACTOR 2.0f
+#endif
+// Quality governor - share of the frame or tick period its work may use, spare share before raising a knob again,
+// cost smoothing per sample and frames between adjustments
+#ifndef QUALITY_BUDGET_FRACTION
+#define QUALITY_BUDGET_FRACTION 0.85f
+#endif
+#ifndef QUALITY_RAISE_HEADROOM
+#define QUALITY_RAISE_HEADROOM 0.6f
+#endif
+#ifndef QUALITY_SMOOTHING
+#define QUALITY_SMOOTHING 0.1f
+#endif
+#ifndef QUALITY_ADJUST_FRAMES
+#define QUALITY_ADJUST_FRAMES 30
+#endif
+// Asset loader - slots for in-flight and loaded assets, worker thread limit, longest path, parameter bytes a generated
+// asset can carry and placeholder size in pixels
+#ifndef ASSET_CAPACITY
+#define ASSET_CAPACITY 256
+#endif
+#ifndef ASSET_MAX_WORKERS
+#define ASSET_MAX_WORKERS 8
+#endif
+#ifndef ASSET_PATH_CAPACITY
+#define ASSET_PATH_CAPACITY 256
+#endif
+#ifndef ASSET_PARAMS_CAPACITY
+#define ASSET_PARAMS_CAPACITY 64
+#endif
+#ifndef ASSET_PLACEHOLDER_SIZE
+#define ASSET_PLACEHOLDER_SIZE 16
+#endif
+// Seconds per frame the main thread may spend uploading streamed textures
+#ifndef ASSET_UPLOAD_BUDGET
+#define ASSET_UPLOAD_BUDGET 0.002
+#endif
+// Pre-decoded asset pack written by make pack, and the byte alignment of each image's pixels in it
+#ifndef ASSET_PACK_PATH
+#define ASSET_PACK_PATH "assets/assets.pack"
+#endif
+#ifndef ASSET_PACK_ALIGNMENT
+#define ASSET_PACK_ALIGNMENT 64
+#endif
+// Texture residency - GPU bytes kept for body textures, and the screen radius in pixels below which a body stays untextured
+#ifndef TEXTURE_RESIDENCY_BUDGET
+#define TEXTURE_RESIDENCY_BUDGET (64 * 1024 * 1024)
+#endif
+#ifndef TEXTURE_RESIDENCY_MIN_PIXELS
+#define TEXTURE_RESIDENCY_MIN_PIXELS 8.0f
+#endif
+// Texture streaming limits - requests in flight at once, well under ASSET_CAPACITY, and the frames waited before retrying a
+// failed texture, doubled for each failure in a row up to TEXTURE_RESIDENCY_MAX_BACKOFF times
+#ifndef TEXTURE_RESIDENCY_MAX_PENDING
+#define TEXTURE_RESIDENCY_MAX_PENDING 16
+#endif
+#ifndef TEXTURE_RESIDENCY_RETRY_FRAMES
+#define TEXTURE_RESIDENCY_RETRY_FRAMES 60
+#endif
+#ifndef TEXTURE_RESIDENCY_MAX_BACKOFF
+#define TEXTURE_RESIDENCY_MAX_BACKOFF 5
+#endif
+// Procedural body surfaces - texture size in pixels, and where generated surfaces are cached between runs
+#ifndef PLANET_TEXTURE_SIZE
+#define PLANET_TEXTURE_SIZE 256
+#endif
+#ifndef PLANET_CACHE_DIR
+#define PLANET_CACHE_DIR "cache"
+#endif
+// Tiles one band may record before it is skipped
+#ifndef GRID_MAX_TILES
+#define GRID_MAX_TILES 1024
+#endif
+// Quadtree leaves smaller than this stop splitting and hold several bodies
+#ifndef QUADTREE_MIN_CELL_SIZE
+#define QUADTREE_MIN_CELL_SIZE 1e-2f
+#endif
+// Bodies nearest the selected ship that KEY_V cycles the velocity lock through
+#ifndef VELOCITY_CYCLE_BODIES
+#define VELOCITY_CYCLE_BODIES 8
+#endif
+// Simulation thread tick rate in Hz, and the longest real time a single tick may cover
+#ifndef SIM_TICK_RATE
+#define SIM_TICK_RATE 60
+#endif
+#ifndef SIM_MAX_TICK_SECONDS
+#define SIM_MAX_TICK_SECONDS 0.1f
+#endif
+// Pending discrete commands from the render thread to the simulation thread
+#ifndef SIM_COMMAND_CAPACITY
+#define SIM_COMMAND_CAPACITY 64
+#endif
+// Manual save slot, and the autosave journaled every AUTOSAVE_INTERVAL seconds of unpaused play
+#ifndef SAVE_PATH
+#define SAVE_PATH "gas_save_1.dat"
+#endif
+#ifndef AUTOSAVE_PATH
+#define AUTOSAVE_PATH "gas_autosave.dat"
+#endif
+#ifndef AUTOSAVE_INTERVAL
+#define AUTOSAVE_INTERVAL 5.0
+#endif
+// Journal bytes appended to an autosave before it is compacted into a fresh base
+#ifndef SAVE_JOURNAL_LIMIT
+#define SAVE_JOURNAL_LIMIT (4 << 20)
+#endif
+// Compress save sections in blocks of SAVE_BLOCK_SIZE bytes - 0 writes every section raw
+#ifndef SAVE_COMPRESSION
+#define SAVE_COMPRESSION 1
+#endif
+#ifndef SAVE_BLOCK_SIZE
+#define SAVE_BLOCK_SIZE 65536
+#endif
+// Compress the body section too - a smaller file, but bodies then decode into memory instead of loading in place
+#ifndef SAVE_COMPRESS_BODIES
+#define SAVE_COMPRESS_BODIES 0
+#endif
+// Leave fields loading can recompute, such as the positions of bodies on rails, out of compressed body sections
+#ifndef SAVE_OMIT_DERIVED
+#define SAVE_OMIT_DERIVED 1
+#endif
+// Fast multipole solver for ship mutual gravity
+#ifndef FMM_LEAF_SIZE
+#define FMM_LEAF_SIZE 64
+#endif
+// Deepest FMM tree level - leaves there keep however many masses share the box. Float positions cannot separate
+// ships much below 2^-24 of the swarm's extent, and box coordinates must fit in an int, so keep this at most 30
+#ifndef FMM_MAX_LEVELS
+#define FMM_MAX_LEVELS 24
+#endif
+#ifndef FMM_MAX_ORDER
+#define FMM_MAX_ORDER 24
+#endif
+// Measured error reduction per extra expansion term for well-separated boxes
+#ifndef FMM_CONVERGENCE_RATIO
+#define FMM_CONVERGENCE_RATIO 0.4f
+#endif
+#ifndef FMM_TOLERANCE
+#define FMM_TOLERANCE 1e-4f
+#endif
+// Below this many masses direct summation is faster than building expansions
+#ifndef FMM_DIRECT_THRESHOLD
+#define FMM_DIRECT_THRESHOLD 512
+#endif
 #ifndef HUD_FONT_SIZE
 #define HUD_FONT_SIZE 16
 #endif
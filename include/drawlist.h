@@ -0,0 +1,188 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "raylib.h"
+
+/*
+    Draw command list
+    The draw functions record typed ops here instead of calling raylib, and a backend consumes the list afterwards:
+        replayDrawList    - raylib backend, issues the ops in order (needs a window)
+        recordDrawList    - null backend, counts ops by type and hashes their parameters without touching the GPU
+        dumpDrawList      - null backend, writes one line per op
+    Ops reference textures by handle and GPU renderers by pointer, and trajectory chunks read their ship's path at replay,
+    so a list must be replayed before the ships it was recorded from change. The renderers only create GPU objects on
+    their first replay, which is what lets bench/render_bench.c record frames with no window
+    Hashes cover parameters only, never pointers or GPU object ids, so the same scene hashes the same on any machine
+    where float maths agrees
+*/
+
+typedef enum
+{
+    DRAW_OP_BEGIN_CAMERA,
+    DRAW_OP_END_CAMERA,
+    DRAW_OP_CIRCLE,
+    DRAW_OP_LINE,
+    DRAW_OP_LINE_STRIP,
+    DRAW_OP_RECTANGLE,
+    DRAW_OP_TEXTURE,
+    DRAW_OP_TEXT,
+    DRAW_OP_TRAJECTORIES_BEGIN,
+    DRAW_OP_TRAJECTORY_CHUNK,
+    DRAW_OP_TRAJECTORIES_END,
+    DRAW_OP_SHIPS,
+    DRAW_OP_GRID,
+    DRAW_OP_HUD_TEXT,
+    DRAW_OP_HUD_LAYER,
+    DRAW_OP_COUNT
+} DrawOpType;
+
+typedef enum
+{
+    DRAW_TEXT_ALIGN_LEFT,
+    DRAW_TEXT_ALIGN_CENTRE,  // x is the centre of the text
+    DRAW_TEXT_ALIGN_RIGHT    // x is the right edge of the text
+} TextAlign;
+
+struct TrajectoryRenderer;
+struct ShipRenderer;
+struct GridRenderer;
+struct HudText;
+struct HudLayer;
+
+typedef struct DrawCommand
+{
+    DrawOpType type;
+    union
+    {
+        Camera2D camera;
+        struct
+        {
+            Vector2 center;
+            float radius;
+            Color colour;
+        } circle;
+        struct
+        {
+            Vector2 start;
+            Vector2 end;
+            Color colour;
+        } line;
+        struct
+        {
+            int first; // Offset into the list's points
+            int count;
+            Color colour;
+        } lineStrip;
+        struct
+        {
+            Rectangle bounds;
+            Color colour;
+        } rectangle;
+        struct
+        {
+            Texture2D texture;
+            Rectangle source;
+            Rectangle dest;
+            Vector2 origin;
+            float rotation;
+            Color tint;
+        } texture;
+        struct
+        {
+            int offset; // Offset into the list's text, null terminated
+            int x;
+            int y;
+            int fontSize;
+            TextAlign align; // Resolved with MeasureText at replay, so recording needs no font
+            Color colour;
+        } text;
+        struct
+        {
+            struct TrajectoryRenderer *renderer;
+            float halfWidth;
+            Color colour;
+        } trajectories;
+        struct
+        {
+            struct TrajectoryRenderer *renderer;
+            int mesh;  // Ship slot in the renderer
+            int chunk;
+            int first; // First segment of the chunk
+            int segmentCount;
+            Rectangle bounds;
+        } trajectoryChunk;
+        struct
+        {
+            struct ShipRenderer *renderer;
+            int first; // Offset into the list's instances
+            int count;
+        } ships;
+        struct
+        {
+            struct GridRenderer *renderer;
+            int first; // Offset into the list's instances, one transform per tile
+            int count;
+            float halfWidth;
+            Color colour; // Band fade already applied to alpha
+        } grid;
+        struct
+        {
+            struct HudText *widget; // Drawn from the widget's cached text and width
+            int x;
+            int y;
+            int fontSize;
+            TextAlign align;
+            Color colour;
+        } hudText;
+        struct HudLayer *hudLayer;
+    };
+} drawcommand_t;
+
+typedef struct DrawList
+{
+    Vector2 screenSize; // Size of the target the list is recorded for, so recording never asks the window
+    drawcommand_t *commands;
+    int numCommands;
+    int commandCapacity;
+    Vector2 *points;
+    int numPoints;
+    int pointCapacity;
+    Matrix *instances;
+    int numInstances;
+    int instanceCapacity;
+    char *text;
+    int textSize;
+    int textCapacity;
+} drawlist_t;
+
+typedef struct DrawListStats
+{
+    int numCommands;
+    int counts[DRAW_OP_COUNT];
+    uint64_t hash; // FNV-1a over every op's type and parameters
+} drawliststats_t;
+
+drawlist_t createDrawList(void);
+void freeDrawList(drawlist_t *list);
+void clearDrawList(drawlist_t *list, Vector2 screenSize);
+const char *getDrawOpName(DrawOpType type);
+
+drawcommand_t *pushDrawCommand(drawlist_t *list, DrawOpType type);
+Vector2 *pushDrawPoints(drawlist_t *list, int count, int *first);
+Matrix *pushDrawInstances(drawlist_t *list, int count, int *first);
+void drawListBeginCamera(drawlist_t *list, Camera2D camera);
+void drawListEndCamera(drawlist_t *list);
+void drawListCircle(drawlist_t *list, Vector2 center, float radius, Color colour);
+void drawListLine(drawlist_t *list, Vector2 start, Vector2 end, Color colour);
+void drawListLineStrip(drawlist_t *list, const Vector2 *points, int count, Color colour);
+void drawListRectangle(drawlist_t *list, Rectangle bounds, Color colour);
+void drawListTexture(drawlist_t *list, Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint);
+void drawListText(drawlist_t *list, const char *text, int x, int y, int fontSize, TextAlign align, Color colour);
+
+void replayDrawList(drawlist_t *list);
+drawliststats_t recordDrawList(drawlist_t *list);
+void dumpDrawList(drawlist_t *list, FILE *file);
+
+#endif
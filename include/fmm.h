@@ -0,0 +1,79 @@
+#ifndef FMM_H
+#define FMM_H
+
+#include <complex.h>
+#include <stdint.h>
+#include "config.h"
+#include "raylib.h"
+
+/*
+    2D Fast Multipole Method for mutual gravity between many small masses (ships, debris)
+    The game's 1/r^2 force comes from a 1/|z| potential, which is expanded as a double power series in z and conj(z):
+        1/|z - w| = |z|^-1 * sum_jk c_j c_k (w/z)^j (conj(w)/conj(z))^k,   c_j = (2j choose j) / 4^j
+    Expansions are truncated at order p in each variable - error falls roughly as FMM_CONVERGENCE_RATIO^p
+    The quadtree is adaptive - boxes split until they hold FMM_LEAF_SIZE particles or reach FMM_MAX_LEVELS, so
+    clustered swarms get deep leaves only where they are dense. Leaves of different sizes interact through the usual
+    adaptive lists: touching leaves directly, same-level well-separated boxes by M2L, and smaller boxes next to a leaf
+    through their multipole at the leaf's particles and the leaf's particles into their local expansion
+*/
+
+typedef struct FmmNode
+{
+    int level;
+    int ix, iy;        // Box position on its level - level l is 2^l boxes across
+    int first, count;  // Range of sorted particles inside the box
+    int parent;
+    int children[4];   // -1 for empty quadrants, all -1 for a leaf
+    int colleagues[9]; // Non-empty boxes on the same level touching this one, itself included
+    int numColleagues;
+    bool leaf;
+} fmmnode_t;
+
+typedef struct FmmSolver
+{
+    int order;          // Expansion terms per variable (p)
+    int levels;         // Deepest level of the current tree
+    int numParticles;
+    int allocatedParticles;
+    int numNodes;
+    int allocatedNodes;
+    int allocatedExpansions;
+    fmmnode_t *nodes;             // Adaptive quadtree in breadth-first order, so parents precede children
+    double complex *multipoles;   // p*p coefficients per node, in units of the node's box size
+    double complex *locals;       // p*p coefficients per node, in units of the node's box size
+    double complex *m2lOperators; // M2L operator U for each of the 7x7 box offsets
+    double *m2lInvDistance;       // 1/|z0| for each box offset, in box units
+    double *binomials;            // (2p) x (2p) Pascal table
+    double *kernelCoeffs;         // c_j
+    double *shiftCoeffs;          // p x p table of (-(j + 1/2) choose l)
+    double *halfPowers;           // 2^-n, for re-scaling expansions between a box and its children
+    uint64_t *keys;               // Morton key of each particle's box at FMM_MAX_LEVELS, in sorted order
+    uint64_t *keyScratch;
+    int *particleOrder;           // Particle indices sorted by key
+    int *orderScratch;
+    double complex *sorted;       // Normalised particle positions in key order
+    double *sortedMass;
+    double complex *field;        // Acceleration from direct sums and multipoles per sorted particle
+    Vector2 *positions;           // Input and output buffers for callers gathering from their own structures
+    float *masses;
+    Vector2 *accelerations;
+    int allocatedInputs;
+} fmmsolver_t;
+
+typedef struct FmmAccuracy
+{
+    float rmsError; // RMS of |a_fmm - a_direct| / |a_direct|
+    float maxError;
+    double fmmSeconds;
+    double directSeconds;
+} fmmaccuracy_t;
+
+fmmsolver_t *createFmmSolver(int order);
+void freeFmmSolver(fmmsolver_t *solver);
+bool reserveFmmInputs(fmmsolver_t *solver, int count);
+int fmmOrderForTolerance(float tolerance);
+bool solveFmmGravity(fmmsolver_t *solver, const Vector2 *positions, const float *masses, int count, Vector2 *accelerations);
+void solveDirectGravity(const Vector2 *positions, const float *masses, int count, Vector2 *accelerations);
+fmmaccuracy_t compareFmmToDirect(fmmsolver_t *solver, const Vector2 *positions, const float *masses, int count);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <raylib.h>
 #include "physics.h"
 
@@ -57,6 +59,9 @@ typedef struct GameState {
     celestialbody_t **bodies;
     int numShips;
     ship_t **ships;
+    void *saveMapping; // Loaded save the bodies are used from in place, NULL when they were allocated
+    size_t saveMappingSize;
+    uint64_t *dirtyShips; // Bit per ship changed since the last journal entry, set through markShipDirty and sized by resetSaveJournal
 } gamestate_t;
 
 // typedef enum
@@ -82,8 +87,6 @@ typedef struct GameState {
 //     int quantity;   // Amount available on the CelestialBody
 // } InventoryResource;
 
-void saveGame(char* filename, gamestate_t* state);
-bool loadGame(char* filename, gamestate_t* state);
 void initNewGame(gamestate_t* gameState);
 void incrementWarp(WarpController *timeScale, float dt);
 void decrementWarp(WarpController *timeScale, float dt);
@@ -0,0 +1,34 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "game.h"
+#include "drawlist.h"
+
+/*
+    Celestial grid
+    Every zoom band uses the same tile - GRID_TILE_CELLS x GRID_TILE_CELLS cells of unit size, built once as a mesh of
+    line quads - scaled to the band's spacing by a per-tile transform. A frame records the range of tiles covering the
+    view and draws it with one instanced call per band, so the cost no longer depends on how many lines are visible
+    Near a band's limits the neighbouring band is drawn too and faded by zoom, instead of switching spacing in one step
+*/
+
+#define GRID_BAND_COUNT 5
+
+typedef struct GridRenderer
+{
+    bool loaded; // Shader, material and tile are created on first replay
+    Shader shader;
+    int halfWidthLoc;
+    Material material;
+    Mesh tile;
+} gridrenderer_t;
+
+gridrenderer_t *createGridRenderer(void);
+void freeGridRenderer(gridrenderer_t *renderer);
+void drawCelestialGrid(drawlist_t *list, gridrenderer_t *renderer, Camera2D camera, Rectangle view, float density, ColourScheme *colourScheme);
+void replayGrid(gridrenderer_t *renderer, const Matrix *tiles, int count, float halfWidth, Color colour);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+/*
+    Seeded 3D simplex noise and fractal Brownian motion
+    Evaluated NOISE_LANES points at a time with GCC vector extensions, which compile to SSE on x86 and NEON on ARM
+    without any target flags. Lattice gradients come from an integer hash of the cell and the seed rather than a
+    permutation table, so every seed is a different field and the hash vectorises along with the rest
+    Noise is in roughly [-1, 1], fBm is normalised back into the same range whatever the octave count
+*/
+
+#define NOISE_LANES 4
+
+void simplexNoise(const float *x, const float *y, const float *z, int count, uint32_t seed, float *out);
+void fbmNoise(const float *x, const float *y, const float *z, int count, uint32_t seed, int octaves, float lacunarity,
+              float gain, float *out);
+
+#endif
@@ -8,24 +8,28 @@
 #include "body.h"
 #include "ship.h"
 
+// Forward declarations
+typedef struct FmmSolver fmmsolver_t;
+
 float calculateOrbitalVelocity(float mass, float radius);
 float calculateOrbitCircumference(float r);
 float calculateEscapeVelocity(float mass, float radius);
 float calculateDistance(Vector2 *pos1, Vector2 *pos2);
 float calculateOrbitalRadius(float period, float mStar);
-float calculateRelativeSpeed(ship_t *ship, celestialbody_t *body, float gameTime);
+float calculateRelativeSpeed(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime);
 float calculateOrbitalSpeed(float mass, float radius);
 void updateShipPositions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float dt);
 void updateCelestialPositions(celestialbody_t **bodies, int numBodies, float time);
-void updateLandedShipPosition(ship_t **ships, int numShips, float gameTime);
+void updateLandedShipPosition(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime);
 void detectCollisions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime);
 Vector2 computeShipGravity(ship_t *ship, celestialbody_t **bodies, int numBodies);
-void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime);
-void landShip(ship_t *ship, celestialbody_t *body, float gameTime);
+void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime, int steps, float stepTime);
+void landShip(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime);
 bool detectShipBodyCollision(ship_t *ship, celestialbody_t *body);
 bool detectShipAtmosphereCollision(ship_t *ship, celestialbody_t *body);
 Vector2 calculateDragForce(ship_t *ship, celestialbody_t **bodies, int numBodies);
-Vector2 calculateBodyVelocity(celestialbody_t *body, float gameTime);
-void initStableOrbit(ship_t *ship, celestialbody_t *body, float gameTime);
+Vector2 calculateBodyVelocity(celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime);
+void initStableOrbit(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime);
+void applyShipMutualGravity(ship_t **ships, int numShips, fmmsolver_t *solver, float dt);
 
 #endif
\ No newline at end of file
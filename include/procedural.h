@@ -0,0 +1,35 @@
+#ifndef PROCEDURAL_H
+#define PROCEDURAL_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "config.h"
+#include "body.h"
+
+/*
+    Procedural body surfaces
+    A body whose textureId is TEXTURE_PROCEDURAL gets a disc generated from fBm noise sampled over the visible hemisphere
+    of a sphere, so features curve towards the limb, then coloured through a ramp chosen by body type and seed.
+    Generation runs on the asset workers as a generated texture, and each result is written to PLANET_CACHE_DIR keyed on
+    a hash of its parameters, so a surface is only ever generated once per machine
+*/
+
+typedef struct PlanetSurface
+{
+    uint32_t seed;
+    CelestialType type;
+    int size; // Texture width and height in pixels
+    int octaves;
+    float frequency; // Noise features across the disc at the first octave
+    float lacunarity;
+    float gain;
+} planetsurface_t;
+
+planetsurface_t getDefaultPlanetSurface(CelestialType type, uint32_t seed);
+Image generatePlanetSurface(const planetsurface_t *surface);
+Image loadPlanetSurface(const planetsurface_t *surface);
+int registerPlanetSurface(const planetsurface_t *surface);
+int getProceduralSurface(int index, const celestialbody_t *body);
+void freeProceduralSurfaces(void);
+
+#endif
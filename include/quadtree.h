@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include "raylib.h"
+#include "raymath.h"
+#include "config.h"
 #include "body.h"
 
 typedef struct QuadTreeNode
@@ -10,167 +12,25 @@ typedef struct QuadTreeNode
     Rectangle bounds;                 // 2D region (x, y, width, height)
     Vector2 centerOfMass;             // Center of mass of all bodies in this node
     float totalMass;                  // Total mass of bodies in this node
+    float quadXX;                     // Traceless quadrupole moment about centerOfMass
+    float quadXY;                     // Sum of m * (3 * dx * dy)
+    float quadYY;                     // Sum of m * (3 * dy * dy - |d|^2)
+    float maxMass;                    // Heaviest single body in this node - bounds dominant body searches
+    float maxRadius;                  // Largest body radius in this node - bounds nearest body searches
     struct QuadTreeNode *children[4]; // NW, NE, SW, SE quadrants
-    CelestialBody *body;              // Pointer to body if leaf node; NULL otherwise
+    celestialbody_t *body;            // Pointer to body if leaf node; NULL otherwise
+    celestialbody_t **extraBodies;    // Bodies sharing a leaf too small to split (e.g. identical positions)
+    int numExtraBodies;
 } QuadTreeNode;
 
-void drawQuadtree(QuadTreeNode *node)
-{
-    if (node == NULL)
-        return;
-    DrawRectangleLines((int)node->bounds.x, (int)node->bounds.y,
-                       (int)node->bounds.width, (int)node->bounds.height, DARKGRAY);
-
-    for (int i = 0; i < 4; i++)
-    {
-        if (node->children[i] != NULL)
-        {
-            drawQuadtree(node->children[i]);
-        }
-    }
-}
-
-QuadTreeNode *createNode(Rectangle bounds)
-{
-    QuadTreeNode *node = (QuadTreeNode *)malloc(sizeof(QuadTreeNode));
-    node->bounds = bounds;
-    node->centerOfMass = (Vector2){0, 0};
-    node->totalMass = 0.0f;
-    for (int i = 0; i < 4; i++)
-        node->children[i] = NULL;
-    node->body = NULL;
-    return node;
-}
-
-void subdivide(QuadTreeNode *node)
-{
-    float x = node->bounds.x;
-    float y = node->bounds.y;
-    float w = node->bounds.width / 2;
-    float h = node->bounds.height / 2;
-    node->children[0] = createNode((Rectangle){x, y, w, h});         // NW
-    node->children[1] = createNode((Rectangle){x + w, y, w, h});     // NE
-    node->children[2] = createNode((Rectangle){x, y + h, w, h});     // SW
-    node->children[3] = createNode((Rectangle){x + w, y + h, w, h}); // SE
-}
-
-void insertBody(QuadTreeNode *node, CelestialBody *body)
-{
-    if (node->body != NULL)
-    { // Leaf with a body
-        CelestialBody *existingBody = node->body;
-        subdivide(node);
-        // Insert existing body into appropriate child
-        int index = (existingBody->position.x < node->bounds.x + node->bounds.width / 2) ? (existingBody->position.y < node->bounds.y + node->bounds.height / 2 ? 0 : 2) : (existingBody->position.y < node->bounds.y + node->bounds.height / 2 ? 1 : 3);
-        insertBody(node->children[index], existingBody);
-        node->body = NULL;
-    }
-    if (node->children[0] == NULL)
-    { // Leaf node
-        node->body = body;
-        node->totalMass = body->mass;
-        node->centerOfMass = body->position;
-    }
-    else
-    { // Internal node
-        int index = (body->position.x < node->bounds.x + node->bounds.width / 2) ? (body->position.y < node->bounds.y + node->bounds.height / 2 ? 0 : 2) : (body->position.y < node->bounds.y + node->bounds.height / 2 ? 1 : 3);
-        insertBody(node->children[index], body);
-        // Update totalMass and centerOfMass
-        node->totalMass = 0;
-        node->centerOfMass = (Vector2){0, 0};
-        for (int i = 0; i < 4; i++)
-        {
-            if (node->children[i])
-            {
-                node->totalMass += node->children[i]->totalMass;
-                node->centerOfMass = Vector2Add(node->centerOfMass,
-                                                Vector2Scale(node->children[i]->centerOfMass, node->children[i]->totalMass));
-            }
-        }
-        if (node->totalMass > 0)
-        {
-            node->centerOfMass = Vector2Scale(node->centerOfMass, 1.0f / node->totalMass);
-        }
-    }
-}
-
-QuadTreeNode *buildQuadTree(CelestialBody **bodies, int numBodies)
-{
-    if (numBodies == 0)
-    {
-        printf("No bodies");
-        return NULL;
-    }
-
-    float minX = bodies[0]->position.x, maxX = minX;
-    float minY = bodies[0]->position.y, maxY = minY;
-
-    for (int i = 1; i < numBodies; i++)
-    {
-        minX = fmin(minX, bodies[i]->position.x);
-        maxX = fmax(maxX, bodies[i]->position.x);
-        minY = fmin(minY, bodies[i]->position.y);
-        maxY = fmax(maxY, bodies[i]->position.y);
-    }
-    float width = maxX - minX, height = maxY - minY;
-    if (width > height)
-        minY -= (width - height) / 2;
-    else
-        minX -= (height - width) / 2;
-    Rectangle bounds = {minX, minY, fmax(width, height), fmax(width, height)};
-    QuadTreeNode *root = createNode(bounds);
-    for (int i = 0; i < numBodies; i++)
-    {
-        insertBody(root, bodies[i]);
-    }
-    return root;
-}
-
-Vector2 computeForce(QuadTreeNode *node, CelestialBody *body, float theta)
-{
-    if (node->totalMass == 0)
-        return (Vector2){0, 0};
-    if (node->body != NULL)
-    {
-        if (node->body == body)
-            return (Vector2){0, 0}; // Skip self
-        Vector2 dir = Vector2Subtract(node->body->position, body->position);
-        float dist = Vector2Length(dir);
-        if (dist < 1e-5)
-            return (Vector2){0, 0}; // Avoid division by zero
-        float mag = (G * body->mass * node->body->mass) / (dist * dist);
-        return Vector2Scale(Vector2Normalize(dir), mag);
-    }
-    float dist = Vector2Distance(body->position, node->centerOfMass);
-    if (dist < 1e-5)
-        dist = 1e-5; // Prevent singularity
-    float size = node->bounds.width;
-    if (size / dist < theta)
-    { // Approximate as point mass
-        float mag = (G * body->mass * node->totalMass) / (dist * dist);
-        Vector2 dir = Vector2Normalize(Vector2Subtract(node->centerOfMass, body->position));
-        return Vector2Scale(dir, mag);
-    }
-    Vector2 force = {0, 0};
-    for (int i = 0; i < 4; i++)
-    {
-        if (node->children[i])
-        {
-            force = Vector2Add(force, computeForce(node->children[i], body, theta));
-        }
-    }
-    return force;
-}
-
-void freeQuadTree(QuadTreeNode *node)
-{
-    if (!node)
-        return;
-    for (int i = 0; i < 4; i++)
-    {
-        freeQuadTree(node->children[i]);
-    }
-    free(node);
-}
-
-#endif
\ No newline at end of file
+void drawQuadtree(QuadTreeNode *node);
+void insertBody(QuadTreeNode *node, celestialbody_t *body);
+QuadTreeNode *buildQuadTree(celestialbody_t **bodies, int numBodies);
+void refitQuadTree(QuadTreeNode *node);
+Vector2 computeQuadTreeAcceleration(QuadTreeNode *node, Vector2 position, celestialbody_t *self, float theta);
+Vector2 computeForce(QuadTreeNode *node, celestialbody_t *body, float theta);
+int findNearestBodies(QuadTreeNode *root, Vector2 position, int k, celestialbody_t **nearest, float *distances);
+celestialbody_t *findDominantBody(QuadTreeNode *root, Vector2 position, celestialbody_t *hint);
+void freeQuadTree(QuadTreeNode *node);
+
+#endif
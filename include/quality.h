@@ -0,0 +1,65 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "config.h"
+#include "drawlist.h"
+
+/*
+    Adaptive quality governor
+    The render thread times the subsystems it records each frame, and the sim thread reports what each tick spent
+    predicting trajectories and solving mutual gravity. Every QUALITY_ADJUST_FRAMES frames the governor compares the
+    smoothed costs against two budgets - render work against the target frame time, tick work against the tick period -
+    and moves one knob by one level: down for the costliest subsystem when over budget, back up for the cheapest lowered
+    one when there is QUALITY_RAISE_HEADROOM to spare. Knobs are plain settings the subsystems read every frame or tick,
+    so with the governor switched off they stay wherever they were last set
+*/
+
+#define QUALITY_LEVELS 4 // Level 0 is full quality
+
+typedef enum
+{
+    QUALITY_KNOB_GRID,       // Grid line density
+    QUALITY_KNOB_ORBITS,     // Orbit ring chord tolerance
+    QUALITY_KNOB_SHIP_ICONS, // Zoom at which ships switch to icons
+    QUALITY_KNOB_TRAJECTORY, // Prediction horizon and step - sim thread
+    QUALITY_KNOB_GRAVITY,    // Mutual gravity expansion tolerance - sim thread
+    QUALITY_KNOB_COUNT
+} QualityKnob;
+
+typedef struct QualitySettings
+{
+    float gridDensity;        // 1 draws the finest band the zoom allows, lower switches to coarser bands sooner
+    float orbitTolerance;     // Maximum orbit chord error in screen pixels
+    float shipIconZoom;       // Camera zoom at or below which ships are drawn as icons
+    int trajectorySteps;      // Prediction steps, the rest of a ship's path holds the last position
+    float trajectoryStepTime; // Game seconds per prediction step
+    float gravityTolerance;   // FMM tolerance, sets the expansion order
+} qualitysettings_t;
+
+typedef struct QualityGovernor
+{
+    bool enabled;
+    bool overlay;
+    float frameBudget; // Seconds of render work per frame
+    float tickBudget;  // Seconds of sim work per tick
+    int levels[QUALITY_KNOB_COUNT];
+    float costs[QUALITY_KNOB_COUNT]; // Smoothed seconds per frame or tick spent in each knob's subsystem
+    float frameCost;                 // Smoothed render work per frame
+    float tickCost;                  // Smoothed sim work per tick
+    int framesSinceAdjust;
+    bool changed[QUALITY_KNOB_COUNT]; // Level moved and not yet passed on - cleared by whoever applies it elsewhere
+    qualitysettings_t settings;
+} qualitygovernor_t;
+
+qualitysettings_t getDefaultQualitySettings(void);
+void applyQualityLevel(qualitysettings_t *settings, QualityKnob knob, int level);
+const char *getQualityKnobName(QualityKnob knob);
+void initQualityGovernor(qualitygovernor_t *governor, int targetFPS, int tickRate);
+void setQualityLevel(qualitygovernor_t *governor, QualityKnob knob, int level);
+void reportQualityCost(qualitygovernor_t *governor, QualityKnob knob, float seconds);
+void updateQualityGovernor(qualitygovernor_t *governor, float frameSeconds, float tickSeconds);
+void drawQualityOverlay(drawlist_t *list, qualitygovernor_t *governor);
+
+#endif
@@ -6,15 +6,25 @@
 #include "body.h"
 #include "ship.h"
 #include "ui.h"
+#include "spatial.h"
+#include "drawlist.h"
 
-void drawBodies(celestialbody_t **bodies, int numBodies);
-void drawShips(ship_t **ships, int numShips, Camera2D *camera, Texture2D *shipLogoTexture);
-void drawOrbits(celestialbody_t **bodies, int numBodies, ColourScheme *colourScheme);
-void drawTrajectories(ship_t **ships, int numShips, ColourScheme *colourScheme);
-void drawStaticGrid(float zoomLevel, int numQuadrants, ColourScheme *colourScheme);
-void drawCelestialGrid(celestialbody_t **bodies, int numBodies, Camera2D camera, ColourScheme *colourScheme);
-void drawPlayerStats(PlayerStats *playerStats);
-void drawPlayerHUD(HUD *playerHUD);
+typedef struct RenderView
+{
+    Rectangle bounds;       // Camera's world-space view, computed once per frame
+    spatialquery_t visible; // Bodies and ships overlapping bounds, sorted by type then index
+    float zoom;             // Camera zoom the view was culled at
+} renderview_t;
+
+renderview_t createRenderView(void);
+void freeRenderView(renderview_t *view);
+void cullRenderView(renderview_t *view, spatialindex_t *index, Camera2D camera, Vector2 screenSize);
+void drawBodies(drawlist_t *list, celestialbody_t **bodies, int numBodies, renderview_t *view);
+void drawOrbits(drawlist_t *list, celestialbody_t **bodies, int numBodies, renderview_t *view, Camera2D *camera, float tolerance, ColourScheme *colourScheme);
+void freeOrbitCache(void);
+void drawStaticGrid(drawlist_t *list, float zoomLevel, int numQuadrants, ColourScheme *colourScheme);
+void drawPlayerStats(drawlist_t *list, PlayerStats *playerStats);
+void drawPlayerHUD(drawlist_t *list, HUD *playerHUD);
 // void drawPlayerInventory(ship_t *playerShip, Resource *resourceDefinitions);
 
 #endif
\ No newline at end of file
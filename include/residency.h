@@ -0,0 +1,27 @@
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "raylib.h"
+#include "config.h"
+#include "textures.h"
+
+/*
+    Texture residency
+    Body textures are only worth GPU memory while their body is on screen at a useful size. Drawing asks for a texture
+    with useResidentTexture, which stamps it with the current frame and streams it in through the texture cache the first
+    time - until the upload lands the caller draws its untextured fallback, so nothing waits on a load. At the end of the
+    frame trimTextureResidency releases the least recently used textures until the resident bytes fit the budget. A
+    texture used this frame is never released, so the budget is a ceiling on everything but the current frame's needs
+    Only TEXTURE_RESIDENCY_MAX_PENDING requests are in flight at once, so a screen full of new bodies cannot fill the
+    loader, and a texture that fails to load gives up its reference and is asked for again after a growing backoff
+*/
+
+bool useResidentTexture(int id, Texture2D *texture);
+void trimTextureResidency(size_t budgetBytes);
+size_t getResidentTextureBytes(void);
+int getResidentTextureCount(void);
+void releaseTextureResidency(void);
+
+#endif
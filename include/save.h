@@ -0,0 +1,204 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "game.h"
+#include "body.h"
+#include "ship.h"
+
+/*
+    Save file format
+    A header with the magic number and version, then a table locating each section, then the sections themselves, each
+    aligned to SAVE_ALIGNMENT. Bodies are stored as the celestialbody_t records the game runs on - fixed size, names
+    inline and parents as indices - so loading maps the file and uses the body section in place, with only the header
+    and section table read up front and body pages faulted in as they are first touched. Ships are few and hold
+    pointers, so they are packed records unpacked on load. Every section records its record size, so a loader can
+    skip sections it does not know. Files are little-endian, as written by every platform the game builds for
+
+    With SAVE_COMPRESSION a section is instead a run of blocks, each holding whole records byte-shuffled - byte 0 of
+    every record, then byte 1 - so matching fields line up, then compressed (or kept as they are if that came out no
+    smaller). Blocks are encoded one at a time into a small buffer, so the compressed file is never whole in memory.
+    The body section stays raw and aligned unless SAVE_COMPRESS_BODIES is set, so loading still uses it in place.
+    Compressed sections decode into memory on load, and a compressed body section may leave out fields loading can
+    recompute, flagged in the header
+
+    Saving is split so the game never waits on the disk: captureSave lays the whole file out in memory, copying the body
+    store a block at a time, and runs on the simulation thread between ticks. A save writer thread then writes the
+    image to a temporary file, syncs it and renames it over the old save, so a crash leaves either the old save or the
+    new one. The writer keeps two images and reuses their memory, so one can be captured while the other is written
+
+    Autosaves are journaled: after one full base, each autosave appends an entry holding the game time and only the
+    ships that changed since the last, so its cost follows what changed rather than the size of the universe. The
+    simulation flags ships with markShipDirty as it changes them, and only flagged ships are packed and compared against
+    their last journaled records - landed ships stay clean while they ride their body, as loading puts them back on it,
+    so anything else that edits a ship has to flag it. Bodies are not journaled - nothing changes them during play except moving
+    along their orbits, which loading recomputes from the game time - so anything that starts editing bodies has to
+    add them to the journal or force a new base. Each entry carries a checksum, so one torn by a crash is dropped on
+    load along with anything after it. Once the journal passes SAVE_JOURNAL_LIMIT bytes the writer thread compacts it,
+    loading base and journal together and saving the result as a fresh base
+*/
+
+#define SAVE_MAGIC 0x56534147 // "GASV" in a little-endian file
+#define SAVE_JOURNAL_MAGIC 0x4A534147 // "GASJ"
+#define SAVE_VERSION 3
+#define SAVE_MAX_SECTIONS 16
+#define SAVE_ALIGNMENT 8
+#define SAVE_PATH_CAPACITY 256
+
+typedef enum
+{
+    SAVE_SECTION_STATE = 1, // One savedstate_t
+    SAVE_SECTION_BODIES,    // celestialbody_t per body
+    SAVE_SECTION_SHIPS      // savedship_t per ship
+} SaveSection;
+
+typedef enum
+{
+    SAVE_ENCODING_RAW,   // count records back to back
+    SAVE_ENCODING_BLOCKS // saveblockheader_t then its bytes, until count records
+} SaveEncoding;
+
+#define SAVE_FLAG_DERIVED_OMITTED 1u // Positions of bodies on rails are zeroed, recompute them from the game time
+
+typedef struct SaveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numSections;
+    uint32_t flags; // SAVE_FLAG_* bits
+} saveheader_t;
+
+typedef struct SaveSectionEntry
+{
+    uint32_t type;
+    uint32_t recordSize; // Bytes per record, 1 for byte sections
+    uint64_t offset;     // From the start of the file
+    uint64_t count;      // Records in the section
+    uint64_t storedSize; // Bytes the section takes in the file
+    uint32_t encoding;   // SaveEncoding
+    uint32_t reserved;
+} savesectionentry_t;
+
+typedef struct SaveBlockHeader
+{
+    uint32_t rawSize;    // Whole records
+    uint32_t storedSize; // Equal to rawSize when the block is stored uncompressed
+} saveblockheader_t;
+
+typedef struct SavedState
+{
+    float gameTime;
+    uint32_t reserved;
+} savedstate_t;
+
+typedef struct SavedShip
+{
+    Vector2 position;
+    Vector2 velocity;
+    Vector2 landingPosition;
+    float mass;
+    float rotation;
+    float rotationSpeed;
+    float radius;
+    float thrust;
+    float throttle;
+    float thrusterForce;
+    float fuel;
+    float fuelConsumption;
+    float textureScale;
+    int32_t state;
+    int32_t type;
+    int32_t landedIndex;
+    int32_t trajectorySize;
+    int32_t textureIds[8]; // Base, engine, thrusters up, down, right, left, rotate right, rotate left
+    uint32_t flags;        // SAVED_SHIP_* bits
+} savedship_t;
+
+#define SAVED_SHIP_SELECTED 1u
+#define SAVED_SHIP_DRAW_TRAJECTORY 2u
+
+typedef struct SaveJournalHeader
+{
+    uint32_t magic;
+    uint32_t payloadSize; // Bytes of changes after this header
+    uint32_t checksum;    // FNV-1a of the payload
+    uint32_t numShips;    // savedshipchange_t records
+    float gameTime;
+} savejournalheader_t;
+
+typedef struct SavedShipChange
+{
+    uint32_t index;
+    savedship_t ship;
+} savedshipchange_t;
+
+typedef struct SaveJournal
+{
+    // The simulation's side of the journal - what the last entry left the save holding
+    savedship_t *ships;
+    int numShips;
+    int numBodies;
+} savejournal_t;
+
+typedef enum
+{
+    SAVE_WRITE_FULL,   // A whole save on its own
+    SAVE_WRITE_BASE,   // A whole save that journal entries follow
+    SAVE_WRITE_JOURNAL // An entry appended to the last base
+} SaveWriteKind;
+
+typedef struct SaveImage
+{
+    unsigned char *data; // The whole file with raw sections - writeSaveImage compresses as it writes
+    size_t size;
+    size_t capacity;
+    char filename[SAVE_PATH_CAPACITY];
+    SaveWriteKind kind;
+    double captureSeconds; // Time the capture spent on the simulation thread
+} saveimage_t;
+
+typedef enum
+{
+    SAVE_IMAGE_FREE,
+    SAVE_IMAGE_CAPTURING,
+    SAVE_IMAGE_PENDING,
+    SAVE_IMAGE_WRITING
+} SaveImageState;
+
+typedef struct SaveWriter
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+    saveimage_t images[2];
+    SaveImageState states[2];
+    unsigned long long submitted[2]; // Submission order, so pending images are written oldest first
+    unsigned long long submissions;
+    bool needsBase; // No base to journal onto - set at start and whenever a base or entry fails
+    // Only touched by the writer thread
+    char journalTarget[SAVE_PATH_CAPACITY]; // The base journal entries go to, empty for none
+    size_t journalBytes;                    // Appended to it since it was written
+} savewriter_t;
+
+bool captureSave(gamestate_t *state, const char *filename, saveimage_t *image);
+bool captureSaveJournal(gamestate_t *state, savejournal_t *journal, const char *filename, saveimage_t *image);
+void resetSaveJournal(gamestate_t *state, savejournal_t *journal);
+void freeSaveJournal(savejournal_t *journal);
+bool writeSaveImage(const saveimage_t *image);
+bool compactSave(const char *filename);
+bool saveGame(const char *filename, gamestate_t *state);
+bool loadGame(const char *filename, gamestate_t *state);
+void unloadGame(gamestate_t *state);
+const char *getNewestSave(const char *first, const char *second);
+
+savewriter_t *createSaveWriter(void);
+saveimage_t *acquireSaveImage(savewriter_t *writer);
+void submitSaveImage(savewriter_t *writer, saveimage_t *image);
+bool takeSaveBaseRequest(savewriter_t *writer);
+void freeSaveWriter(savewriter_t *writer);
+
+#endif
@@ -61,6 +61,7 @@ typedef struct Ship
     bool drawTrajectory;
     int trajectorySize;
     Vector2 *futurePositions;
+    unsigned int trajectoryRevision; // Changes whenever futurePositions is recalculated
     bool mainEnginesOn;
     bool thrusterUp;
     bool thrusterDown;
@@ -76,19 +77,10 @@ typedef struct Ship
     int thrusterLeftTextureId;
     int thrusterRotateRightTextureId;
     int thrusterRotateLeftTextureId;
-    float textureScale;
-    Texture2D baseTexture;
-    Texture2D engineTexture;
-    Texture2D thrusterUpTexture;
-    Texture2D thrusterDownTexture;
-    Texture2D thrusterRightTexture;
-    Texture2D thrusterLeftTexture;
-    Texture2D thrusterRotateRightTexture;
-    Texture2D thrusterRotateLeftTexture;
+    float textureScale; // Sprite layers are drawn from the sprite atlas by id
 } ship_t;
 
 ship_t **initShips(int *numShips);
-bool saveShip(ship_t *ship, FILE *file, gamestate_t *state);
 void freeShip(ship_t* ship);
 void freeShips(ship_t **ships, int numShips);
 void takeoffShip(ship_t *ship);
@@ -98,5 +90,6 @@ void handleRotation(ship_t **ships, int numShips, float dt, ShipMovement directi
 void cutEngines(ship_t **ships, int numShips);
 void toggleDrawTrajectory(ship_t **ships, int numShips);
 void updateShipTextureFlags(ship_t **ships, int numShips);
+void markShipDirty(gamestate_t *state, int index);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef SHIPRENDERER_H
+#define SHIPRENDERER_H
+
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "ship.h"
+#include "textures.h"
+#include "rendering.h"
+
+/*
+    Instanced ship rendering
+    Every visible ship becomes one instance of a unit quad in the draw list, and the whole fleet goes out in a single
+    DrawMeshInstanced call when the list is replayed. The per-instance matrix is not a transform - its 16 floats carry
+    the ship's pose, sprite ids and a bitmask of active thrusters, and the fragment shader composites the active layers
+    from the sprite atlas itself
+    At or below iconZoom (SHIP_ICON_ZOOM at full quality) a ship's instance switches to the logo icon, sized to stay readable on screen
+*/
+
+#define SHIP_SPRITE_SLOTS 32 // Sprite regions the shader can address
+#define SHIP_LAYER_COUNT 7   // Overlay layers after the base sprite, in the order of ShipLayer
+
+typedef enum
+{
+    SHIP_LAYER_ENGINE,
+    SHIP_LAYER_THRUSTER_UP,
+    SHIP_LAYER_THRUSTER_DOWN,
+    SHIP_LAYER_THRUSTER_RIGHT,
+    SHIP_LAYER_THRUSTER_LEFT,
+    SHIP_LAYER_ROTATE_RIGHT,
+    SHIP_LAYER_ROTATE_LEFT
+} ShipLayer;
+
+typedef struct ShipRenderer
+{
+    bool loaded;              // Shader, material and quad are created on first replay
+    Shader shader;
+    Material material;
+    Texture2D defaultTexture; // Material's own diffuse map, restored before unloading so the atlas is not freed
+    Mesh quad;
+} shiprenderer_t;
+
+shiprenderer_t *createShipRenderer(void);
+void freeShipRenderer(shiprenderer_t *renderer);
+void drawShips(drawlist_t *list, shiprenderer_t *renderer, ship_t **ships, int numShips, Camera2D *camera, renderview_t *view, float iconZoom);
+void replayShips(shiprenderer_t *renderer, const Matrix *instances, int count);
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "config.h"
+#include "game.h"
+#include "body.h"
+#include "ship.h"
+#include "quadtree.h"
+#include "quality.h"
+#include "save.h"
+
+/*
+    Simulation thread
+    The sim thread owns the game state and steps it at SIM_TICK_RATE. After every tick it publishes an immutable
+    snapshot (copies of every body and ship plus their previous poses) into a lock-free triple buffer, so the render
+    thread can always take the newest complete snapshot without waiting and interpolate between its two poses
+    Input flows the other way - held keys as an atomic bitmask, discrete actions through a single producer/single
+    consumer command queue
+*/
+
+#define SIM_SNAPSHOT_FRESH 4 // Set on latestSnapshot when the writer has published since the reader last took one
+
+typedef enum
+{
+    SIM_INPUT_THROTTLE_UP = 1 << 0,
+    SIM_INPUT_THROTTLE_DOWN = 1 << 1,
+    SIM_INPUT_ROTATE_RIGHT = 1 << 2,
+    SIM_INPUT_ROTATE_LEFT = 1 << 3,
+    SIM_INPUT_THRUSTER_RIGHT = 1 << 4,
+    SIM_INPUT_THRUSTER_LEFT = 1 << 5,
+    SIM_INPUT_THRUSTER_UP = 1 << 6,
+    SIM_INPUT_THRUSTER_DOWN = 1 << 7,
+    SIM_INPUT_CUT_ENGINES = 1 << 8,
+    SIM_INPUT_WARP_UP = 1 << 9,
+    SIM_INPUT_WARP_DOWN = 1 << 10
+} SimInput;
+
+typedef enum
+{
+    SIM_COMMAND_PAUSE,
+    SIM_COMMAND_RESUME,
+    SIM_COMMAND_SAVE,
+    SIM_COMMAND_TOGGLE_TRAJECTORY,
+    SIM_COMMAND_TOGGLE_MUTUAL_GRAVITY,
+    SIM_COMMAND_SELECT_SHIP,   // value = ship index
+    SIM_COMMAND_VELOCITY_LOCK, // value = body index or VELOCITY_LOCK_AUTO
+    SIM_COMMAND_CYCLE_VELOCITY_LOCK, // Next of the bodies nearest the selected ship, then back to auto
+    SIM_COMMAND_TRAJECTORY_QUALITY, // value = quality level
+    SIM_COMMAND_GRAVITY_QUALITY     // value = quality level
+} SimCommandType;
+
+typedef struct SimCommand
+{
+    SimCommandType type;
+    int value;
+} simcommand_t;
+
+typedef struct SimSnapshot
+{
+    unsigned long long tick;
+    double publishTime;           // getSimClock() when the tick finished
+    float tickSeconds;            // Wall-clock length of that tick - interpolation spans this long
+    float gameTime;
+    float timeScale;
+    bool paused;
+    bool mutualGravity;
+    int numBodies;
+    int numShips;
+    celestialbody_t *bodies;
+    Vector2 *previousBodyPositions;
+    ship_t *ships;                // Copies - futurePositions points into trajectories, landedBody at the sim's bodies
+    Vector2 *previousShipPositions;
+    float *previousShipRotations;
+    int *landedIndices;
+    Vector2 *trajectories;        // Every ship's futurePositions back to back
+    unsigned int *trajectoryRevisions;
+    int velocityTarget;           // Body index, -1 for none
+    bool velocityAuto;
+    float relativeSpeed;
+    float workSeconds;            // Time the tick spent working, excluding its sleep
+    float predictSeconds;         // Part of workSeconds spent predicting trajectories
+    float gravitySeconds;         // Part of workSeconds spent on ship mutual gravity
+} simsnapshot_t;
+
+typedef struct Simulation
+{
+    pthread_t thread;
+    atomic_bool running;
+    gamestate_t *state;
+
+    simsnapshot_t snapshots[3];
+    atomic_int latestSnapshot; // Slot index, plus SIM_SNAPSHOT_FRESH
+    int writeSnapshot;         // Owned by the sim thread
+    int readSnapshot;          // Owned by the render thread
+
+    simcommand_t commands[SIM_COMMAND_CAPACITY];
+    atomic_uint commandHead; // Next slot the render thread writes
+    atomic_uint commandTail; // Next slot the sim thread reads
+    atomic_uint inputMask;   // SimInput bits currently held
+
+    // Everything below is only touched by the sim thread once it is running
+    unsigned long long tick;
+    WarpController timeScale;
+    bool paused;
+    bool mutualGravity;
+    fmmsolver_t *fmmSolver;
+    QuadTreeNode *bodyTree;
+    int velocityLock;
+    celestialbody_t *velocityTarget;
+    float relativeSpeed;
+    qualitysettings_t quality; // Trajectory and gravity knobs, set through commands
+    float workSeconds;
+    float predictSeconds;
+    float gravitySeconds;
+    Vector2 *previousBodyPositions;
+    Vector2 *previousShipPositions;
+    float *previousShipRotations;
+    savewriter_t *saveWriter;  // Writes the saves captured between ticks
+    savejournal_t saveJournal; // What the autosave holds, so each autosave only journals what changed
+    double nextAutosave;       // getSimClock() time the next autosave is due
+} simulation_t;
+
+typedef struct SimMirror
+{
+    // Render-side copies of the newest snapshot with interpolated poses - safe to hand to the draw functions
+    int numBodies;
+    int numShips;
+    celestialbody_t *bodyStore;
+    celestialbody_t **bodies;
+    ship_t *shipStore;
+    ship_t **ships;
+} simmirror_t;
+
+double getSimClock(void);
+simulation_t *createSimulation(gamestate_t *state, WarpController timeScale);
+void freeSimulation(simulation_t *sim);
+bool sendSimCommand(simulation_t *sim, SimCommandType type, int value);
+void setSimInput(simulation_t *sim, unsigned int inputMask);
+simsnapshot_t *acquireSimSnapshot(simulation_t *sim);
+void updateSimMirror(simmirror_t *mirror, simsnapshot_t *snapshot, double now);
+void freeSimMirror(simmirror_t *mirror);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stdbool.h>
+#include "config.h"
+#include "raylib.h"
+#include "body.h"
+#include "ship.h"
+
+typedef enum
+{
+    SPATIAL_BODY,
+    SPATIAL_SHIP
+} SpatialEntryType;
+
+typedef struct SpatialEntry
+{
+    SpatialEntryType type;
+    int index;        // Index into the bodies or ships array the index was built from
+    Vector2 center;   // Pick shape centre
+    float radius;     // Pick shape radius
+    Rectangle bounds; // Bounding box of the pick shape
+} spatialentry_t;
+
+typedef struct SpatialNode
+{
+    Rectangle bounds;
+    spatialentry_t **entries; // Entries owned by this node - straddlers stay in the parent
+    int entryCount;
+    int entryCapacity;
+    int depth;
+    int children[4]; // NW, NE, SW, SE quadrants as indices into the node pool, all -1 for a leaf
+} spatialnode_t;
+
+typedef struct SpatialIndex
+{
+    spatialnode_t *nodes; // Pool kept across rebuilds along with each node's entry buffer, the root first
+    int numNodes;
+    int allocatedNodes;
+    spatialentry_t *entries;
+    int numEntries;
+    int maxEntries;
+    int nodeCapacity; // Entries held by a leaf before it subdivides
+} spatialindex_t;
+
+typedef struct SpatialQuery
+{
+    spatialentry_t **results;
+    int count;
+    int capacity;
+    bool overflowed; // Set when more entries matched than the buffer could hold
+} spatialquery_t;
+
+spatialindex_t *createSpatialIndex(int nodeCapacity);
+bool buildSpatialIndex(spatialindex_t *index, celestialbody_t **bodies, int numBodies, ship_t **ships, int numShips);
+void freeSpatialIndex(spatialindex_t *index);
+spatialquery_t createSpatialQuery(int capacity);
+void freeSpatialQuery(spatialquery_t *query);
+int querySpatialRect(spatialindex_t *index, Rectangle rect, spatialquery_t *query);
+int querySpatialPoint(spatialindex_t *index, Vector2 point, float pickRadius, spatialquery_t *query);
+spatialentry_t *pickSpatialEntry(spatialindex_t *index, Vector2 point, float pickRadius, spatialquery_t *query);
+Rectangle getCameraWorldBounds(Camera2D camera, Vector2 screenSize);
+void drawSpatialIndex(spatialindex_t *index, Color colour);
+
+#endif
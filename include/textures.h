@@ -2,8 +2,43 @@
 #define TEXTURES_H
 
 #include <raylib.h>
+#include "assets.h"
 
-// Load a texture by ID (e.g., mapped to a filename or type)
+#define TEXTURE_NONE -1      // Layer id for a sprite the ship does not have
+#define TEXTURE_PROCEDURAL -2 // Body surface generated from its name and index the first time it is drawn
+#define TEXTURE_SHIP_LOGO 15 // Zoomed-out ship icon, also the fallback for unknown ids
+#define TEXTURE_HUD_COMPASS 16
+#define TEXTURE_HUD_ARROW 17
+#define TEXTURE_BODY_EARTH 18
+#define TEXTURE_BODY_MOON 25
+#define TEXTURE_BODY_SUN 27
+#define TEXTURE_GENERATED_FIRST 256 // Ids from here up belong to registerGeneratedTexture
+
+/*
+    Sprite atlas
+    Every sprite entry in the texture map is packed into one texture at startup so all ship layers and icons draw from the
+    same texture, letting raylib batch them instead of flushing on every texture switch
+*/
+typedef struct SpriteAtlas
+{
+    Texture2D texture;
+    Rectangle *regions; // Source rectangle for each texture id
+    int numRegions;
+} spriteatlas_t;
+
+// Load a texture by ID (e.g., mapped to a filename or type) - shared and reference counted, release with UnloadTextureById
 Texture2D LoadTextureById(int id);
+int registerGeneratedTexture(const char *name, AssetGenerator generate, const void *params, size_t paramsSize);
+void requestTextureById(int id);
+Texture2D getTextureById(int id);
+AssetState getTextureState(int id);
+void UnloadTextureById(int id);
+int getTextureRefCount(int id);
+void unloadTextureCache(void);
+bool getTextureMapEntry(int index, int *id, const char **filename);
+bool loadSpriteAtlas(void);
+void unloadSpriteAtlas(void);
+Texture2D getSpriteAtlasTexture(void);
+Rectangle getSpriteRegion(int id);
 
 #endif
\ No newline at end of file
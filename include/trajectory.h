@@ -0,0 +1,58 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "game.h"
+#include "ship.h"
+#include "drawlist.h"
+
+/*
+    GPU trajectory rendering
+    Each ship's predicted path is split into chunks of TRAJECTORY_CHUNK_SEGMENTS segments, each a dynamic mesh with its
+    own bounding box. Recording emits an op for each chunk in view, and replaying an op rewrites the chunk only if
+    ship->trajectoryRevision has changed since it was last drawn. Lines keep a constant screen-space thickness because
+    the vertex shader pushes each vertex along its stored offset by a zoom-dependent half width
+    A path that changes length while recording has its uploaded chunks retired rather than unloaded, and they are
+    freed at the end of the next replay, so recording stays off the GPU
+*/
+
+typedef struct TrajectoryChunk
+{
+    Mesh mesh;             // Non-indexed triangle list, 6 vertices per segment
+    Rectangle bounds;      // World-space bounds of the chunk's path points
+    unsigned int revision; // ship->trajectoryRevision at the last upload
+    bool uploaded;
+} trajectorychunk_t;
+
+typedef struct TrajectoryMesh
+{
+    ship_t *ship;          // Ship these chunks were built for
+    int segmentCount;
+    unsigned int revision; // ship->trajectoryRevision the chunk bounds were computed for
+    trajectorychunk_t *chunks;
+    int numChunks;
+} trajectorymesh_t;
+
+typedef struct TrajectoryRenderer
+{
+    bool loaded;              // Shader and material are created on first replay
+    Shader shader;
+    int halfWidthLoc;
+    Material material;
+    trajectorymesh_t *meshes; // One per ship slot
+    int numMeshes;
+    Mesh *retired;            // Uploaded chunks of resized paths, waiting for replay to unload them
+    int numRetired;
+    int retiredCapacity;
+} trajectoryrenderer_t;
+
+trajectoryrenderer_t *createTrajectoryRenderer(void);
+void freeTrajectoryRenderer(trajectoryrenderer_t *renderer);
+void drawTrajectories(drawlist_t *list, trajectoryrenderer_t *renderer, ship_t **ships, int numShips, Camera2D *camera, Rectangle view, ColourScheme *colourScheme);
+void beginTrajectoryReplay(trajectoryrenderer_t *renderer, float halfWidth, Color colour);
+void replayTrajectoryChunk(trajectoryrenderer_t *renderer, int mesh, int chunk, int first, int segmentCount);
+void endTrajectoryReplay(trajectoryrenderer_t *renderer);
+
+#endif
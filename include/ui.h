@@ -1,16 +1,72 @@
 #ifndef UI_H
 #define UI_H
 
+#include <stdarg.h>
 #include "raylib.h"
 #include "body.h"
+#include "drawlist.h"
+
+#define VELOCITY_LOCK_AUTO -1 // Velocity lock index that tracks the dominant body
+#define HUD_TEXT_CAPACITY 96
+
+/*
+    Retained HUD
+    Text widgets keep their formatted string and measured width, keyed on the value they show quantised to display
+    precision, so a frame where nothing visible changed neither formats nor measures. Layers record their static
+    content once per screen size and bake it into a render texture on first replay, then composite it with one quad
+*/
+
+typedef struct HudText
+{
+    char text[HUD_TEXT_CAPACITY];
+    long long key;     // Quantised value the text was formatted from
+    bool valid;
+    int width;         // MeasureText result, -1 until measured at replay
+    int measuredSize;  // Font size width was measured at
+} hudtext_t;
+
+typedef struct HudLayer
+{
+    drawlist_t content;     // Recorded once per screen size, replayed into target when baking
+    RenderTexture2D target;
+    bool baked;             // target holds content
+} hudlayer_t;
 
 typedef struct
 {
     float speed;
     float playerRotation;
     celestialbody_t *velocityTarget;
+    bool velocityAuto; // velocityTarget follows the dominant body
+    int cameraLock;
+    float timeScale;
+    float zoom;
+    float throttle;
+    bool paused;
     Texture2D compassTexture;
     Texture2D arrowTexture;
+
+    // Retained state, zero-initialised
+    hudtext_t lockText;
+    hudtext_t speedText;
+    hudtext_t fpsText;
+    hudtext_t cameraText;
+    hudtext_t timeScaleText;
+    hudtext_t zoomText;
+    hudtext_t throttleText;
+    hudlayer_t staticLayer; // Labels and compass
+    hudlayer_t pauseLayer;  // Pause dimming and controls
 } HUD;
 
-#endif
\ No newline at end of file
+long long quantiseHudValue(double value, double precision);
+bool setHudText(hudtext_t *widget, long long key, const char *format, ...);
+bool setHudNumber(hudtext_t *widget, double value, double precision, const char *format);
+drawlist_t *beginHudLayer(hudlayer_t *layer, Vector2 screenSize);
+void invalidateHudLayer(hudlayer_t *layer);
+void freeHudLayer(hudlayer_t *layer);
+void drawListHudText(drawlist_t *list, hudtext_t *widget, int x, int y, int fontSize, TextAlign align, Color colour);
+void drawListHudLayer(drawlist_t *list, hudlayer_t *layer);
+void replayHudText(hudtext_t *widget, int x, int y, int fontSize, TextAlign align, Color colour);
+void replayHudLayer(hudlayer_t *layer);
+
+#endif
@@ -0,0 +1,151 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "assetpack.h"
+
+typedef struct AssetPack
+{
+    const unsigned char *data; // Whole file, mapped read-only
+    size_t size;
+    const assetpackentry_t *entries;
+    int numEntries;
+} assetpack_t;
+
+static assetpack_t pack = {0};
+
+uint64_t hashAssetPath(const char *path)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *c = (const unsigned char *)path; *c; c++)
+    {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool validAssetPack(const unsigned char *data, size_t size)
+{
+    // Everything the index points at must lie inside the file, so a truncated or stale pack is rejected up front
+    const assetpackheader_t *header = (const assetpackheader_t *)data;
+    if (size < sizeof(assetpackheader_t) || header->magic != ASSET_PACK_MAGIC)
+        return false;
+    if (header->version != ASSET_PACK_VERSION)
+    {
+        TraceLog(LOG_WARNING, "Asset pack version %u, expected %u", header->version, ASSET_PACK_VERSION);
+        return false;
+    }
+    if (header->numEntries > (size - sizeof(assetpackheader_t)) / sizeof(assetpackentry_t))
+        return false;
+
+    const assetpackentry_t *entries = (const assetpackentry_t *)(data + sizeof(assetpackheader_t));
+    for (uint32_t i = 0; i < header->numEntries; i++)
+    {
+        const assetpackentry_t *entry = &entries[i];
+        if (entry->offset > size || entry->size > size - entry->offset)
+            return false;
+        if (entry->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || entry->size != (uint64_t)entry->width * entry->height * 4)
+            return false;
+        if (i > 0 && entries[i - 1].pathHash >= entry->pathHash)
+            return false;
+    }
+    return true;
+}
+
+bool openAssetPack(const char *path)
+{
+    closeAssetPack();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        TraceLog(LOG_INFO, "No asset pack at %s, loading loose files", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        TraceLog(LOG_WARNING, "Asset pack %s is empty", path);
+        return false;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        TraceLog(LOG_ERROR, "Failed to map asset pack %s", path);
+        return false;
+    }
+    if (!validAssetPack(data, info.st_size))
+    {
+        munmap(data, info.st_size);
+        TraceLog(LOG_ERROR, "Asset pack %s is corrupt, rebuild it with make pack", path);
+        return false;
+    }
+    // Every packed texture is uploaded at startup or soon after, so start paging it in now
+    madvise(data, info.st_size, MADV_WILLNEED);
+
+    pack.data = data;
+    pack.size = info.st_size;
+    pack.entries = (const assetpackentry_t *)(pack.data + sizeof(assetpackheader_t));
+    pack.numEntries = ((const assetpackheader_t *)pack.data)->numEntries;
+    TraceLog(LOG_INFO, "Mapped asset pack %s with %d images", path, pack.numEntries);
+    return true;
+}
+
+void closeAssetPack(void)
+{
+    // Images found in the pack point into the mapping, so they must all be gone first
+    if (pack.data)
+        munmap((void *)pack.data, pack.size);
+    pack = (assetpack_t){0};
+}
+
+static Image getPackedImage(const assetpackentry_t *entry)
+{
+    // Borrowed - never pass to UnloadImage
+    return (Image){
+        .data = (void *)(pack.data + entry->offset),
+        .width = entry->width,
+        .height = entry->height,
+        .mipmaps = 1,
+        .format = entry->format};
+}
+
+bool findPackedImage(const char *filename, Image *image)
+{
+    uint64_t hash = hashAssetPath(filename);
+    int low = 0, high = pack.numEntries - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (pack.entries[mid].pathHash == hash)
+        {
+            *image = getPackedImage(&pack.entries[mid]);
+            return true;
+        }
+        if (pack.entries[mid].pathHash < hash)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return false;
+}
+
+bool findPackedImageById(int id, Image *image)
+{
+    // Only the tools look images up by id, so a scan is fine
+    for (int i = 0; i < pack.numEntries; i++)
+    {
+        if (pack.entries[i].id == id)
+        {
+            *image = getPackedImage(&pack.entries[i]);
+            return true;
+        }
+    }
+    return false;
+}
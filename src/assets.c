@@ -0,0 +1,397 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "assets.h"
+#include "assetpack.h"
+
+typedef enum
+{
+    SLOT_FREE,
+    SLOT_QUEUED,  // Waiting for or being decoded by a worker - the worker owns the slot's image
+    SLOT_DECODED, // Image ready - textures wait in the upload queue, images for takeAssetImage
+    SLOT_READY,   // Texture uploaded
+    SLOT_FAILED
+} SlotStatus;
+
+typedef struct Asset
+{
+    SlotStatus status;
+    AssetKind kind;
+    bool released; // Released while queued - the worker drops it once decoded
+    bool mapped;   // Image points into the asset pack, so it is dropped rather than unloaded
+    char filename[ASSET_PATH_CAPACITY]; // Or a generated asset's name, for logging
+    AssetGenerator generate;
+    unsigned char params[ASSET_PARAMS_CAPACITY];
+    Image image;
+    Texture2D texture;
+} asset_t;
+
+// Both queues hold slot handles, each slot at most once - a slot leaving a queue early is removed from it - and never
+// more than ASSET_CAPACITY slots are in use, so neither can overflow
+typedef struct AssetQueue
+{
+    int handles[ASSET_CAPACITY];
+    int head;
+    int count;
+} assetqueue_t;
+
+static struct
+{
+    bool running;
+    pthread_t workers[ASSET_MAX_WORKERS];
+    int numWorkers;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;  // Signalled when a decode is queued or the loader stops
+    pthread_cond_t decoded; // Broadcast whenever a decode finishes
+    asset_t assets[ASSET_CAPACITY];
+    assetqueue_t decodeQueue;
+    assetqueue_t uploadQueue;
+    Texture2D placeholder;
+} loader = {0};
+
+static void pushAssetQueue(assetqueue_t *queue, int handle)
+{
+    queue->handles[(queue->head + queue->count) % ASSET_CAPACITY] = handle;
+    queue->count++;
+}
+
+static int popAssetQueue(assetqueue_t *queue)
+{
+    int handle = queue->handles[queue->head];
+    queue->head = (queue->head + 1) % ASSET_CAPACITY;
+    queue->count--;
+    return handle;
+}
+
+static void removeAssetQueue(assetqueue_t *queue, int handle)
+{
+    // Closes the gap behind it, keeping the rest in order
+    int kept = 0;
+    for (int i = 0; i < queue->count; i++)
+    {
+        int entry = queue->handles[(queue->head + i) % ASSET_CAPACITY];
+        if (entry != handle)
+            queue->handles[(queue->head + kept++) % ASSET_CAPACITY] = entry;
+    }
+    queue->count = kept;
+}
+
+static bool validAssetHandle(int handle)
+{
+    return handle >= 0 && handle < ASSET_CAPACITY;
+}
+
+static void *assetWorker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&loader.lock);
+    while (true)
+    {
+        while (loader.running && loader.decodeQueue.count == 0)
+        {
+            pthread_cond_wait(&loader.queued, &loader.lock);
+        }
+        if (!loader.running)
+            break;
+        asset_t *asset = &loader.assets[popAssetQueue(&loader.decodeQueue)];
+
+        // Decoding is the slow part, so it runs unlocked - nothing else touches a queued slot's image
+        pthread_mutex_unlock(&loader.lock);
+        Image image = asset->generate ? asset->generate(asset->params) : LoadImage(asset->filename);
+        pthread_mutex_lock(&loader.lock);
+
+        bool valid = IsImageValid(image);
+        if (asset->released)
+        {
+            if (valid)
+                UnloadImage(image);
+            *asset = (asset_t){0};
+        }
+        else if (!valid)
+        {
+            TraceLog(LOG_WARNING, "Asset %s failed to decode", asset->filename);
+            asset->status = SLOT_FAILED;
+        }
+        else
+        {
+            asset->image = image;
+            asset->status = SLOT_DECODED;
+            if (asset->kind == ASSET_TEXTURE)
+                pushAssetQueue(&loader.uploadQueue, asset - loader.assets);
+        }
+        pthread_cond_broadcast(&loader.decoded);
+    }
+    pthread_mutex_unlock(&loader.lock);
+    return NULL;
+}
+
+bool initAssetLoader(void)
+{
+    // Needs the window's GL context for the placeholder and uploads
+    openAssetPack(ASSET_PACK_PATH);
+    Image checker = GenImageChecked(ASSET_PLACEHOLDER_SIZE, ASSET_PLACEHOLDER_SIZE, ASSET_PLACEHOLDER_SIZE / 2,
+                                    ASSET_PLACEHOLDER_SIZE / 2, MAGENTA, BLACK);
+    loader.placeholder = LoadTextureFromImage(checker);
+    UnloadImage(checker);
+
+    pthread_mutex_init(&loader.lock, NULL);
+    pthread_cond_init(&loader.queued, NULL);
+    pthread_cond_init(&loader.decoded, NULL);
+    loader.running = true;
+
+    // Leave a core for the main thread
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cores > 1 ? (int)cores - 1 : 1;
+    workers = workers > ASSET_MAX_WORKERS ? ASSET_MAX_WORKERS : workers;
+    for (int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&loader.workers[loader.numWorkers], NULL, assetWorker, NULL) != 0)
+        {
+            TraceLog(LOG_WARNING, "Failed to start asset worker %d", i);
+            break;
+        }
+        loader.numWorkers++;
+    }
+    if (loader.numWorkers == 0)
+    {
+        TraceLog(LOG_ERROR, "No asset workers running");
+        shutdownAssetLoader();
+        return false;
+    }
+    TraceLog(LOG_INFO, "Asset loader started %d workers", loader.numWorkers);
+    return true;
+}
+
+void shutdownAssetLoader(void)
+{
+    pthread_mutex_lock(&loader.lock);
+    loader.running = false;
+    pthread_cond_broadcast(&loader.queued);
+    pthread_mutex_unlock(&loader.lock);
+    for (int i = 0; i < loader.numWorkers; i++)
+    {
+        pthread_join(loader.workers[i], NULL);
+    }
+
+    for (int i = 0; i < ASSET_CAPACITY; i++)
+    {
+        if (loader.assets[i].status == SLOT_DECODED && !loader.assets[i].mapped)
+            UnloadImage(loader.assets[i].image);
+        else if (loader.assets[i].status == SLOT_READY)
+            UnloadTexture(loader.assets[i].texture);
+    }
+    UnloadTexture(loader.placeholder);
+    closeAssetPack();
+    pthread_cond_destroy(&loader.queued);
+    pthread_cond_destroy(&loader.decoded);
+    pthread_mutex_destroy(&loader.lock);
+    memset(&loader, 0, sizeof(loader));
+}
+
+static int queueAsset(const char *filename, AssetGenerator generate, const void *params, size_t paramsSize, AssetKind kind)
+{
+    // Returns a handle, or -1 when the loader is not running or full
+    if (!loader.running)
+    {
+        TraceLog(LOG_ERROR, "Asset loader is not running, cannot load %s", filename);
+        return -1;
+    }
+
+    pthread_mutex_lock(&loader.lock);
+    int handle = -1;
+    for (int i = 0; i < ASSET_CAPACITY && handle < 0; i++)
+    {
+        if (loader.assets[i].status == SLOT_FREE)
+            handle = i;
+    }
+    if (handle < 0)
+    {
+        pthread_mutex_unlock(&loader.lock);
+        TraceLog(LOG_ERROR, "Asset loader is full, cannot load %s", filename);
+        return -1;
+    }
+
+    asset_t *asset = &loader.assets[handle];
+    *asset = (asset_t){.status = SLOT_QUEUED, .kind = kind, .generate = generate};
+    strncpy(asset->filename, filename, ASSET_PATH_CAPACITY - 1);
+    if (generate)
+        memcpy(asset->params, params, paramsSize);
+
+    // Packed images are already decoded - textures go straight to the upload queue, uploading from the mapping, while
+    // images are copied out since the caller owns and edits them
+    Image packed;
+    if (!generate && findPackedImage(filename, &packed))
+    {
+        asset->image = kind == ASSET_IMAGE ? ImageCopy(packed) : packed;
+        asset->mapped = kind == ASSET_TEXTURE;
+        asset->status = SLOT_DECODED;
+        if (kind == ASSET_TEXTURE)
+            pushAssetQueue(&loader.uploadQueue, handle);
+        pthread_mutex_unlock(&loader.lock);
+        return handle;
+    }
+
+    pushAssetQueue(&loader.decodeQueue, handle);
+    pthread_cond_signal(&loader.queued);
+    pthread_mutex_unlock(&loader.lock);
+    return handle;
+}
+
+int requestAsset(const char *filename, AssetKind kind)
+{
+    return queueAsset(filename, NULL, NULL, 0, kind);
+}
+
+int requestGeneratedAsset(const char *name, AssetGenerator generate, const void *params, size_t paramsSize, AssetKind kind)
+{
+    if (paramsSize > ASSET_PARAMS_CAPACITY)
+    {
+        TraceLog(LOG_ERROR, "Parameters for %s are %zu bytes, the limit is %d", name, paramsSize, ASSET_PARAMS_CAPACITY);
+        return -1;
+    }
+    return queueAsset(name, generate, params, paramsSize, kind);
+}
+
+AssetState getAssetState(int handle)
+{
+    if (!validAssetHandle(handle))
+        return ASSET_FAILED;
+    pthread_mutex_lock(&loader.lock);
+    asset_t *asset = &loader.assets[handle];
+    AssetState state = ASSET_PENDING;
+    if (asset->status == SLOT_READY || (asset->status == SLOT_DECODED && asset->kind == ASSET_IMAGE))
+        state = ASSET_READY;
+    else if (asset->status == SLOT_FAILED || asset->status == SLOT_FREE)
+        state = ASSET_FAILED;
+    pthread_mutex_unlock(&loader.lock);
+    return state;
+}
+
+static void uploadAsset(asset_t *asset)
+{
+    // Main thread only, on a decoded texture - workers never touch decoded slots
+    Texture2D texture = LoadTextureFromImage(asset->image);
+    if (!asset->mapped)
+        UnloadImage(asset->image);
+    asset->image = (Image){0};
+
+    pthread_mutex_lock(&loader.lock);
+    if (IsTextureValid(texture))
+    {
+        asset->texture = texture;
+        asset->status = SLOT_READY;
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "Asset %s failed to upload", asset->filename);
+        asset->status = SLOT_FAILED;
+    }
+    pthread_mutex_unlock(&loader.lock);
+}
+
+void waitForAsset(int handle)
+{
+    // Blocks until decoded, and uploads a texture straight away rather than waiting for its turn in the queue
+    if (!validAssetHandle(handle))
+        return;
+    asset_t *asset = &loader.assets[handle];
+    pthread_mutex_lock(&loader.lock);
+    while (asset->status == SLOT_QUEUED)
+    {
+        pthread_cond_wait(&loader.decoded, &loader.lock);
+    }
+    bool upload = asset->status == SLOT_DECODED && asset->kind == ASSET_TEXTURE;
+    if (upload)
+        removeAssetQueue(&loader.uploadQueue, handle);
+    pthread_mutex_unlock(&loader.lock);
+    if (upload)
+        uploadAsset(asset);
+}
+
+Texture2D getAssetTexture(int handle)
+{
+    Texture2D texture = loader.placeholder;
+    if (!validAssetHandle(handle))
+        return texture;
+    pthread_mutex_lock(&loader.lock);
+    if (loader.assets[handle].status == SLOT_READY)
+        texture = loader.assets[handle].texture;
+    pthread_mutex_unlock(&loader.lock);
+    return texture;
+}
+
+Texture2D getPlaceholderTexture(void)
+{
+    return loader.placeholder;
+}
+
+Image takeAssetImage(int handle)
+{
+    // Waits for the decode and passes the image to the caller, freeing the handle - failed loads give an invalid image
+    if (!validAssetHandle(handle) || loader.assets[handle].kind != ASSET_IMAGE)
+        return (Image){0};
+    waitForAsset(handle);
+    pthread_mutex_lock(&loader.lock);
+    asset_t *asset = &loader.assets[handle];
+    Image image = asset->status == SLOT_DECODED ? asset->image : (Image){0};
+    *asset = (asset_t){0};
+    pthread_mutex_unlock(&loader.lock);
+    return image;
+}
+
+void releaseAsset(int handle)
+{
+    if (!validAssetHandle(handle))
+        return;
+    pthread_mutex_lock(&loader.lock);
+    asset_t *asset = &loader.assets[handle];
+    switch (asset->status)
+    {
+    case SLOT_QUEUED:
+        // A worker owns it until the decode finishes
+        asset->released = true;
+        break;
+    case SLOT_DECODED:
+        // Its upload queue entry goes too, or the slot could be reused and queued a second time
+        if (asset->kind == ASSET_TEXTURE)
+            removeAssetQueue(&loader.uploadQueue, handle);
+        if (!asset->mapped)
+            UnloadImage(asset->image);
+        *asset = (asset_t){0};
+        break;
+    case SLOT_READY:
+        UnloadTexture(asset->texture);
+        *asset = (asset_t){0};
+        break;
+    default:
+        *asset = (asset_t){0};
+        break;
+    }
+    pthread_mutex_unlock(&loader.lock);
+}
+
+int processAssetUploads(double budgetSeconds)
+{
+    // Uploads decoded textures until the budget is spent, always at least one so the queue keeps moving
+    // Returns how many were uploaded
+    double start = GetTime();
+    int uploaded = 0;
+    while (true)
+    {
+        pthread_mutex_lock(&loader.lock);
+        if (loader.uploadQueue.count == 0)
+        {
+            pthread_mutex_unlock(&loader.lock);
+            break;
+        }
+        asset_t *asset = &loader.assets[popAssetQueue(&loader.uploadQueue)];
+        pthread_mutex_unlock(&loader.lock);
+
+        uploadAsset(asset);
+        uploaded++;
+        if (GetTime() - start >= budgetSeconds)
+            break;
+    }
+    return uploaded;
+}
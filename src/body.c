@@ -10,17 +10,24 @@ celestialbody_t **initBodies(int *numBodies)
 {
     *numBodies = 2;
     celestialbody_t **bodies = malloc(sizeof(celestialbody_t *) * (*numBodies));
+    // One block for every body, the same shape a loaded save has
+    celestialbody_t *store = malloc(sizeof(celestialbody_t) * (*numBodies));
+    for (int i = 0; i < *numBodies; i++)
+    {
+        bodies[i] = &store[i];
+    }
 
     // Planet orbiting Star - Earth
-    bodies[0] = malloc(sizeof(celestialbody_t));
     *bodies[0] = (celestialbody_t){
         .type = TYPE_PLANET,
-        .name = strdup("Earth"),
+        .name = "Earth",
         .position = {0, 0},
         .mass = 5.97e9, // Real val = 5.97e24 kg
         .radius = 6e3,  // Real val = 6.378e3 km
         .rotation = 0.0f,
-        .parentBody = NULL,
+        .textureId = TEXTURE_BODY_EARTH,
+        .textureScale = 1.0f,
+        .parentIndex = -1,
         .angularSpeed = 0, // Real val = 365.2 Days (365.2 * 24 * 60 * 60 seconds)
         .initialAngle = 0,
         .orbitalRadius = 0, // Real val = 1.496e8 km
@@ -29,15 +36,16 @@ celestialbody_t **initBodies(int *numBodies)
         .atmosphereColour = (Color){10, 131, 251, 50}};
 
     // Moon orbiting Planet
-    bodies[1] = malloc(sizeof(celestialbody_t));
     *bodies[1] = (celestialbody_t){
         .type = TYPE_MOON,
-        .name = strdup("Earth's Moon"),
+        .name = "Earth's Moon",
         .position = {0, 0},
         .mass = 7.3e7, // Real val = 7.3e22 kg
         .radius = 2e3, // Real val = 1.7375e3 km
         .rotation = 0.0f,
-        .parentBody = bodies[0],
+        .textureId = TEXTURE_PROCEDURAL,
+        .textureScale = 1.0f,
+        .parentIndex = 0,
         .angularSpeed = radsPerSecond(27.3 * 24 * 60 * 60),
         .initialAngle = 0,
         .orbitalRadius = 1.8e5, // Real val = 3.84e5 km,
@@ -47,36 +55,6 @@ celestialbody_t **initBodies(int *numBodies)
     return bodies;
 }
 
-bool saveBody(celestialbody_t *body, FILE *file, gamestate_t *state) {
-    fwrite(&body->type, sizeof(CelestialType), 1, file);
-    int nameLen = body->name ? strlen(body->name) : 0;
-    fwrite(&nameLen, sizeof(int), 1, file);
-    if (nameLen > 0) {
-        fwrite(body->name, sizeof(char), nameLen, file);
-    }
-    fwrite(&body->position, sizeof(Vector2), 1, file);
-    fwrite(&body->mass, sizeof(float), 1, file);
-    fwrite(&body->radius, sizeof(float), 1, file);
-    fwrite(&body->rotation, sizeof(float), 1, file);
-    // Texture ID
-    fwrite(&body->textureScale, sizeof(float), 1, file);
-    int parentIndex = getBodyIndex(body->parentBody, state->bodies, state->numBodies);
-    fwrite(parentIndex, sizeof(int), 1, file);
-    fwrite(&body->orbitalRadius, sizeof(float), 1, file);
-    fwrite(&body->angularSpeed, sizeof(float), 1, file);
-    fwrite(&body->initialAngle, sizeof(float), 1, file);
-    fwrite(&body->atmosphereRadius, sizeof(float), 1, file);
-    fwrite(&body->atmosphereDrag, sizeof(float), 1, file);
-    fwrite(&body->atmosphereColour, sizeof(Color), 1, file);
-
-    if (ferror(file)) {
-        TraceLog(LOG_ERROR, "Write error in saveBody");
-        return false;
-    }
-    return true;
-
-}
-
 int getBodyIndex(celestialbody_t *body, celestialbody_t **bodies, int numBodies) {
     for (int i = 0; i < numBodies; i++) {
         if (body == bodies[i]) {
@@ -95,15 +73,11 @@ celestialbody_t* getBodyPtr(int index, celestialbody_t **bodies, int numBodies)
 
 void freeCelestialBodies(celestialbody_t **bodies, int numBodies)
 {
+    // Bodies share the block initBodies allocated, which starts at the first of them
     if (bodies)
     {
-        for (int i = 0; i < numBodies; i++)
-        {
-            free(bodies[i]->name);
-            // if (bodies[i]->resources)
-            //     free(bodies[i]->resources);
-            free(bodies[i]);
-        }
+        if (numBodies > 0)
+            free(bodies[0]);
         free(bodies);
     }
 }
\ No newline at end of file
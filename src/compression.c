@@ -0,0 +1,192 @@
+#include <stdint.h>
+#include <string.h>
+#include "compression.h"
+
+#define HASH_BITS 12
+#define LAST_LITERALS 5 // The format ends every block on at least this many literals
+#define MATCH_FIND_LIMIT 12 // and starts no match closer than this to the end
+
+static inline uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static size_t matchLength(const unsigned char *p, const unsigned char *match, const unsigned char *limit)
+{
+    // Eight bytes at a time, then the first differing byte from the lowest set bit of the difference
+    const unsigned char *start = p;
+    while (p + 8 <= limit)
+    {
+        uint64_t diff = read64(p) ^ read64(match);
+        if (diff)
+            return p - start + (__builtin_ctzll(diff) >> 3);
+        p += 8;
+        match += 8;
+    }
+    while (p < limit && *p == *match)
+    {
+        p++;
+        match++;
+    }
+    return p - start;
+}
+
+static unsigned char *writeLength(unsigned char *op, size_t length)
+{
+    // Lengths past the token's 15 continue in bytes of 255, ending on one below that
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+size_t compressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t compressBlock(const unsigned char *src, size_t size, unsigned char *dst, size_t capacity)
+{
+    // Returns the compressed size, or 0 if it did not fit in capacity
+    uint32_t table[1 << HASH_BITS] = {0};
+    const unsigned char *ip = src;
+    const unsigned char *anchor = src;
+    const unsigned char *end = src + size;
+    const unsigned char *matchLimit = end - LAST_LITERALS;
+    unsigned char *op = dst;
+    unsigned char *outEnd = dst + capacity;
+
+    if (size > MATCH_FIND_LIMIT)
+    {
+        const unsigned char *findLimit = end - MATCH_FIND_LIMIT;
+        unsigned misses = 0;
+        while (ip < findLimit)
+        {
+            uint32_t sequence = read32(ip);
+            uint32_t h = hashSequence(sequence);
+            const unsigned char *match = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            if (match >= ip || ip - match > COMPRESSION_MAX_OFFSET || read32(match) != sequence)
+            {
+                // Step further the longer nothing matches, so incompressible data passes quickly
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && match > src && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+            size_t literals = ip - anchor;
+            size_t length = COMPRESSION_MIN_MATCH +
+                            matchLength(ip + COMPRESSION_MIN_MATCH, match + COMPRESSION_MIN_MATCH, matchLimit);
+            if ((size_t)(outEnd - op) < 1 + literals + literals / 255 + 1 + 2 + length / 255 + 1)
+                return 0;
+
+            unsigned char *token = op++;
+            *token = (unsigned char)((literals < 15 ? literals : 15) << 4);
+            if (literals >= 15)
+                op = writeLength(op, literals - 15);
+            memcpy(op, anchor, literals);
+            op += literals;
+            size_t offset = ip - match;
+            *op++ = (unsigned char)offset;
+            *op++ = (unsigned char)(offset >> 8);
+            size_t extra = length - COMPRESSION_MIN_MATCH;
+            *token |= (unsigned char)(extra < 15 ? extra : 15);
+            if (extra >= 15)
+                op = writeLength(op, extra - 15);
+
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    // The rest goes out as a final run of literals with no match
+    size_t literals = end - anchor;
+    if ((size_t)(outEnd - op) < 1 + literals + literals / 255 + 1)
+        return 0;
+    *op++ = (unsigned char)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15)
+        op = writeLength(op, literals - 15);
+    memcpy(op, anchor, literals);
+    op += literals;
+    return op - dst;
+}
+
+static bool readLength(const unsigned char **ip, const unsigned char *end, size_t *length)
+{
+    unsigned char byte;
+    do
+    {
+        if (*ip >= end)
+            return false;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompressBlock(const unsigned char *src, size_t size, unsigned char *dst, size_t dstSize)
+{
+    // Fails on anything that would read or write out of bounds, and unless it fills dst exactly
+    const unsigned char *ip = src;
+    const unsigned char *end = src + size;
+    unsigned char *op = dst;
+    unsigned char *outEnd = dst + dstSize;
+    while (ip < end)
+    {
+        unsigned token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(&ip, end, &literals))
+            return false;
+        if (literals > (size_t)(end - ip) || literals > (size_t)(outEnd - op))
+            return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(&ip, end, &length))
+            return false;
+        length += COMPRESSION_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - dst) || length > (size_t)(outEnd - op))
+            return false;
+
+        // Matches may overlap what they write - a short offset repeats its bytes
+        const unsigned char *match = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+                *op++ = match[i];
+        }
+    }
+    return op == outEnd;
+}
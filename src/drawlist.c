@@ -0,0 +1,415 @@
+#include <stdlib.h>
+#include <string.h>
+#include "drawlist.h"
+#include "trajectory.h"
+#include "shiprenderer.h"
+#include "grid.h"
+#include "ui.h"
+
+#define DRAW_LIST_INITIAL_COMMANDS 256
+
+static const char *drawOpNames[DRAW_OP_COUNT] = {
+    "begin_camera", "end_camera", "circle", "line", "line_strip", "rectangle", "texture", "text",
+    "trajectories_begin", "trajectory_chunk", "trajectories_end", "ships", "grid", "hud_text", "hud_layer"};
+
+drawlist_t createDrawList(void)
+{
+    drawlist_t list = {0};
+    return list;
+}
+
+void freeDrawList(drawlist_t *list)
+{
+    free(list->commands);
+    free(list->points);
+    free(list->instances);
+    free(list->text);
+    *list = (drawlist_t){0};
+}
+
+void clearDrawList(drawlist_t *list, Vector2 screenSize)
+{
+    // Keeps every buffer, so a steady frame records without allocating
+    list->screenSize = screenSize;
+    list->numCommands = 0;
+    list->numPoints = 0;
+    list->numInstances = 0;
+    list->textSize = 0;
+}
+
+const char *getDrawOpName(DrawOpType type)
+{
+    return type >= 0 && type < DRAW_OP_COUNT ? drawOpNames[type] : "unknown";
+}
+
+static bool reserveDrawBuffer(void **buffer, int *capacity, int needed, size_t elementSize)
+{
+    if (needed <= *capacity)
+        return true;
+    int newCapacity = *capacity > 0 ? *capacity : DRAW_LIST_INITIAL_COMMANDS;
+    while (newCapacity < needed)
+        newCapacity *= 2;
+    void *grown = realloc(*buffer, elementSize * newCapacity);
+    if (!grown)
+    {
+        TraceLog(LOG_ERROR, "Failed to grow draw list buffer to %i elements", newCapacity);
+        return false;
+    }
+    *buffer = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+drawcommand_t *pushDrawCommand(drawlist_t *list, DrawOpType type)
+{
+    if (!reserveDrawBuffer((void **)&list->commands, &list->commandCapacity, list->numCommands + 1, sizeof(drawcommand_t)))
+        return NULL;
+    drawcommand_t *command = &list->commands[list->numCommands++];
+    memset(command, 0, sizeof(drawcommand_t));
+    command->type = type;
+    return command;
+}
+
+Vector2 *pushDrawPoints(drawlist_t *list, int count, int *first)
+{
+    if (!reserveDrawBuffer((void **)&list->points, &list->pointCapacity, list->numPoints + count, sizeof(Vector2)))
+        return NULL;
+    *first = list->numPoints;
+    list->numPoints += count;
+    return &list->points[*first];
+}
+
+Matrix *pushDrawInstances(drawlist_t *list, int count, int *first)
+{
+    if (!reserveDrawBuffer((void **)&list->instances, &list->instanceCapacity, list->numInstances + count, sizeof(Matrix)))
+        return NULL;
+    *first = list->numInstances;
+    list->numInstances += count;
+    return &list->instances[*first];
+}
+
+void drawListBeginCamera(drawlist_t *list, Camera2D camera)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_BEGIN_CAMERA);
+    if (command)
+        command->camera = camera;
+}
+
+void drawListEndCamera(drawlist_t *list)
+{
+    pushDrawCommand(list, DRAW_OP_END_CAMERA);
+}
+
+void drawListCircle(drawlist_t *list, Vector2 center, float radius, Color colour)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_CIRCLE);
+    if (command)
+    {
+        command->circle.center = center;
+        command->circle.radius = radius;
+        command->circle.colour = colour;
+    }
+}
+
+void drawListLine(drawlist_t *list, Vector2 start, Vector2 end, Color colour)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_LINE);
+    if (command)
+    {
+        command->line.start = start;
+        command->line.end = end;
+        command->line.colour = colour;
+    }
+}
+
+void drawListLineStrip(drawlist_t *list, const Vector2 *points, int count, Color colour)
+{
+    int first;
+    Vector2 *stored = pushDrawPoints(list, count, &first);
+    if (!stored)
+        return;
+    memcpy(stored, points, sizeof(Vector2) * count);
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_LINE_STRIP);
+    if (command)
+    {
+        command->lineStrip.first = first;
+        command->lineStrip.count = count;
+        command->lineStrip.colour = colour;
+    }
+}
+
+void drawListRectangle(drawlist_t *list, Rectangle bounds, Color colour)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_RECTANGLE);
+    if (command)
+    {
+        command->rectangle.bounds = bounds;
+        command->rectangle.colour = colour;
+    }
+}
+
+void drawListTexture(drawlist_t *list, Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_TEXTURE);
+    if (command)
+    {
+        command->texture.texture = texture;
+        command->texture.source = source;
+        command->texture.dest = dest;
+        command->texture.origin = origin;
+        command->texture.rotation = rotation;
+        command->texture.tint = tint;
+    }
+}
+
+void drawListText(drawlist_t *list, const char *text, int x, int y, int fontSize, TextAlign align, Color colour)
+{
+    // Copied in, so TextFormat's rotating buffers can be reused before the list is replayed
+    int length = (int)strlen(text) + 1;
+    if (!reserveDrawBuffer((void **)&list->text, &list->textCapacity, list->textSize + length, sizeof(char)))
+        return;
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_TEXT);
+    if (!command)
+        return;
+    memcpy(list->text + list->textSize, text, length);
+    command->text.offset = list->textSize;
+    command->text.x = x;
+    command->text.y = y;
+    command->text.fontSize = fontSize;
+    command->text.align = align;
+    command->text.colour = colour;
+    list->textSize += length;
+}
+
+void replayDrawList(drawlist_t *list)
+{
+    for (int i = 0; i < list->numCommands; i++)
+    {
+        drawcommand_t *command = &list->commands[i];
+        switch (command->type)
+        {
+        case DRAW_OP_BEGIN_CAMERA:
+            BeginMode2D(command->camera);
+            break;
+        case DRAW_OP_END_CAMERA:
+            EndMode2D();
+            break;
+        case DRAW_OP_CIRCLE:
+            DrawCircleV(command->circle.center, command->circle.radius, command->circle.colour);
+            break;
+        case DRAW_OP_LINE:
+            DrawLineV(command->line.start, command->line.end, command->line.colour);
+            break;
+        case DRAW_OP_LINE_STRIP:
+            DrawLineStrip(&list->points[command->lineStrip.first], command->lineStrip.count, command->lineStrip.colour);
+            break;
+        case DRAW_OP_RECTANGLE:
+            DrawRectangleRec(command->rectangle.bounds, command->rectangle.colour);
+            break;
+        case DRAW_OP_TEXTURE:
+            DrawTexturePro(command->texture.texture, command->texture.source, command->texture.dest,
+                           command->texture.origin, command->texture.rotation, command->texture.tint);
+            break;
+        case DRAW_OP_TEXT:
+        {
+            const char *text = list->text + command->text.offset;
+            int x = command->text.x;
+            if (command->text.align == DRAW_TEXT_ALIGN_CENTRE)
+                x -= MeasureText(text, command->text.fontSize) / 2;
+            else if (command->text.align == DRAW_TEXT_ALIGN_RIGHT)
+                x -= MeasureText(text, command->text.fontSize);
+            DrawText(text, x, command->text.y, command->text.fontSize, command->text.colour);
+            break;
+        }
+        case DRAW_OP_TRAJECTORIES_BEGIN:
+            beginTrajectoryReplay(command->trajectories.renderer, command->trajectories.halfWidth, command->trajectories.colour);
+            break;
+        case DRAW_OP_TRAJECTORY_CHUNK:
+            replayTrajectoryChunk(command->trajectoryChunk.renderer, command->trajectoryChunk.mesh, command->trajectoryChunk.chunk,
+                                  command->trajectoryChunk.first, command->trajectoryChunk.segmentCount);
+            break;
+        case DRAW_OP_TRAJECTORIES_END:
+            endTrajectoryReplay(command->trajectories.renderer);
+            break;
+        case DRAW_OP_SHIPS:
+            replayShips(command->ships.renderer, &list->instances[command->ships.first], command->ships.count);
+            break;
+        case DRAW_OP_GRID:
+            replayGrid(command->grid.renderer, &list->instances[command->grid.first], command->grid.count,
+                       command->grid.halfWidth, command->grid.colour);
+            break;
+        case DRAW_OP_HUD_TEXT:
+            replayHudText(command->hudText.widget, command->hudText.x, command->hudText.y, command->hudText.fontSize,
+                          command->hudText.align, command->hudText.colour);
+            break;
+        case DRAW_OP_HUD_LAYER:
+            replayHudLayer(command->hudLayer);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#define HASH_FIELD(hash, field) hashBytes(hash, &(field), sizeof(field))
+
+static uint64_t hashDrawCommand(drawlist_t *list, drawcommand_t *command, uint64_t hash)
+{
+    hash = HASH_FIELD(hash, command->type);
+    switch (command->type)
+    {
+    case DRAW_OP_BEGIN_CAMERA:
+        hash = HASH_FIELD(hash, command->camera);
+        break;
+    case DRAW_OP_CIRCLE:
+        hash = HASH_FIELD(hash, command->circle);
+        break;
+    case DRAW_OP_LINE:
+        hash = HASH_FIELD(hash, command->line);
+        break;
+    case DRAW_OP_LINE_STRIP:
+        hash = HASH_FIELD(hash, command->lineStrip.colour);
+        hash = hashBytes(hash, &list->points[command->lineStrip.first], sizeof(Vector2) * command->lineStrip.count);
+        break;
+    case DRAW_OP_RECTANGLE:
+        hash = HASH_FIELD(hash, command->rectangle);
+        break;
+    case DRAW_OP_TEXTURE:
+        // Texture ids depend on the GL driver, so only the geometry is hashed
+        hash = HASH_FIELD(hash, command->texture.source);
+        hash = HASH_FIELD(hash, command->texture.dest);
+        hash = HASH_FIELD(hash, command->texture.origin);
+        hash = HASH_FIELD(hash, command->texture.rotation);
+        hash = HASH_FIELD(hash, command->texture.tint);
+        break;
+    case DRAW_OP_TEXT:
+        hash = hashBytes(hash, list->text + command->text.offset, strlen(list->text + command->text.offset));
+        hash = HASH_FIELD(hash, command->text.x);
+        hash = HASH_FIELD(hash, command->text.y);
+        hash = HASH_FIELD(hash, command->text.fontSize);
+        hash = HASH_FIELD(hash, command->text.align);
+        hash = HASH_FIELD(hash, command->text.colour);
+        break;
+    case DRAW_OP_TRAJECTORIES_BEGIN:
+        hash = HASH_FIELD(hash, command->trajectories.halfWidth);
+        hash = HASH_FIELD(hash, command->trajectories.colour);
+        break;
+    case DRAW_OP_TRAJECTORY_CHUNK:
+        hash = HASH_FIELD(hash, command->trajectoryChunk.mesh);
+        hash = HASH_FIELD(hash, command->trajectoryChunk.chunk);
+        hash = HASH_FIELD(hash, command->trajectoryChunk.segmentCount);
+        hash = HASH_FIELD(hash, command->trajectoryChunk.bounds);
+        break;
+    case DRAW_OP_SHIPS:
+        hash = hashBytes(hash, &list->instances[command->ships.first], sizeof(Matrix) * command->ships.count);
+        break;
+    case DRAW_OP_GRID:
+        hash = hashBytes(hash, &list->instances[command->grid.first], sizeof(Matrix) * command->grid.count);
+        hash = HASH_FIELD(hash, command->grid.halfWidth);
+        hash = HASH_FIELD(hash, command->grid.colour);
+        break;
+    case DRAW_OP_HUD_TEXT:
+        hash = hashBytes(hash, command->hudText.widget->text, strlen(command->hudText.widget->text));
+        hash = HASH_FIELD(hash, command->hudText.x);
+        hash = HASH_FIELD(hash, command->hudText.y);
+        hash = HASH_FIELD(hash, command->hudText.fontSize);
+        hash = HASH_FIELD(hash, command->hudText.align);
+        hash = HASH_FIELD(hash, command->hudText.colour);
+        break;
+    case DRAW_OP_HUD_LAYER:
+    {
+        // A layer hashes as the content baked into it
+        drawliststats_t content = recordDrawList(&command->hudLayer->content);
+        hash = HASH_FIELD(hash, content.hash);
+        break;
+    }
+    default:
+        break;
+    }
+    return hash;
+}
+
+drawliststats_t recordDrawList(drawlist_t *list)
+{
+    drawliststats_t stats = {0};
+    stats.hash = 0xcbf29ce484222325ULL;
+    stats.numCommands = list->numCommands;
+    for (int i = 0; i < list->numCommands; i++)
+    {
+        stats.counts[list->commands[i].type]++;
+        stats.hash = hashDrawCommand(list, &list->commands[i], stats.hash);
+    }
+    return stats;
+}
+
+void dumpDrawList(drawlist_t *list, FILE *file)
+{
+    for (int i = 0; i < list->numCommands; i++)
+    {
+        drawcommand_t *command = &list->commands[i];
+        fprintf(file, "%6i %-18s", i, drawOpNames[command->type]);
+        switch (command->type)
+        {
+        case DRAW_OP_BEGIN_CAMERA:
+            fprintf(file, " target=(%g, %g) offset=(%g, %g) zoom=%g", command->camera.target.x, command->camera.target.y,
+                    command->camera.offset.x, command->camera.offset.y, command->camera.zoom);
+            break;
+        case DRAW_OP_CIRCLE:
+            fprintf(file, " center=(%g, %g) radius=%g", command->circle.center.x, command->circle.center.y, command->circle.radius);
+            break;
+        case DRAW_OP_LINE:
+            fprintf(file, " (%g, %g) -> (%g, %g)", command->line.start.x, command->line.start.y, command->line.end.x, command->line.end.y);
+            break;
+        case DRAW_OP_LINE_STRIP:
+            fprintf(file, " points=%i", command->lineStrip.count);
+            break;
+        case DRAW_OP_RECTANGLE:
+            fprintf(file, " (%g, %g, %g, %g)", command->rectangle.bounds.x, command->rectangle.bounds.y,
+                    command->rectangle.bounds.width, command->rectangle.bounds.height);
+            break;
+        case DRAW_OP_TEXTURE:
+            fprintf(file, " texture=%u dest=(%g, %g, %g, %g) rotation=%g", command->texture.texture.id,
+                    command->texture.dest.x, command->texture.dest.y, command->texture.dest.width, command->texture.dest.height,
+                    command->texture.rotation);
+            break;
+        case DRAW_OP_TEXT:
+            fprintf(file, " \"%s\" at (%i, %i) size=%i align=%i", list->text + command->text.offset, command->text.x,
+                    command->text.y, command->text.fontSize, command->text.align);
+            break;
+        case DRAW_OP_TRAJECTORIES_BEGIN:
+            fprintf(file, " halfWidth=%g", command->trajectories.halfWidth);
+            break;
+        case DRAW_OP_TRAJECTORY_CHUNK:
+            fprintf(file, " ship=%i chunk=%i segments=%i", command->trajectoryChunk.mesh, command->trajectoryChunk.chunk,
+                    command->trajectoryChunk.segmentCount);
+            break;
+        case DRAW_OP_SHIPS:
+            fprintf(file, " instances=%i", command->ships.count);
+            break;
+        case DRAW_OP_GRID:
+            fprintf(file, " tiles=%i halfWidth=%g alpha=%i", command->grid.count, command->grid.halfWidth, command->grid.colour.a);
+            break;
+        case DRAW_OP_HUD_TEXT:
+            fprintf(file, " \"%s\" at (%i, %i) size=%i align=%i", command->hudText.widget->text, command->hudText.x,
+                    command->hudText.y, command->hudText.fontSize, command->hudText.align);
+            break;
+        case DRAW_OP_HUD_LAYER:
+            fprintf(file, " commands=%i baked=%i", command->hudLayer->content.numCommands, command->hudLayer->baked);
+            break;
+        default:
+            break;
+        }
+        fputc('\n', file);
+    }
+}
@@ -0,0 +1,879 @@
+#include "fmm.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// M2L offsets between a box and its interaction list run from -3 to 3 boxes in each axis
+#define FMM_OFFSET_SPAN 7
+#define FMM_OFFSET_COUNT (FMM_OFFSET_SPAN * FMM_OFFSET_SPAN)
+// Boxes waiting on the walk below a leaf's colleagues - 8 colleagues' children, then at most 3 more per level
+#define FMM_WALK_CAPACITY (8 * 4 + 3 * FMM_MAX_LEVELS + 1)
+
+static double boxSize(int level)
+{
+    return ldexp(1.0, -level);
+}
+
+static double complex boxCenter(int level, int ix, int iy)
+{
+    double size = boxSize(level);
+    return ((ix + 0.5) * size) + ((iy + 0.5) * size) * I;
+}
+
+static double secondsNow(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void buildM2LOperators(fmmsolver_t *solver)
+{
+    /*
+        Multipole about a source box to local about a target box offset by z0:
+            L = |z0|^-1 * U A U^H,   U_lj = (-(j + 1/2) choose l) * c_j * z0^-(j + l)
+        Expansions are scaled by their box size, so offsets are measured in boxes and one U per offset serves every level
+    */
+    int p = solver->order;
+    for (int dy = -3; dy <= 3; dy++)
+    {
+        for (int dx = -3; dx <= 3; dx++)
+        {
+            int slot = (dy + 3) * FMM_OFFSET_SPAN + (dx + 3);
+            double complex *op = &solver->m2lOperators[(size_t)slot * p * p];
+            if (abs(dx) <= 1 && abs(dy) <= 1)
+            {
+                memset(op, 0, sizeof(double complex) * p * p);
+                solver->m2lInvDistance[slot] = 0.0;
+                continue;
+            }
+            double complex z0 = dx + dy * I;
+            double complex zinv = 1.0 / z0;
+            double complex powers[2 * FMM_MAX_ORDER];
+            powers[0] = 1.0;
+            for (int n = 1; n < 2 * p; n++)
+            {
+                powers[n] = powers[n - 1] * zinv;
+            }
+            for (int l = 0; l < p; l++)
+            {
+                for (int j = 0; j < p; j++)
+                {
+                    op[l * p + j] = solver->shiftCoeffs[j * p + l] * solver->kernelCoeffs[j] * powers[j + l];
+                }
+            }
+            solver->m2lInvDistance[slot] = 1.0 / cabs(z0);
+        }
+    }
+}
+
+fmmsolver_t *createFmmSolver(int order)
+{
+    fmmsolver_t *solver = calloc(1, sizeof(fmmsolver_t));
+    if (!solver)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate fmmsolver_t");
+        return NULL;
+    }
+    int p = order < 2 ? 2 : (order > FMM_MAX_ORDER ? FMM_MAX_ORDER : order);
+    solver->order = p;
+
+    int span = 2 * p;
+    solver->binomials = malloc(sizeof(double) * span * span);
+    solver->kernelCoeffs = malloc(sizeof(double) * p);
+    solver->shiftCoeffs = malloc(sizeof(double) * p * p);
+    solver->m2lOperators = malloc(sizeof(double complex) * FMM_OFFSET_COUNT * p * p);
+    solver->m2lInvDistance = malloc(sizeof(double) * FMM_OFFSET_COUNT);
+    solver->halfPowers = malloc(sizeof(double) * p);
+    if (!solver->binomials || !solver->kernelCoeffs || !solver->shiftCoeffs || !solver->m2lOperators ||
+        !solver->m2lInvDistance || !solver->halfPowers)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate FMM coefficient tables");
+        freeFmmSolver(solver);
+        return NULL;
+    }
+
+    for (int n = 0; n < span; n++)
+    {
+        for (int k = 0; k < span; k++)
+        {
+            double value = 0.0;
+            if (k == 0 || k == n)
+                value = (k <= n) ? 1.0 : 0.0;
+            else if (k < n)
+                value = solver->binomials[(n - 1) * span + k - 1] + solver->binomials[(n - 1) * span + k];
+            solver->binomials[n * span + k] = value;
+        }
+    }
+
+    // c_j = (2j choose j) / 4^j - series coefficients of (1 - u)^(-1/2)
+    solver->kernelCoeffs[0] = 1.0;
+    for (int j = 1; j < p; j++)
+    {
+        solver->kernelCoeffs[j] = solver->kernelCoeffs[j - 1] * (2.0 * j - 1.0) / (2.0 * j);
+    }
+
+    // (-(j + 1/2) choose l) - series coefficients of (1 + u)^-(j + 1/2), used when re-centering into a local expansion
+    for (int j = 0; j < p; j++)
+    {
+        double alpha = j + 0.5;
+        solver->shiftCoeffs[j * p] = 1.0;
+        for (int l = 1; l < p; l++)
+        {
+            solver->shiftCoeffs[j * p + l] = solver->shiftCoeffs[j * p + l - 1] * (-alpha - l + 1) / l;
+        }
+    }
+
+    // A child box is half its parent, so re-scaling an expansion between them weighs term (j, k) by 2^-(j + k)
+    solver->halfPowers[0] = 1.0;
+    for (int n = 1; n < p; n++)
+    {
+        solver->halfPowers[n] = solver->halfPowers[n - 1] * 0.5;
+    }
+
+    buildM2LOperators(solver);
+    return solver;
+}
+
+void freeFmmSolver(fmmsolver_t *solver)
+{
+    if (!solver)
+        return;
+    free(solver->multipoles);
+    free(solver->locals);
+    free(solver->m2lOperators);
+    free(solver->m2lInvDistance);
+    free(solver->binomials);
+    free(solver->kernelCoeffs);
+    free(solver->shiftCoeffs);
+    free(solver->halfPowers);
+    free(solver->nodes);
+    free(solver->keys);
+    free(solver->keyScratch);
+    free(solver->particleOrder);
+    free(solver->orderScratch);
+    free(solver->sorted);
+    free(solver->sortedMass);
+    free(solver->field);
+    free(solver->positions);
+    free(solver->masses);
+    free(solver->accelerations);
+    free(solver);
+}
+
+bool reserveFmmInputs(fmmsolver_t *solver, int count)
+{
+    // Kept on the solver so callers gathering positions every tick do not allocate every tick
+    if (count <= solver->allocatedInputs)
+        return true;
+    Vector2 *positions = realloc(solver->positions, sizeof(Vector2) * count);
+    if (positions)
+        solver->positions = positions;
+    float *masses = realloc(solver->masses, sizeof(float) * count);
+    if (masses)
+        solver->masses = masses;
+    Vector2 *accelerations = realloc(solver->accelerations, sizeof(Vector2) * count);
+    if (accelerations)
+        solver->accelerations = accelerations;
+    if (!positions || !masses || !accelerations)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate FMM input buffers for %i particles", count);
+        return false;
+    }
+    solver->allocatedInputs = count;
+    return true;
+}
+
+int fmmOrderForTolerance(float tolerance)
+{
+    if (tolerance <= 0.0f)
+        return FMM_MAX_ORDER;
+    int order = (int)ceilf(logf(tolerance) / logf(FMM_CONVERGENCE_RATIO));
+    if (order < 2)
+        order = 2;
+    if (order > FMM_MAX_ORDER)
+        order = FMM_MAX_ORDER;
+    return order;
+}
+
+static bool reserveFmmParticles(fmmsolver_t *solver, int count)
+{
+    if (count <= solver->allocatedParticles)
+        return true;
+    uint64_t *keys = realloc(solver->keys, sizeof(uint64_t) * count);
+    if (keys)
+        solver->keys = keys;
+    uint64_t *keyScratch = realloc(solver->keyScratch, sizeof(uint64_t) * count);
+    if (keyScratch)
+        solver->keyScratch = keyScratch;
+    int *particleOrder = realloc(solver->particleOrder, sizeof(int) * count);
+    if (particleOrder)
+        solver->particleOrder = particleOrder;
+    int *orderScratch = realloc(solver->orderScratch, sizeof(int) * count);
+    if (orderScratch)
+        solver->orderScratch = orderScratch;
+    double complex *sorted = realloc(solver->sorted, sizeof(double complex) * count);
+    if (sorted)
+        solver->sorted = sorted;
+    double *sortedMass = realloc(solver->sortedMass, sizeof(double) * count);
+    if (sortedMass)
+        solver->sortedMass = sortedMass;
+    double complex *field = realloc(solver->field, sizeof(double complex) * count);
+    if (field)
+        solver->field = field;
+    if (!keys || !keyScratch || !particleOrder || !orderScratch || !sorted || !sortedMass || !field)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate FMM particle buffers for %i particles", count);
+        return false;
+    }
+    solver->allocatedParticles = count;
+    return true;
+}
+
+static bool reserveFmmExpansions(fmmsolver_t *solver, int numNodes)
+{
+    if (numNodes <= solver->allocatedExpansions)
+        return true;
+    int p = solver->order;
+    double complex *multipoles = realloc(solver->multipoles, sizeof(double complex) * numNodes * p * p);
+    if (multipoles)
+        solver->multipoles = multipoles;
+    double complex *locals = realloc(solver->locals, sizeof(double complex) * numNodes * p * p);
+    if (locals)
+        solver->locals = locals;
+    if (!multipoles || !locals)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate FMM expansions for %i boxes", numNodes);
+        return false;
+    }
+    solver->allocatedExpansions = numNodes;
+    return true;
+}
+
+static void shiftMultipole(fmmsolver_t *solver, const double complex *child, double complex *parent, double complex s)
+{
+    // A_jk = sum_ab C(j,a) C(k,b) s^(j-a) conj(s)^(k-b) 2^-(a+b) A'_ab, applied one variable at a time
+    // s is the child center relative to the parent's, in parent box units
+    int p = solver->order;
+    int span = 2 * p;
+    double complex sp[FMM_MAX_ORDER], sbp[FMM_MAX_ORDER];
+    double complex temp[FMM_MAX_ORDER * FMM_MAX_ORDER];
+    sp[0] = 1.0;
+    sbp[0] = 1.0;
+    for (int n = 1; n < p; n++)
+    {
+        sp[n] = sp[n - 1] * s;
+        sbp[n] = sbp[n - 1] * conj(s);
+    }
+    for (int j = 0; j < p; j++)
+    {
+        for (int b = 0; b < p; b++)
+        {
+            double complex sum = 0.0;
+            for (int a = 0; a <= j; a++)
+            {
+                sum += solver->binomials[j * span + a] * sp[j - a] * solver->halfPowers[a] * child[a * p + b];
+            }
+            temp[j * p + b] = sum;
+        }
+    }
+    for (int j = 0; j < p; j++)
+    {
+        for (int k = 0; k < p; k++)
+        {
+            double complex sum = 0.0;
+            for (int b = 0; b <= k; b++)
+            {
+                sum += solver->binomials[k * span + b] * sbp[k - b] * solver->halfPowers[b] * temp[j * p + b];
+            }
+            parent[j * p + k] += sum;
+        }
+    }
+}
+
+static void translateMultipoleToLocal(fmmsolver_t *solver, const double complex *multipole, double complex *local, int slot, double size)
+{
+    // L += |z0|^-1 * U A U^H, with |z0| in box units and so divided by the box size
+    int p = solver->order;
+    const double complex *op = &solver->m2lOperators[(size_t)slot * p * p];
+    double invDistance = solver->m2lInvDistance[slot] / size;
+    double complex temp[FMM_MAX_ORDER * FMM_MAX_ORDER];
+    for (int j = 0; j < p; j++)
+    {
+        for (int m = 0; m < p; m++)
+        {
+            double complex sum = 0.0;
+            for (int k = 0; k < p; k++)
+            {
+                sum += multipole[j * p + k] * conj(op[m * p + k]);
+            }
+            temp[j * p + m] = sum;
+        }
+    }
+    for (int l = 0; l < p; l++)
+    {
+        for (int m = 0; m < p; m++)
+        {
+            double complex sum = 0.0;
+            for (int j = 0; j < p; j++)
+            {
+                sum += op[l * p + j] * temp[j * p + m];
+            }
+            local[l * p + m] += invDistance * sum;
+        }
+    }
+}
+
+static void shiftLocal(fmmsolver_t *solver, const double complex *parent, double complex *child, double complex d)
+{
+    // L'_ab = 2^-(a+b) sum_(l>=a, m>=b) C(l,a) C(m,b) d^(l-a) conj(d)^(m-b) L_lm
+    // d is the child center relative to the parent's, in parent box units
+    int p = solver->order;
+    int span = 2 * p;
+    double complex dp[FMM_MAX_ORDER], dbp[FMM_MAX_ORDER];
+    double complex temp[FMM_MAX_ORDER * FMM_MAX_ORDER];
+    dp[0] = 1.0;
+    dbp[0] = 1.0;
+    for (int n = 1; n < p; n++)
+    {
+        dp[n] = dp[n - 1] * d;
+        dbp[n] = dbp[n - 1] * conj(d);
+    }
+    for (int l = 0; l < p; l++)
+    {
+        for (int b = 0; b < p; b++)
+        {
+            double complex sum = 0.0;
+            for (int m = b; m < p; m++)
+            {
+                sum += solver->binomials[m * span + b] * dbp[m - b] * parent[l * p + m];
+            }
+            temp[l * p + b] = solver->halfPowers[b] * sum;
+        }
+    }
+    for (int a = 0; a < p; a++)
+    {
+        for (int b = 0; b < p; b++)
+        {
+            double complex sum = 0.0;
+            for (int l = a; l < p; l++)
+            {
+                sum += solver->binomials[l * span + a] * dp[l - a] * temp[l * p + b];
+            }
+            child[a * p + b] += solver->halfPowers[a] * sum;
+        }
+    }
+}
+
+static uint64_t spreadBits(uint32_t value)
+{
+    // Moves bit n of value to bit 2n
+    uint64_t x = value;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+static void sortParticlesByKey(fmmsolver_t *solver, int count)
+{
+    // LSD radix sort of keys and particle indices, a byte per pass
+    uint64_t *keys = solver->keys, *keysOut = solver->keyScratch;
+    int *order = solver->particleOrder, *orderOut = solver->orderScratch;
+    for (int shift = 0; shift < 2 * FMM_MAX_LEVELS; shift += 8)
+    {
+        int buckets[257] = {0};
+        for (int i = 0; i < count; i++)
+        {
+            buckets[((keys[i] >> shift) & 0xff) + 1]++;
+        }
+        for (int b = 0; b < 256; b++)
+        {
+            buckets[b + 1] += buckets[b];
+        }
+        for (int i = 0; i < count; i++)
+        {
+            int slot = buckets[(keys[i] >> shift) & 0xff]++;
+            keysOut[slot] = keys[i];
+            orderOut[slot] = order[i];
+        }
+        uint64_t *swapKeys = keys;
+        keys = keysOut;
+        keysOut = swapKeys;
+        int *swapOrder = order;
+        order = orderOut;
+        orderOut = swapOrder;
+    }
+    solver->keys = keys;
+    solver->keyScratch = keysOut;
+    solver->particleOrder = order;
+    solver->orderScratch = orderOut;
+}
+
+static int pushFmmNode(fmmsolver_t *solver, int level, int ix, int iy, int first, int count, int parent)
+{
+    if (solver->numNodes == solver->allocatedNodes)
+    {
+        int capacity = solver->allocatedNodes > 0 ? solver->allocatedNodes * 2 : 256;
+        fmmnode_t *nodes = realloc(solver->nodes, sizeof(fmmnode_t) * capacity);
+        if (!nodes)
+        {
+            TraceLog(LOG_ERROR, "Failed to allocate FMM tree for %i boxes", capacity);
+            return -1;
+        }
+        solver->nodes = nodes;
+        solver->allocatedNodes = capacity;
+    }
+    solver->nodes[solver->numNodes] = (fmmnode_t){
+        .level = level,
+        .ix = ix,
+        .iy = iy,
+        .first = first,
+        .count = count,
+        .parent = parent,
+        .children = {-1, -1, -1, -1},
+        .leaf = true};
+    return solver->numNodes++;
+}
+
+static void findColleagues(fmmsolver_t *solver, int index)
+{
+    // Colleagues are children of the parent's colleagues, so they exist once the level above is built
+    fmmnode_t *node = &solver->nodes[index];
+    node->numColleagues = 0;
+    if (node->parent < 0)
+    {
+        node->colleagues[node->numColleagues++] = index;
+        return;
+    }
+    fmmnode_t *parent = &solver->nodes[node->parent];
+    for (int q = 0; q < parent->numColleagues; q++)
+    {
+        fmmnode_t *uncle = &solver->nodes[parent->colleagues[q]];
+        for (int c = 0; c < 4; c++)
+        {
+            int child = uncle->children[c];
+            if (child < 0)
+                continue;
+            if (abs(solver->nodes[child].ix - node->ix) <= 1 && abs(solver->nodes[child].iy - node->iy) <= 1)
+                node->colleagues[node->numColleagues++] = child;
+        }
+    }
+}
+
+static bool buildFmmTree(fmmsolver_t *solver, int count)
+{
+    // Breadth first, so every box on a level exists before any box on that level looks for its colleagues
+    solver->numNodes = 0;
+    solver->levels = 0;
+    if (pushFmmNode(solver, 0, 0, 0, 0, count, -1) < 0)
+        return false;
+    for (int n = 0; n < solver->numNodes; n++)
+    {
+        findColleagues(solver, n);
+        fmmnode_t node = solver->nodes[n];
+        if (node.level > solver->levels)
+            solver->levels = node.level;
+        // Leaves at the depth cap keep however many particles share the box
+        if (node.count <= FMM_LEAF_SIZE || node.level == FMM_MAX_LEVELS)
+            continue;
+
+        // Keys are sorted, so each quadrant is a contiguous run
+        int shift = 2 * (FMM_MAX_LEVELS - node.level - 1);
+        int start = node.first, end = node.first + node.count;
+        for (int c = 0; c < 4; c++)
+        {
+            int stop = start;
+            while (stop < end && (int)((solver->keys[stop] >> shift) & 3) == c)
+                stop++;
+            if (stop > start)
+            {
+                int child = pushFmmNode(solver, node.level + 1, 2 * node.ix + (c & 1), 2 * node.iy + (c >> 1), start, stop - start, n);
+                if (child < 0)
+                    return false;
+                solver->nodes[n].children[c] = child;
+                solver->nodes[n].leaf = false;
+            }
+            start = stop;
+        }
+    }
+    return true;
+}
+
+static bool boxesTouch(const fmmnode_t *box, const fmmnode_t *other)
+{
+    // other is on the same level as box or deeper - touching includes corners
+    int shift = other->level - box->level;
+    int x0 = box->ix << shift, y0 = box->iy << shift;
+    int x1 = (box->ix + 1) << shift, y1 = (box->iy + 1) << shift;
+    return other->ix >= x0 - 1 && other->ix <= x1 && other->iy >= y0 - 1 && other->iy <= y1;
+}
+
+static double complex nodeCenter(const fmmnode_t *node)
+{
+    return boxCenter(node->level, node->ix, node->iy);
+}
+
+static void addDirectField(fmmsolver_t *solver, const fmmnode_t *target, const fmmnode_t *source, double cutoff2)
+{
+    for (int i = target->first; i < target->first + target->count; i++)
+    {
+        double zx = creal(solver->sorted[i]), zy = cimag(solver->sorted[i]);
+        double nearX = 0.0, nearY = 0.0;
+        for (int j = source->first; j < source->first + source->count; j++)
+        {
+            double dx = creal(solver->sorted[j]) - zx;
+            double dy = cimag(solver->sorted[j]) - zy;
+            double dist2 = dx * dx + dy * dy;
+            if (j == i || dist2 < cutoff2)
+                continue;
+            double mag = solver->sortedMass[j] / (dist2 * sqrt(dist2));
+            nearX += mag * dx;
+            nearY += mag * dy;
+        }
+        solver->field[i] += nearX + nearY * I;
+    }
+}
+
+static void addMultipoleField(fmmsolver_t *solver, const double complex *multipole, const fmmnode_t *box, const fmmnode_t *target)
+{
+    // phi = |z|^-1 sum c_j c_k A_jk (s/z)^j (s/conj(z))^k for box size s, so a_x + i a_y = 2 d(phi)/d(conj z) picks up
+    // -(k + 1/2) / conj(z)
+    int p = solver->order;
+    double complex center = nodeCenter(box);
+    double size = boxSize(box->level);
+    for (int i = target->first; i < target->first + target->count; i++)
+    {
+        double complex z = solver->sorted[i] - center;
+        double complex ratio = size / z;
+        double complex zp[FMM_MAX_ORDER], zbp[FMM_MAX_ORDER];
+        zp[0] = 1.0;
+        zbp[0] = 1.0;
+        for (int n = 1; n < p; n++)
+        {
+            zp[n] = zp[n - 1] * ratio;
+            zbp[n] = zbp[n - 1] * conj(ratio);
+        }
+        double complex accel = 0.0;
+        for (int j = 0; j < p; j++)
+        {
+            for (int k = 0; k < p; k++)
+            {
+                accel += solver->kernelCoeffs[j] * solver->kernelCoeffs[k] * (k + 0.5) * multipole[j * p + k] * zp[j] * zbp[k];
+            }
+        }
+        solver->field[i] -= 2.0 * accel / (cabs(z) * conj(z));
+    }
+}
+
+static void addParticlesToLocal(fmmsolver_t *solver, const fmmnode_t *source, double complex *local, const fmmnode_t *box)
+{
+    // 1/|z - t| = |z|^-1 sum c_j c_k (t/z)^j (conj(t)/conj(z))^k about the box center, with z the source offset and t
+    // in box units
+    int p = solver->order;
+    double complex center = nodeCenter(box);
+    double size = boxSize(box->level);
+    for (int i = source->first; i < source->first + source->count; i++)
+    {
+        double complex z = solver->sorted[i] - center;
+        double complex ratio = size / z;
+        double complex zp[FMM_MAX_ORDER], zbp[FMM_MAX_ORDER];
+        zp[0] = solver->sortedMass[i] / cabs(z);
+        zbp[0] = 1.0;
+        for (int n = 1; n < p; n++)
+        {
+            zp[n] = zp[n - 1] * ratio;
+            zbp[n] = zbp[n - 1] * conj(ratio);
+        }
+        for (int j = 0; j < p; j++)
+        {
+            for (int k = 0; k < p; k++)
+            {
+                local[j * p + k] += solver->kernelCoeffs[j] * solver->kernelCoeffs[k] * zp[j] * zbp[k];
+            }
+        }
+    }
+}
+
+static void addLeafInteractions(fmmsolver_t *solver, int index, double cutoff2)
+{
+    /*
+        Touching leaves are summed directly. Below a colleague, boxes that do not touch this leaf but whose parent does
+        are its W list - their multipole is evaluated at this leaf's particles, and this leaf is in their X list, so
+        its particles go straight into their local expansion. Deeper touching leaves never reach this leaf from their
+        own colleagues, so both directions of the direct sum are added here
+    */
+    int p = solver->order;
+    size_t coeffs = (size_t)p * p;
+    const fmmnode_t *leaf = &solver->nodes[index];
+    int walk[FMM_WALK_CAPACITY];
+    int numWalk = 0;
+    for (int q = 0; q < leaf->numColleagues; q++)
+    {
+        const fmmnode_t *colleague = &solver->nodes[leaf->colleagues[q]];
+        if (colleague->leaf)
+        {
+            addDirectField(solver, leaf, colleague, cutoff2);
+            continue;
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            if (colleague->children[c] >= 0)
+                walk[numWalk++] = colleague->children[c];
+        }
+    }
+    while (numWalk > 0)
+    {
+        int next = walk[--numWalk];
+        const fmmnode_t *box = &solver->nodes[next];
+        if (!boxesTouch(leaf, box))
+        {
+            addMultipoleField(solver, &solver->multipoles[next * coeffs], box, leaf);
+            addParticlesToLocal(solver, leaf, &solver->locals[next * coeffs], box);
+        }
+        else if (box->leaf)
+        {
+            addDirectField(solver, leaf, box, cutoff2);
+            addDirectField(solver, box, leaf, cutoff2);
+        }
+        else
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                if (box->children[c] >= 0)
+                    walk[numWalk++] = box->children[c];
+            }
+        }
+    }
+}
+
+bool solveFmmGravity(fmmsolver_t *solver, const Vector2 *positions, const float *masses, int count, Vector2 *accelerations)
+{
+    // Returns false without touching accelerations when the tree cannot be allocated, for the caller to sum directly
+    if (count <= 0)
+        return true;
+    int p = solver->order;
+    size_t coeffs = (size_t)p * p;
+
+    // Normalise into the unit square so coefficient powers stay well inside double range
+    double minX = positions[0].x, maxX = minX, minY = positions[0].y, maxY = minY;
+    for (int i = 1; i < count; i++)
+    {
+        minX = fmin(minX, positions[i].x);
+        maxX = fmax(maxX, positions[i].x);
+        minY = fmin(minY, positions[i].y);
+        maxY = fmax(maxY, positions[i].y);
+    }
+    double size = fmax(maxX - minX, maxY - minY) * (1.0 + 1e-6);
+    if (size <= 0.0)
+        size = 1.0;
+
+    if (!reserveFmmParticles(solver, count))
+        return false;
+    solver->numParticles = count;
+
+    // Morton keys at the deepest level put every box's particles in one contiguous run
+    int side = 1 << FMM_MAX_LEVELS;
+    for (int i = 0; i < count; i++)
+    {
+        int ix = (int)((positions[i].x - minX) / size * side);
+        int iy = (int)((positions[i].y - minY) / size * side);
+        ix = ix < 0 ? 0 : (ix >= side ? side - 1 : ix);
+        iy = iy < 0 ? 0 : (iy >= side ? side - 1 : iy);
+        solver->keys[i] = spreadBits((uint32_t)ix) | (spreadBits((uint32_t)iy) << 1);
+        solver->particleOrder[i] = i;
+    }
+    sortParticlesByKey(solver, count);
+    for (int i = 0; i < count; i++)
+    {
+        int source = solver->particleOrder[i];
+        solver->sorted[i] = (positions[source].x - minX) / size + ((positions[source].y - minY) / size) * I;
+        solver->sortedMass[i] = masses[source];
+    }
+
+    if (!buildFmmTree(solver, count) || !reserveFmmExpansions(solver, solver->numNodes))
+        return false;
+    int numNodes = solver->numNodes;
+    fmmnode_t *nodes = solver->nodes;
+    memset(solver->multipoles, 0, sizeof(double complex) * numNodes * coeffs);
+    memset(solver->locals, 0, sizeof(double complex) * numNodes * coeffs);
+    memset(solver->field, 0, sizeof(double complex) * count);
+
+    // P2M - A_jk = sum m w^j conj(w)^k about each leaf center, with w in box units
+    for (int n = 0; n < numNodes; n++)
+    {
+        if (!nodes[n].leaf)
+            continue;
+        double complex center = nodeCenter(&nodes[n]);
+        double size = boxSize(nodes[n].level);
+        double complex *multipole = &solver->multipoles[n * coeffs];
+        for (int i = nodes[n].first; i < nodes[n].first + nodes[n].count; i++)
+        {
+            double complex w = (solver->sorted[i] - center) / size;
+            double complex wp[FMM_MAX_ORDER], wbp[FMM_MAX_ORDER];
+            wp[0] = solver->sortedMass[i];
+            wbp[0] = 1.0;
+            for (int k = 1; k < p; k++)
+            {
+                wp[k] = wp[k - 1] * w;
+                wbp[k] = wbp[k - 1] * conj(w);
+            }
+            for (int j = 0; j < p; j++)
+            {
+                for (int k = 0; k < p; k++)
+                {
+                    multipole[j * p + k] += wp[j] * wbp[k];
+                }
+            }
+        }
+    }
+
+    // M2M - upward pass, children into parents. Children always follow their parent, so walk backwards
+    for (int n = numNodes - 1; n > 0; n--)
+    {
+        int parent = nodes[n].parent;
+        shiftMultipole(solver, &solver->multipoles[n * coeffs], &solver->multipoles[parent * coeffs],
+                       (nodeCenter(&nodes[n]) - nodeCenter(&nodes[parent])) / boxSize(nodes[parent].level));
+    }
+
+    // M2L - V list is the children of the parent's colleagues that do not touch the box. Colleagues of the parent
+    // that are leaves have no children here and reach the box through the X list instead
+    for (int n = 1; n < numNodes; n++)
+    {
+        const fmmnode_t *box = &nodes[n];
+        const fmmnode_t *parent = &nodes[box->parent];
+        for (int q = 0; q < parent->numColleagues; q++)
+        {
+            const fmmnode_t *uncle = &nodes[parent->colleagues[q]];
+            for (int c = 0; c < 4; c++)
+            {
+                int source = uncle->children[c];
+                if (source < 0 || boxesTouch(box, &nodes[source]))
+                    continue;
+                int slot = (box->iy - nodes[source].iy + 3) * FMM_OFFSET_SPAN + (box->ix - nodes[source].ix + 3);
+                translateMultipoleToLocal(solver, &solver->multipoles[source * coeffs], &solver->locals[n * coeffs], slot,
+                                          boxSize(box->level));
+            }
+        }
+    }
+
+    // U, W and X lists, which only leaves have
+    double cutoff2 = 1e-10 / (size * size);
+    for (int n = 0; n < numNodes; n++)
+    {
+        if (nodes[n].leaf)
+            addLeafInteractions(solver, n, cutoff2);
+    }
+
+    // L2L - downward pass, parents into children. Parents always come first
+    for (int n = 1; n < numNodes; n++)
+    {
+        int parent = nodes[n].parent;
+        shiftLocal(solver, &solver->locals[parent * coeffs], &solver->locals[n * coeffs],
+                   (nodeCenter(&nodes[n]) - nodeCenter(&nodes[parent])) / boxSize(nodes[parent].level));
+    }
+
+    // Evaluate - far field from the local expansion plus the direct and multipole field gathered above
+    double scale = G / (size * size);
+    for (int n = 0; n < numNodes; n++)
+    {
+        if (!nodes[n].leaf)
+            continue;
+        double complex center = nodeCenter(&nodes[n]);
+        double size = boxSize(nodes[n].level);
+        const double complex *local = &solver->locals[n * coeffs];
+        for (int i = nodes[n].first; i < nodes[n].first + nodes[n].count; i++)
+        {
+            double complex t = (solver->sorted[i] - center) / size;
+            double complex tp[FMM_MAX_ORDER], tbp[FMM_MAX_ORDER];
+            tp[0] = 1.0;
+            tbp[0] = 1.0;
+            for (int k = 1; k < p; k++)
+            {
+                tp[k] = tp[k - 1] * t;
+                tbp[k] = tbp[k - 1] * conj(t);
+            }
+            // a_x + i a_y = 2 d(phi)/d(conj t), and t is in box units
+            double complex accel = 0.0;
+            for (int l = 0; l < p; l++)
+            {
+                for (int m = 1; m < p; m++)
+                {
+                    accel += m * local[l * p + m] * tp[l] * tbp[m - 1];
+                }
+            }
+            accel = 2.0 * accel / size + solver->field[i];
+
+            accelerations[solver->particleOrder[i]] = (Vector2){
+                (float)(scale * creal(accel)),
+                (float)(scale * cimag(accel))};
+        }
+    }
+    return true;
+}
+
+void solveDirectGravity(const Vector2 *positions, const float *masses, int count, Vector2 *accelerations)
+{
+    for (int i = 0; i < count; i++)
+    {
+        double ax = 0.0, ay = 0.0;
+        for (int j = 0; j < count; j++)
+        {
+            double dx = (double)positions[j].x - positions[i].x;
+            double dy = (double)positions[j].y - positions[i].y;
+            double dist = sqrt(dx * dx + dy * dy);
+            if (j == i || dist < 1e-5)
+                continue;
+            double mag = G * masses[j] / (dist * dist * dist);
+            ax += mag * dx;
+            ay += mag * dy;
+        }
+        accelerations[i] = (Vector2){(float)ax, (float)ay};
+    }
+}
+
+fmmaccuracy_t compareFmmToDirect(fmmsolver_t *solver, const Vector2 *positions, const float *masses, int count)
+{
+    fmmaccuracy_t accuracy = {0};
+    Vector2 *fmm = malloc(sizeof(Vector2) * count);
+    Vector2 *direct = malloc(sizeof(Vector2) * count);
+    if (!fmm || !direct)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate FMM comparison buffers");
+        free(fmm);
+        free(direct);
+        return accuracy;
+    }
+
+    double start = secondsNow();
+    if (!solveFmmGravity(solver, positions, masses, count, fmm))
+        solveDirectGravity(positions, masses, count, fmm);
+    accuracy.fmmSeconds = secondsNow() - start;
+
+    start = secondsNow();
+    solveDirectGravity(positions, masses, count, direct);
+    accuracy.directSeconds = secondsNow() - start;
+
+    double sumSquares = 0.0;
+    int compared = 0;
+    for (int i = 0; i < count; i++)
+    {
+        double reference = hypot(direct[i].x, direct[i].y);
+        if (reference <= 0.0)
+            continue;
+        double error = hypot(fmm[i].x - direct[i].x, fmm[i].y - direct[i].y) / reference;
+        sumSquares += error * error;
+        if (error > accuracy.maxError)
+            accuracy.maxError = (float)error;
+        compared++;
+    }
+    if (compared > 0)
+        accuracy.rmsError = (float)sqrt(sumSquares / compared);
+
+    free(fmm);
+    free(direct);
+    return accuracy;
+}
@@ -0,0 +1,213 @@
+#include "grid.h"
+
+// Spacing of each band and the lowest zoom it is the main band for, finest first
+static const struct
+{
+    float spacing;
+    float minZoom;
+} gridBands[GRID_BAND_COUNT] = {
+    {1e5f, 0.002f},
+    {1e6f, 0.0002f},
+    {1e7f, 0.00002f},
+    {1e8f, 0.000001f},
+    {1e9f, 0.0f}};
+
+static const char *gridVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec3 vertexNormal;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "uniform float halfWidth;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 world = instanceTransform * vec4(vertexPosition, 1.0);\n"
+    "    gl_Position = mvp * vec4(world.xy + vertexNormal.xy * halfWidth, world.z, 1.0);\n"
+    "}\n";
+
+static const char *gridFragmentShader =
+    "#version 330\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    finalColor = colDiffuse;\n"
+    "}\n";
+
+gridrenderer_t *createGridRenderer(void)
+{
+    // GPU objects are created on first replay, so the grid can be recorded without a window
+    gridrenderer_t *renderer = malloc(sizeof(gridrenderer_t));
+    if (!renderer)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate gridrenderer_t");
+        return NULL;
+    }
+    renderer->loaded = false;
+    return renderer;
+}
+
+void freeGridRenderer(gridrenderer_t *renderer)
+{
+    if (!renderer)
+        return;
+    if (renderer->loaded)
+    {
+        // Also unloads the custom shader
+        UnloadMaterial(renderer->material);
+        UnloadMesh(renderer->tile);
+    }
+    free(renderer);
+}
+
+static void addGridLine(float **v, float **n, Vector2 a, Vector2 b)
+{
+    // Same quad layout as a trajectory segment - A-n, A+n, B+n and A-n, B+n, B-n
+    Vector2 dir = Vector2Normalize(Vector2Subtract(b, a));
+    Vector2 perp = {-dir.y, dir.x};
+    Vector2 corners[6] = {a, a, b, a, b, b};
+    float sides[6] = {-1, 1, 1, -1, 1, -1};
+    for (int k = 0; k < 6; k++)
+    {
+        *(*v)++ = corners[k].x;
+        *(*v)++ = corners[k].y;
+        *(*v)++ = 0.0f;
+        *(*n)++ = perp.x * sides[k];
+        *(*n)++ = perp.y * sides[k];
+        *(*n)++ = 0.0f;
+    }
+}
+
+static void loadGridRenderer(gridrenderer_t *renderer)
+{
+    renderer->shader = LoadShaderFromMemory(gridVertexShader, gridFragmentShader);
+    renderer->halfWidthLoc = GetShaderLocation(renderer->shader, "halfWidth");
+    renderer->material = LoadMaterialDefault();
+    renderer->material.shader = renderer->shader;
+
+    // Each tile owns the lines on its left and top edges, so neighbouring tiles never draw a line twice
+    Mesh tile = {0};
+    int numLines = GRID_TILE_CELLS * 2;
+    tile.vertexCount = numLines * 6;
+    tile.triangleCount = numLines * 2;
+    tile.vertices = MemAlloc(sizeof(float) * 3 * tile.vertexCount);
+    tile.normals = MemAlloc(sizeof(float) * 3 * tile.vertexCount);
+    float *v = tile.vertices;
+    float *n = tile.normals;
+    for (int i = 0; i < GRID_TILE_CELLS; i++)
+    {
+        addGridLine(&v, &n, (Vector2){i, 0}, (Vector2){i, GRID_TILE_CELLS});
+        addGridLine(&v, &n, (Vector2){0, i}, (Vector2){GRID_TILE_CELLS, i});
+    }
+    UploadMesh(&tile, false);
+    renderer->tile = tile;
+    renderer->loaded = true;
+}
+
+static float gridFade(float zoom, float from, float to)
+{
+    // 0 at zoom == from, 1 at zoom == to, eased in log space so it takes the same scroll in either direction
+    float t = logf(zoom / from) / logf(to / from);
+    return Clamp(t, 0.0f, 1.0f);
+}
+
+static void recordGridBand(drawlist_t *list, gridrenderer_t *renderer, int band, float alpha, Rectangle view, float halfWidth, Color colour)
+{
+    if (alpha <= 0.0f)
+        return;
+
+    float spacing = gridBands[band].spacing;
+    float tileSize = spacing * GRID_TILE_CELLS;
+    int firstX = (int)floorf(view.x / tileSize);
+    int firstY = (int)floorf(view.y / tileSize);
+    int tilesX = (int)floorf((view.x + view.width) / tileSize) - firstX + 1;
+    int tilesY = (int)floorf((view.y + view.height) / tileSize) - firstY + 1;
+    if (tilesX * tilesY > GRID_MAX_TILES)
+    {
+        TraceLog(LOG_WARNING, "Grid band %i needs %i tiles, skipping", band, tilesX * tilesY);
+        return;
+    }
+
+    int first;
+    Matrix *tiles = pushDrawInstances(list, tilesX * tilesY, &first);
+    if (!tiles)
+        return;
+    Matrix scale = MatrixScale(spacing, spacing, 1.0f);
+    for (int y = 0; y < tilesY; y++)
+    {
+        for (int x = 0; x < tilesX; x++)
+        {
+            tiles[y * tilesX + x] = MatrixMultiply(scale, MatrixTranslate((firstX + x) * tileSize, (firstY + y) * tileSize, 0.0f));
+        }
+    }
+
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_GRID);
+    if (command)
+    {
+        command->grid.renderer = renderer;
+        command->grid.first = first;
+        command->grid.count = tilesX * tilesY;
+        command->grid.halfWidth = halfWidth;
+        command->grid.colour = Fade(colour, alpha * colour.a / 255.0f);
+    }
+}
+
+void drawCelestialGrid(drawlist_t *list, gridrenderer_t *renderer, Camera2D camera, Rectangle view, float density, ColourScheme *colourScheme)
+{
+    /*
+        Draws a grid with origin (0, 0) to the edges of visible space
+        The grid should scale with the camera to demonstrate distance and velocity
+    */
+
+    // Do not draw grid when zoomed in - judged on the real zoom, so density never changes where the grid disappears
+    if (camera.zoom >= GRID_MAX_ZOOM)
+        return;
+
+    // Bands are picked as if zoomed out by density, so a lower density switches to coarser spacing sooner
+    float zoom = camera.zoom * density;
+
+    int band = 0;
+    while (band < GRID_BAND_COUNT - 1 && zoom < gridBands[band].minZoom)
+    {
+        band++;
+    }
+    float minZoom = gridBands[band].minZoom;
+    float halfWidth = GRID_LINE_PIXELS / 2 / camera.zoom;
+    Color colour = colourScheme->gridColour;
+
+    // Approaching the next finer band, fade it in over the main band - or fade the whole grid out approaching the cutoff
+    if (band == 0)
+    {
+        float hidden = gridFade(camera.zoom, GRID_MAX_ZOOM / GRID_FADE_FACTOR, GRID_MAX_ZOOM);
+        recordGridBand(list, renderer, band, 1.0f - hidden, view, halfWidth, colour);
+    }
+    else
+    {
+        float maxZoom = gridBands[band - 1].minZoom;
+        float finer = gridFade(zoom, maxZoom / GRID_FADE_FACTOR, maxZoom);
+        recordGridBand(list, renderer, band, 1.0f, view, halfWidth, colour);
+        recordGridBand(list, renderer, band - 1, finer, view, halfWidth, colour);
+    }
+
+    // Just after a switch, keep the coarser band and fade it out so its lines do not vanish in one frame
+    if (band + 1 < GRID_BAND_COUNT)
+    {
+        float coarser = 1.0f - gridFade(zoom, minZoom, minZoom * GRID_FADE_FACTOR);
+        recordGridBand(list, renderer, band + 1, coarser, view, halfWidth, colour);
+    }
+}
+
+void replayGrid(gridrenderer_t *renderer, const Matrix *tiles, int count, float halfWidth, Color colour)
+{
+    if (!renderer->loaded)
+    {
+        loadGridRenderer(renderer);
+    }
+    SetShaderValue(renderer->shader, renderer->halfWidthLoc, &halfWidth, SHADER_UNIFORM_FLOAT);
+    renderer->material.maps[MATERIAL_MAP_DIFFUSE].color = colour;
+
+    // Switching shader flushes the pending 2D batch
+    BeginShaderMode(renderer->shader);
+    DrawMeshInstanced(renderer->tile, renderer->material, tiles, count);
+    EndShaderMode();
+}
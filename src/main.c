@@ -8,6 +8,15 @@
 #include "game.h"
 #include "rendering.h"
 #include "ui.h"
+#include "spatial.h"
+#include "trajectory.h"
+#include "shiprenderer.h"
+#include "grid.h"
+#include "quality.h"
+#include "residency.h"
+#include "procedural.h"
+#include "simulation.h"
+#include "save.h"
 
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
@@ -22,6 +31,8 @@ int main(void)
     InitWindow(screenWidth, screenHeight, "Gravity Assist");
     SetTargetFPS(targetFPS);
     SetExitKey(0);
+    initAssetLoader();
+    loadSpriteAtlas();
 
     int wMid = screenWidth / 2;
     int hMid = screenHeight / 2;
@@ -59,12 +70,13 @@ int main(void)
         .min = 1.0f,
         .max = 64.0f};
 
+    // Streamed in - the HUD draws the placeholder until they are uploaded
+    requestTextureById(TEXTURE_HUD_COMPASS);
+    requestTextureById(TEXTURE_HUD_ARROW);
     HUD playerHUD = {
         .speed = 0.0f,
-        .compassTexture = LoadTexture("assets/hud/compass.png"),
-        .arrowTexture = LoadTexture("assets/hud/arrow_2.png")};
-
-    Texture2D shipLogo = LoadTexture("assets/icons/logo_ship.png");
+        .compassTexture = getTextureById(TEXTURE_HUD_COMPASS),
+        .arrowTexture = getTextureById(TEXTURE_HUD_ARROW)};
 
     gameState.gameTime = 0.0f;
 
@@ -85,32 +97,55 @@ int main(void)
     camera.target = (Vector2){0, 0};
     camera.offset = (Vector2){wMid, hMid}; // Offset from camera target
 
-    int velocityLock = 0;
-    celestialbody_t *velocityTarget = NULL;
+    // The simulation thread owns gameState once started - this thread only sees snapshots through the mirror
+    simulation_t *sim = NULL;
+    simsnapshot_t *snapshot = NULL;
+    simmirror_t mirror = {0};
+
+    trajectoryrenderer_t *trajectoryRenderer = createTrajectoryRenderer();
+    shiprenderer_t *shipRenderer = createShipRenderer();
+    gridrenderer_t *gridRenderer = createGridRenderer();
+
+    spatialindex_t *spatialIndex = createSpatialIndex(SPATIAL_NODE_CAPACITY);
+    spatialquery_t spatialQuery = createSpatialQuery(SPATIAL_QUERY_CAPACITY);
+    renderview_t renderView = createRenderView();
+    drawlist_t drawList = createDrawList();
+
+    // Holds the frame and tick inside their budgets by trading off the knobs below - F3 shows them, F4 freezes them
+    qualitygovernor_t quality;
+    initQualityGovernor(&quality, targetFPS, SIM_TICK_RATE);
 
     while (!WindowShouldClose())
     {
-        float dt = GetFrameTime();
-
         switch (screenState)
         {
         case GAME_HOME:
             if (IsKeyPressed(KEY_ENTER) && !IsKeyDown(KEY_LEFT_SHIFT))
             {
                 initNewGame(&gameState);
+                sim = createSimulation(&gameState, timeScale);
+                if (!sim)
+                {
+                    CloseWindow();
+                    return 1;
+                }
                 screenState = GAME_RUNNING;
-                velocityTarget = gameState.bodies[0];
             }
 
             if (IsKeyPressed(KEY_ENTER) && IsKeyDown(KEY_LEFT_SHIFT)) {
-                if (!loadGame("gas_save_1.dat", &gameState)) {
+                if (!loadGame(getNewestSave(SAVE_PATH, AUTOSAVE_PATH), &gameState)) {
                     printf("could not load saved game");
                     CloseWindow();
                     return 0;
                 }
                 printf("loading saved game\n");
+                sim = createSimulation(&gameState, timeScale);
+                if (!sim)
+                {
+                    CloseWindow();
+                    return 1;
+                }
                 screenState = GAME_RUNNING;
-                velocityTarget = gameState.bodies[0];
             }
 
             if (IsKeyPressed(KEY_Q))
@@ -121,121 +156,149 @@ int main(void)
             break;
 
         case GAME_RUNNING:
+        {
+            // Held keys go to the simulation as a bitmask it reads every tick
+            unsigned int input = 0;
             if (IsKeyDown(KEY_PERIOD))
-                incrementWarp(&timeScale, dt);
+                input |= SIM_INPUT_WARP_UP;
             if (IsKeyDown(KEY_COMMA))
-                decrementWarp(&timeScale, dt);
-
-            float scaledDt = dt * timeScale.val;
-
-            gameState.gameTime += scaledDt;
-
-            if (IsKeyPressed(KEY_ESCAPE))
-            {
-                screenState = GAME_PAUSED;
-            }
-
-            if (IsKeyPressed(KEY_C))
-            {
-                gameState.ships[cameraLock]->isSelected = false;
-                cameraLock++;
-                cameraLock = cameraLock % gameState.numShips;
-                cameraLockPosition = &gameState.ships[cameraLock]->position;
-                gameState.ships[cameraLock]->isSelected = true;
-            }
-
+                input |= SIM_INPUT_WARP_DOWN;
             if (IsKeyDown(KEY_LEFT_SHIFT))
-            {
-                handleThrottle(gameState.ships, gameState.numShips, scaledDt, THROTTLE_UP);
-            }
+                input |= SIM_INPUT_THROTTLE_UP;
             if (IsKeyDown(KEY_LEFT_CONTROL))
-            {
-                handleThrottle(gameState.ships, gameState.numShips, scaledDt, THROTTLE_DOWN);
-            }
-
-            // Sets engine texture and resets thruster flags before input
-            updateShipTextureFlags(gameState.ships, gameState.numShips);
-
+                input |= SIM_INPUT_THROTTLE_DOWN;
             if (IsKeyDown(KEY_D))
-            {
-                handleRotation(gameState.ships, gameState.numShips, scaledDt, ROTATION_RIGHT);
-            }
+                input |= SIM_INPUT_ROTATE_RIGHT;
             if (IsKeyDown(KEY_A))
-            {
-                handleRotation(gameState.ships, gameState.numShips, scaledDt, ROTATION_LEFT);
-            }
+                input |= SIM_INPUT_ROTATE_LEFT;
             if (IsKeyDown(KEY_E))
-            {
-                handleThruster(gameState.ships, gameState.numShips, scaledDt, THRUSTER_RIGHT);
-            }
+                input |= SIM_INPUT_THRUSTER_RIGHT;
             if (IsKeyDown(KEY_Q))
-            {
-                handleThruster(gameState.ships, gameState.numShips, scaledDt, THRUSTER_LEFT);
-            }
+                input |= SIM_INPUT_THRUSTER_LEFT;
             if (IsKeyDown(KEY_W))
-            {
-                handleThruster(gameState.ships, gameState.numShips, scaledDt, THRUSTER_UP);
-            }
+                input |= SIM_INPUT_THRUSTER_UP;
             if (IsKeyDown(KEY_S))
+                input |= SIM_INPUT_THRUSTER_DOWN;
+            if (IsKeyDown(KEY_X))
+                input |= SIM_INPUT_CUT_ENGINES;
+            setSimInput(sim, input);
+
+            if (IsKeyPressed(KEY_ESCAPE))
             {
-                handleThruster(gameState.ships, gameState.numShips, scaledDt, THRUSTER_DOWN);
+                screenState = GAME_PAUSED;
+                setSimInput(sim, 0);
+                sendSimCommand(sim, SIM_COMMAND_PAUSE, 0);
             }
-            if (IsKeyDown(KEY_X))
+
+            if (IsKeyPressed(KEY_C))
             {
-                cutEngines(gameState.ships, gameState.numShips);
+                cameraLock++;
+                cameraLock = cameraLock % mirror.numShips;
+                sendSimCommand(sim, SIM_COMMAND_SELECT_SHIP, cameraLock);
             }
 
             if (IsKeyPressed(KEY_T))
             {
-                toggleDrawTrajectory(gameState.ships, gameState.numShips);
+                sendSimCommand(sim, SIM_COMMAND_TOGGLE_TRAJECTORY, 0);
             }
 
-            if (IsKeyPressed(KEY_V))
+            if (IsKeyPressed(KEY_G))
             {
-                velocityLock++;
-                velocityLock = velocityLock % gameState.numBodies;
-                velocityTarget = gameState.bodies[velocityLock];
+                sendSimCommand(sim, SIM_COMMAND_TOGGLE_MUTUAL_GRAVITY, 0);
             }
 
-            cameraLockPosition = &gameState.ships[cameraLock]->position;
-            camera.target = *cameraLockPosition;
+            if (IsKeyPressed(KEY_V))
+            {
+                // Cycle Auto -> the bodies nearest the selected ship, closest first -> Auto
+                sendSimCommand(sim, SIM_COMMAND_CYCLE_VELOCITY_LOCK, 0);
+            }
 
             camera.zoom += (float)GetMouseWheelMove() * (1e-5f + camera.zoom * (camera.zoom / 4.0f));
             camera.zoom = Clamp(camera.zoom, cameraSettings.minZoom, cameraSettings.maxZoom);
 
-            updateCelestialPositions(gameState.bodies, gameState.numBodies, gameState.gameTime);
-            updateShipPositions(gameState.ships, gameState.numShips, gameState.bodies, gameState.numBodies, scaledDt);
-
-            updateLandedShipPosition(gameState.ships, gameState.numShips, gameState.gameTime);
-
-            detectCollisions(gameState.ships, gameState.numShips, gameState.bodies, gameState.numBodies, gameState.gameTime);
-            calculateShipFuturePositions(gameState.ships, gameState.numShips, gameState.bodies, gameState.numBodies, gameState.gameTime);
-
-            playerHUD.speed = calculateRelativeSpeed(gameState.ships[0], velocityTarget, gameState.gameTime);
-            playerHUD.playerRotation = gameState.ships[0]->rotation;
-            playerHUD.velocityTarget = velocityTarget;
-
+            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                // Click a ship to lock the camera to it, or a body to lock velocity to it
+                // The index was built from last frame's mirror, which is exactly what was clicked on
+                Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), camera);
+                spatialentry_t *picked = pickSpatialEntry(spatialIndex, mouseWorld, PICK_RADIUS / camera.zoom, &spatialQuery);
+                if (picked != NULL && picked->type == SPATIAL_SHIP)
+                {
+                    cameraLock = picked->index;
+                    sendSimCommand(sim, SIM_COMMAND_SELECT_SHIP, cameraLock);
+                }
+                else if (picked != NULL && picked->type == SPATIAL_BODY)
+                {
+                    sendSimCommand(sim, SIM_COMMAND_VELOCITY_LOCK, picked->index);
+                }
+            }
             break;
+        }
 
         case GAME_PAUSED:
             if (IsKeyPressed(KEY_ESCAPE))
             {
                 screenState = GAME_RUNNING;
+                sendSimCommand(sim, SIM_COMMAND_RESUME, 0);
             }
 
             if (IsKeyPressed(KEY_S))
             {
-                saveGame("gas_save_1.dat", &gameState);
+                // Captured on the simulation thread, which owns the state, and written in the background
+                sendSimCommand(sim, SIM_COMMAND_SAVE, 0);
             }
 
             if (IsKeyPressed(KEY_Q))
             {
+                freeSimulation(sim);
                 CloseWindow();
                 return 0; // Quit from pause menu
             }
             break;
         }
 
+        if (screenState != GAME_HOME)
+        {
+            if (IsKeyPressed(KEY_F3))
+                quality.overlay = !quality.overlay;
+            if (IsKeyPressed(KEY_F4))
+                quality.enabled = !quality.enabled;
+        }
+
+        if (sim != NULL)
+        {
+            // Draw the newest finished tick, interpolated up to now
+            snapshot = acquireSimSnapshot(sim);
+            updateSimMirror(&mirror, snapshot, getSimClock());
+            buildSpatialIndex(spatialIndex, mirror.bodies, mirror.numBodies, mirror.ships, mirror.numShips);
+
+            // The HUD follows the selected ship, the one the camera is locked to and the controls steer
+            ship_t *lockedShip = mirror.ships[cameraLock];
+            cameraLockPosition = &lockedShip->position;
+            camera.target = *cameraLockPosition;
+
+            playerHUD.speed = snapshot->relativeSpeed;
+            playerHUD.playerRotation = lockedShip->rotation;
+            playerHUD.velocityTarget = getBodyPtr(snapshot->velocityTarget, mirror.bodies, mirror.numBodies);
+            playerHUD.velocityAuto = snapshot->velocityAuto;
+            playerHUD.cameraLock = cameraLock;
+            playerHUD.timeScale = snapshot->timeScale;
+            playerHUD.zoom = camera.zoom;
+            playerHUD.throttle = lockedShip->throttle;
+            playerHUD.paused = screenState == GAME_PAUSED;
+        }
+
+        // Finish streamed textures within a fixed slice of the frame
+        processAssetUploads(ASSET_UPLOAD_BUDGET);
+        Texture2D compassTexture = getTextureById(TEXTURE_HUD_COMPASS);
+        if (compassTexture.id != playerHUD.compassTexture.id)
+        {
+            // The compass is baked into the static layer
+            playerHUD.compassTexture = compassTexture;
+            invalidateHudLayer(&playerHUD.staticLayer);
+        }
+        playerHUD.arrowTexture = getTextureById(TEXTURE_HUD_ARROW);
+
         // Render
         BeginDrawing();
         ClearBackground(currentColourScheme->spaceColour);
@@ -262,52 +325,74 @@ int main(void)
         }
         else
         {
-            BeginMode2D(camera);
-            drawCelestialGrid(gameState.bodies, gameState.numBodies, camera, currentColourScheme);
-            drawOrbits(gameState.bodies, gameState.numBodies, currentColourScheme);
-            drawTrajectories(gameState.ships, gameState.numShips, currentColourScheme);
-            drawBodies(gameState.bodies, gameState.numBodies);
-            drawShips(gameState.ships, gameState.numShips, &camera, &shipLogo);
-
-            EndMode2D();
+            // Everything below only draws what overlaps the camera's world bounds
+            Vector2 screenSize = {(float)GetScreenWidth(), (float)GetScreenHeight()};
+            cullRenderView(&renderView, spatialIndex, camera, screenSize);
+
+            // Record the world and HUD, then replay them through raylib
+            double frameStart = getSimClock();
+            clearDrawList(&drawList, screenSize);
+            drawListBeginCamera(&drawList, camera);
+            double stageStart = getSimClock();
+            drawCelestialGrid(&drawList, gridRenderer, camera, renderView.bounds, quality.settings.gridDensity, currentColourScheme);
+            reportQualityCost(&quality, QUALITY_KNOB_GRID, getSimClock() - stageStart);
+            stageStart = getSimClock();
+            drawOrbits(&drawList, mirror.bodies, mirror.numBodies, &renderView, &camera, quality.settings.orbitTolerance, currentColourScheme);
+            reportQualityCost(&quality, QUALITY_KNOB_ORBITS, getSimClock() - stageStart);
+            drawTrajectories(&drawList, trajectoryRenderer, mirror.ships, mirror.numShips, &camera, renderView.bounds, currentColourScheme);
+            drawBodies(&drawList, mirror.bodies, mirror.numBodies, &renderView);
+            stageStart = getSimClock();
+            drawShips(&drawList, shipRenderer, mirror.ships, mirror.numShips, &camera, &renderView, quality.settings.shipIconZoom);
+            reportQualityCost(&quality, QUALITY_KNOB_SHIP_ICONS, getSimClock() - stageStart);
+            drawListEndCamera(&drawList);
 
             // GUI
-            DrawText("Press ESC to pause & view controls", 10, 10, 20, DARKGRAY);
-
-            drawPlayerHUD(&playerHUD);
-            // drawPlayerStats(&playerStats);
+            drawPlayerHUD(&drawList, &playerHUD);
+            // drawPlayerStats(&drawList, &playerStats);
             // drawPlayerInventory(playerShip, globalResources);
+            drawQualityOverlay(&drawList, &quality);
+            replayDrawList(&drawList);
 
-            DrawFPS(screenWidth - 100, 10);
-            DrawText(TextFormat("Camera locked to Ship: %i", cameraLock), screenWidth - 280, 40, 20, DARKGRAY);
-            DrawText(TextFormat("Time Scale: %.1fx", timeScale.val), screenWidth - 200, 70, 20, DARKGRAY);
-            // DrawText(TextFormat("Zoom Level: %.3fx", calculateNormalisedZoom(&cameraSettings, camera.zoom)), screenWidth - 200, 100, 20, DARKGRAY);
-            DrawText(TextFormat("Camera zoom: %.6fx", camera.zoom), screenWidth - 250, 100, 20, DARKGRAY);
-
-            DrawText(TextFormat("Ship throttle: %.2fpct", gameState.ships[0]->throttle), screenWidth - 250, 130, 20, DARKGRAY);
-
-            if (screenState == GAME_PAUSED)
+            // Trajectory and gravity knobs live on the sim thread, which reports their cost with each snapshot
+            if (snapshot != NULL)
             {
-                DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Fade(GRAY, 0.5f));
-                DrawText("Game Paused", GetScreenWidth() / 2 - MeasureText("Game Paused", 40) / 2, 200, 40, WHITE);
-                DrawText("Press ESC to Resume", GetScreenWidth() / 2 - MeasureText("Press ESC to Resume", 20) / 2, 300, 20, WHITE);
-                DrawText("Press S to Save", GetScreenWidth() / 2 - MeasureText("Press S to Save", 20) / 2, 340, 20, WHITE);
-                DrawText("Press Q to Quit", GetScreenWidth() / 2 - MeasureText("Press Q to Quit", 20) / 2, 380, 20, WHITE);
-                DrawText("Press 'C' to switch camera", 10, 40, 20, WHITE);
-                DrawText("Press '.' and ',' to time warp", 10, 70, 20, WHITE);
-                DrawText("Scroll to zoom", 10, 100, 20, WHITE);
-                DrawText("Press 'V' to switch velocity lock", 10, 130, 20, WHITE);
+                reportQualityCost(&quality, QUALITY_KNOB_TRAJECTORY, snapshot->predictSeconds);
+                reportQualityCost(&quality, QUALITY_KNOB_GRAVITY, snapshot->gravitySeconds);
+                updateQualityGovernor(&quality, getSimClock() - frameStart, snapshot->workSeconds);
+                // A change stays pending until the command queue has room for it
+                if (quality.changed[QUALITY_KNOB_TRAJECTORY] && sendSimCommand(sim, SIM_COMMAND_TRAJECTORY_QUALITY, quality.levels[QUALITY_KNOB_TRAJECTORY]))
+                    quality.changed[QUALITY_KNOB_TRAJECTORY] = false;
+                if (quality.changed[QUALITY_KNOB_GRAVITY] && sendSimCommand(sim, SIM_COMMAND_GRAVITY_QUALITY, quality.levels[QUALITY_KNOB_GRAVITY]))
+                    quality.changed[QUALITY_KNOB_GRAVITY] = false;
             }
         }
 
         EndDrawing();
+        // Body textures off screen for longest go first once over budget
+        trimTextureResidency(TEXTURE_RESIDENCY_BUDGET);
     }
 
-    freeCelestialBodies(gameState.bodies, gameState.numBodies);
-    freeShips(gameState.ships, gameState.numShips);
-    UnloadTexture(playerHUD.compassTexture);
-    UnloadTexture(playerHUD.arrowTexture);
-    UnloadTexture(shipLogo);
+    // Stop the simulation before freeing the state it runs on
+    freeSimulation(sim);
+    freeSimMirror(&mirror);
+    unloadGame(&gameState);
+    freeSpatialIndex(spatialIndex);
+    freeTrajectoryRenderer(trajectoryRenderer);
+    freeShipRenderer(shipRenderer);
+    freeGridRenderer(gridRenderer);
+    freeSpatialQuery(&spatialQuery);
+    freeRenderView(&renderView);
+    freeDrawList(&drawList);
+    freeOrbitCache();
+    freeProceduralSurfaces();
+    freeHudLayer(&playerHUD.staticLayer);
+    freeHudLayer(&playerHUD.pauseLayer);
+    releaseTextureResidency();
+    UnloadTextureById(TEXTURE_HUD_COMPASS);
+    UnloadTextureById(TEXTURE_HUD_ARROW);
+    unloadTextureCache();
+    unloadSpriteAtlas();
+    shutdownAssetLoader();
 
     CloseWindow();
     return 0;
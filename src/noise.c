@@ -0,0 +1,142 @@
+#include <string.h>
+#include "noise.h"
+
+typedef float vfloat __attribute__((vector_size(NOISE_LANES * sizeof(float))));
+typedef int32_t vint __attribute__((vector_size(NOISE_LANES * sizeof(int32_t))));
+typedef uint32_t vuint __attribute__((vector_size(NOISE_LANES * sizeof(uint32_t))));
+
+// Vector comparisons give -1 in true lanes and 0 in false ones
+static inline vfloat selectLanes(vint mask, vfloat a, vfloat b)
+{
+    return (vfloat)((mask & (vint)a) | (~mask & (vint)b));
+}
+
+static inline vint floorLanes(vfloat v)
+{
+    // Conversion truncates towards zero, so step negative non-integers down one
+    vint i = __builtin_convertvector(v, vint);
+    return i + (v < __builtin_convertvector(i, vfloat));
+}
+
+static inline vint hashCorner(vint i, vint j, vint k, uint32_t seed)
+{
+    vuint h = ((vuint)i * 0x8da6b343u) ^ ((vuint)j * 0xd8163841u) ^ ((vuint)k * 0xcb1ab31fu) ^ seed;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return (vint)h;
+}
+
+static inline vfloat gradient(vint hash, vfloat x, vfloat y, vfloat z)
+{
+    // Perlin's 12 cube-edge gradients, picked from the low four bits
+    vint h = hash & 15;
+    vfloat u = selectLanes(h < 8, x, y);
+    vfloat v = selectLanes(h < 4, y, selectLanes((h == 12) | (h == 14), x, z));
+    return selectLanes((h & 1) != 0, -u, u) + selectLanes((h & 2) != 0, -v, v);
+}
+
+static inline vfloat corner(vfloat x, vfloat y, vfloat z, vint hash)
+{
+    vfloat t = 0.6f - x * x - y * y - z * z;
+    t = selectLanes(t < 0, (vfloat){0}, t);
+    t *= t;
+    return t * t * gradient(hash, x, y, z);
+}
+
+static vfloat simplexLanes(vfloat x, vfloat y, vfloat z, uint32_t seed)
+{
+    const float F3 = 1.0f / 3.0f;
+    const float G3 = 1.0f / 6.0f;
+
+    // Skew to find the simplex cell, then unskew its origin back to get the offset into it
+    vfloat s = (x + y + z) * F3;
+    vint i = floorLanes(x + s);
+    vint j = floorLanes(y + s);
+    vint k = floorLanes(z + s);
+    vfloat t = __builtin_convertvector(i + j + k, vfloat) * G3;
+    vfloat x0 = x - (__builtin_convertvector(i, vfloat) - t);
+    vfloat y0 = y - (__builtin_convertvector(j, vfloat) - t);
+    vfloat z0 = z - (__builtin_convertvector(k, vfloat) - t);
+
+    // The order of the offsets picks which of the cell's six tetrahedra holds the point - as masks, so each offset is
+    // -1 where a corner steps along that axis
+    vint i1 = (x0 >= y0) & (x0 >= z0);
+    vint j1 = (y0 > x0) & (y0 >= z0);
+    vint k1 = (z0 > x0) & (z0 > y0);
+    vint i2 = (x0 >= y0) | (x0 >= z0);
+    vint j2 = (y0 > x0) | (y0 >= z0);
+    vint k2 = ~((x0 >= z0) & (y0 >= z0));
+
+    vfloat x1 = x0 + __builtin_convertvector(i1, vfloat) + G3;
+    vfloat y1 = y0 + __builtin_convertvector(j1, vfloat) + G3;
+    vfloat z1 = z0 + __builtin_convertvector(k1, vfloat) + G3;
+    vfloat x2 = x0 + __builtin_convertvector(i2, vfloat) + 2 * G3;
+    vfloat y2 = y0 + __builtin_convertvector(j2, vfloat) + 2 * G3;
+    vfloat z2 = z0 + __builtin_convertvector(k2, vfloat) + 2 * G3;
+    vfloat x3 = x0 - 1 + 3 * G3;
+    vfloat y3 = y0 - 1 + 3 * G3;
+    vfloat z3 = z0 - 1 + 3 * G3;
+
+    vfloat n = corner(x0, y0, z0, hashCorner(i, j, k, seed)) +
+               corner(x1, y1, z1, hashCorner(i - i1, j - j1, k - k1, seed)) +
+               corner(x2, y2, z2, hashCorner(i - i2, j - j2, k - k2, seed)) +
+               corner(x3, y3, z3, hashCorner(i + 1, j + 1, k + 1, seed));
+    return n * 32.0f;
+}
+
+static inline vfloat loadLanes(const float *values, int first, int count)
+{
+    // The last batch is padded with zeros
+    vfloat lanes = {0};
+    int n = count - first < NOISE_LANES ? count - first : NOISE_LANES;
+    memcpy(&lanes, values + first, sizeof(float) * n);
+    return lanes;
+}
+
+static inline void storeLanes(float *values, int first, int count, vfloat lanes)
+{
+    int n = count - first < NOISE_LANES ? count - first : NOISE_LANES;
+    memcpy(values + first, &lanes, sizeof(float) * n);
+}
+
+void simplexNoise(const float *x, const float *y, const float *z, int count, uint32_t seed, float *out)
+{
+    for (int i = 0; i < count; i += NOISE_LANES)
+    {
+        vfloat n = simplexLanes(loadLanes(x, i, count), loadLanes(y, i, count), loadLanes(z, i, count), seed);
+        storeLanes(out, i, count, n);
+    }
+}
+
+void fbmNoise(const float *x, const float *y, const float *z, int count, uint32_t seed, int octaves, float lacunarity,
+              float gain, float *out)
+{
+    float norm = 0;
+    float amplitude = 1;
+    for (int o = 0; o < octaves; o++)
+    {
+        norm += amplitude;
+        amplitude *= gain;
+    }
+
+    for (int i = 0; i < count; i += NOISE_LANES)
+    {
+        vfloat px = loadLanes(x, i, count);
+        vfloat py = loadLanes(y, i, count);
+        vfloat pz = loadLanes(z, i, count);
+        vfloat sum = {0};
+        float frequency = 1;
+        amplitude = 1;
+        for (int o = 0; o < octaves; o++)
+        {
+            // A different seed per octave keeps the octaves from lining up at the origin
+            sum += simplexLanes(px * frequency, py * frequency, pz * frequency, seed + o * 0x9e3779b9u) * amplitude;
+            frequency *= lacunarity;
+            amplitude *= gain;
+        }
+        storeLanes(out, i, count, sum / norm);
+    }
+}
@@ -1,4 +1,5 @@
 #include "physics.h"
+#include "fmm.h"
 
 float calculateOrbitalVelocity(float mass, float radius)
 {
@@ -31,9 +32,9 @@ float calculateOrbitalRadius(float period, float mStar)
     return (float){cbrtf(r3)};
 }
 
-float calculateRelativeSpeed(ship_t *ship, celestialbody_t *body, float gameTime)
+float calculateRelativeSpeed(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime)
 {
-    Vector2 bodyVelocity = calculateBodyVelocity(body, gameTime);
+    Vector2 bodyVelocity = calculateBodyVelocity(body, bodies, numBodies, gameTime);
     Vector2 relativeVelocity = Vector2Subtract(ship->velocity, bodyVelocity);
     return sqrtf((relativeVelocity.x * relativeVelocity.x) + (relativeVelocity.y * relativeVelocity.y));
 }
@@ -79,17 +80,18 @@ void updateCelestialPositions(celestialbody_t **bodies, int numBodies, float tim
 {
     for (int i = 0; i < numBodies; i++)
     {
-        if (bodies[i]->orbitalRadius > 0 && bodies[i]->parentBody != NULL)
+        celestialbody_t *parent = getBodyPtr(bodies[i]->parentIndex, bodies, numBodies);
+        if (bodies[i]->orbitalRadius > 0 && parent != NULL)
         { // Stars, planets, moons
             float angle = getBodyAngle(bodies[i], time);
             bodies[i]->position = (Vector2){
-                bodies[i]->parentBody->position.x + bodies[i]->orbitalRadius * cosf(angle),
-                bodies[i]->parentBody->position.y + bodies[i]->orbitalRadius * sinf(angle)};
+                parent->position.x + bodies[i]->orbitalRadius * cosf(angle),
+                parent->position.y + bodies[i]->orbitalRadius * sinf(angle)};
         }
     }
 }
 
-void updateLandedShipPosition(ship_t **ships, int numShips, float gameTime)
+void updateLandedShipPosition(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime)
 {
     for (int i = 0; i < numShips; i++)
     {
@@ -97,7 +99,7 @@ void updateLandedShipPosition(ship_t **ships, int numShips, float gameTime)
         {
             // Keep ship positioned at the landing spot relative to the body
             ships[i]->position = Vector2Add(ships[i]->landedBody->position, ships[i]->landingPosition);
-            ships[i]->velocity = calculateBodyVelocity(ships[i]->landedBody, gameTime); // Sync velocity
+            ships[i]->velocity = calculateBodyVelocity(ships[i]->landedBody, bodies, numBodies, gameTime); // Sync velocity
         }
     }
 }
@@ -126,20 +128,20 @@ void detectCollisions(ship_t **ships, int numShips, celestialbody_t **bodies, in
         {
             if (detectShipBodyCollision(ships[i], bodies[j]))
             {
-                printf("Collision between %s and Ship %i\n", bodies[j]->name, i);
+                printf("Collision between %.*s and Ship %i\n", BODY_NAME_LENGTH, bodies[j]->name, i);
                 if (ships[i]->state == SHIP_LANDED)
                     continue;
                 if (ships[i]->state != SHIP_LANDED)
                 {
-                    float relVel = calculateRelativeSpeed(ships[i], bodies[j], gameTime);
+                    float relVel = calculateRelativeSpeed(ships[i], bodies[j], bodies, numBodies, gameTime);
                     if (relVel <= MAX_LANDING_SPEED)
                     {
-                        printf("Ship %i has landed on %s\n", i, bodies[j]->name);
-                        landShip(ships[i], bodies[j], gameTime);
+                        printf("Ship %i has landed on %.*s\n", i, BODY_NAME_LENGTH, bodies[j]->name);
+                        landShip(ships[i], bodies[j], bodies, numBodies, gameTime);
                     }
                     else
                     {
-                        printf("Ship %i has CRASHED into %s\n", i, bodies[j]->name);
+                        printf("Ship %i has CRASHED into %.*s\n", i, BODY_NAME_LENGTH, bodies[j]->name);
                     }
                 }
             }
@@ -162,6 +164,37 @@ Vector2 computeShipGravity(ship_t *ship, celestialbody_t **bodies, int numBodies
     return totalForce;
 }
 
+void applyShipMutualGravity(ship_t **ships, int numShips, fmmsolver_t *solver, float dt)
+{
+    // Ships attract each other - small fleets use direct summation, swarms go through the FMM solver
+    // The solver owns the gather buffers, so without one there is nowhere to sum into
+    if (numShips < 2 || solver == NULL || !reserveFmmInputs(solver, numShips))
+        return;
+
+    Vector2 *positions = solver->positions;
+    float *masses = solver->masses;
+    Vector2 *accelerations = solver->accelerations;
+    for (int i = 0; i < numShips; i++)
+    {
+        positions[i] = ships[i]->position;
+        masses[i] = ships[i]->mass;
+    }
+
+    // A tree that failed to allocate falls back to the direct sum
+    if (numShips < FMM_DIRECT_THRESHOLD || !solveFmmGravity(solver, positions, masses, numShips, accelerations))
+    {
+        solveDirectGravity(positions, masses, numShips, accelerations);
+    }
+
+    // Landed ships still pull on others but are held in place by their body
+    for (int i = 0; i < numShips; i++)
+    {
+        if (ships[i]->state != SHIP_FLYING)
+            continue;
+        ships[i]->velocity = Vector2Add(ships[i]->velocity, Vector2Scale(accelerations[i], dt));
+    }
+}
+
 Vector2 calculateDragForce(ship_t *ship, celestialbody_t **bodies, int numBodies)
 {
     Vector2 velocity = ship->velocity;
@@ -189,24 +222,36 @@ Vector2 calculateDragForce(ship_t *ship, celestialbody_t **bodies, int numBodies
     return dragForce;
 }
 
-void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime)
+void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t **bodies, int numBodies, float gameTime, int steps, float stepTime)
 {
+    // Revisions are unique across all ships so a renderer can never mistake a new ship for one it has uploaded
+    static unsigned int trajectoryRevision = 0;
+
     Vector2 initialVelocities[numShips];
     Vector2 initialPositions[numShips];
     bool hasCollided[numShips]; // Track collision state for each ship
 
     // Capture initial state and reset collision flags
+    int longestTrajectory = 0;
     for (int i = 0; i < numShips; i++)
     {
         initialVelocities[i] = ships[i]->velocity;
         initialPositions[i] = ships[i]->position;
         hasCollided[i] = false; // No collisions at start
+        if (ships[i]->trajectorySize > longestTrajectory)
+            longestTrajectory = ships[i]->trajectorySize;
     }
 
-    // Simulate system forward for FUTURE_POSITIONS timesteps
-    for (int i = 0; i < MAX_FUTURE_POSITIONS; i++)
+    // Simulate system forward for up to steps timesteps - no further than the longest path can hold
+    if (steps > longestTrajectory)
+        steps = longestTrajectory;
+    if (steps > MAX_FUTURE_POSITIONS)
+        steps = MAX_FUTURE_POSITIONS;
+    if (steps < 1)
+        return;
+    for (int i = 0; i < steps; i++)
     {
-        float futureTime = gameTime + (i * FUTURE_STEP_TIME);
+        float futureTime = gameTime + (i * stepTime);
 
         // Update celestial body positions for this timestep
         updateCelestialPositions(bodies, numBodies, futureTime);
@@ -220,8 +265,8 @@ void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t
                 Vector2 dragForce = calculateDragForce(ships[j], bodies, numBodies);
                 Vector2 totalForce = Vector2Add(gravityForce, dragForce);
                 Vector2 accel = Vector2Scale(totalForce, 1.0f / ships[j]->mass);
-                ships[j]->velocity = Vector2Add(ships[j]->velocity, Vector2Scale(accel, FUTURE_STEP_TIME));
-                ships[j]->position = Vector2Add(ships[j]->position, Vector2Scale(ships[j]->velocity, FUTURE_STEP_TIME));
+                ships[j]->velocity = Vector2Add(ships[j]->velocity, Vector2Scale(accel, stepTime));
+                ships[j]->position = Vector2Add(ships[j]->position, Vector2Scale(ships[j]->velocity, stepTime));
 
                 // Check for collision
                 celestialbody_t *collidingBody = NULL;
@@ -280,12 +325,18 @@ void calculateShipFuturePositions(ship_t **ships, int numShips, celestialbody_t
     updateCelestialPositions(bodies, numBodies, gameTime);
     for (int i = 0; i < numShips; i++)
     {
+        // A shortened horizon holds the last predicted position for the rest of the path, like a collision does
+        for (int k = steps; k < ships[i]->trajectorySize; k++)
+        {
+            ships[i]->futurePositions[k] = ships[i]->futurePositions[steps - 1];
+        }
         ships[i]->velocity = initialVelocities[i];
         ships[i]->position = initialPositions[i];
+        ships[i]->trajectoryRevision = ++trajectoryRevision;
     }
 }
 
-void landShip(ship_t *ship, celestialbody_t *body, float gameTime)
+void landShip(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime)
 {
     if (ship->state == SHIP_LANDED)
         return;
@@ -293,7 +344,7 @@ void landShip(ship_t *ship, celestialbody_t *body, float gameTime)
     // Set landing state
     ship->state = SHIP_LANDED;
     ship->landedBody = body;
-    ship->velocity = calculateBodyVelocity(body, gameTime); // Match velocity to the body
+    ship->velocity = calculateBodyVelocity(body, bodies, numBodies, gameTime); // Match velocity to the body
 
     Vector2 direction = Vector2Subtract(ship->position, body->position);
     // float distance = Vector2Length(direction);
@@ -305,26 +356,27 @@ void landShip(ship_t *ship, celestialbody_t *body, float gameTime)
     ship->landingPosition = surfacePosition; // Store relative position
 }
 
-Vector2 calculateBodyVelocity(celestialbody_t *body, float gameTime)
+Vector2 calculateBodyVelocity(celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime)
 {
     // Recursive function to sum velocities of current body and its parents
+    celestialbody_t *parent = getBodyPtr(body->parentIndex, bodies, numBodies);
 
     // Early return for non-orbiting bodies
-    if (body->parentBody == NULL || body->orbitalRadius == 0)
+    if (parent == NULL || body->orbitalRadius == 0)
         return (Vector2){0, 0};
 
     float angle = getBodyAngle(body, gameTime);
-    float orbitalVelocity = calculateOrbitalVelocity(body->parentBody->mass, body->orbitalRadius);
+    float orbitalVelocity = calculateOrbitalVelocity(parent->mass, body->orbitalRadius);
     Vector2 velocity = (Vector2){
         orbitalVelocity * cosf(angle),
         orbitalVelocity * sinf(angle)};
 
-    Vector2 parentVelocity = calculateBodyVelocity(body->parentBody, gameTime);
+    Vector2 parentVelocity = calculateBodyVelocity(parent, bodies, numBodies, gameTime);
 
     return Vector2Add(velocity, parentVelocity);
 }
 
-void initStableOrbit(ship_t *ship, celestialbody_t *body, float gameTime)
+void initStableOrbit(ship_t *ship, celestialbody_t *body, celestialbody_t **bodies, int numBodies, float gameTime)
 {
     // Puts a ship in a stable orbit around a body at a fixed height
     float orbitHeight = 1e4;
@@ -342,7 +394,7 @@ void initStableOrbit(ship_t *ship, celestialbody_t *body, float gameTime)
     // Ship will orbit body clockwise
     float orbitalVelocity = calculateOrbitalVelocity(body->mass, bodyRadius + orbitHeight);
     Vector2 shipVelocity = (Vector2){orbitalVelocity, 0};
-    Vector2 bodyVelocity = calculateBodyVelocity(body, gameTime);
+    Vector2 bodyVelocity = calculateBodyVelocity(body, bodies, numBodies, gameTime);
 
     ship->velocity = Vector2Add(shipVelocity, bodyVelocity);
 }
\ No newline at end of file
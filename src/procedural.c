@@ -0,0 +1,339 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "procedural.h"
+#include "raymath.h"
+#include "noise.h"
+#include "textures.h"
+
+#define PLANET_SURFACE_VERSION 1 // Bump when generation changes so stale cache files are regenerated
+#define PLANET_CACHE_MAGIC 0x46534147 // "GASF" in a little-endian file
+#define PALETTE_MAX_STOPS 8
+
+typedef struct ColourStop
+{
+    float height;
+    Color colour;
+} colourstop_t;
+
+typedef struct SurfacePalette
+{
+    int numStops;
+    colourstop_t stops[PALETTE_MAX_STOPS];
+    float iceCaps; // Latitude beyond which the surface turns to ice, 0 for none
+} surfacepalette_t;
+
+static const surfacepalette_t starPalettes[] = {
+    {4, {{0.0f, {200, 80, 10, 255}}, {0.4f, {255, 170, 40, 255}}, {0.7f, {255, 220, 120, 255}}, {1.0f, {255, 250, 220, 255}}}, 0.0f},
+    {3, {{0.0f, {120, 20, 10, 255}}, {0.5f, {220, 70, 30, 255}}, {1.0f, {255, 160, 90, 255}}}, 0.0f},
+    {3, {{0.0f, {90, 120, 220, 255}}, {0.5f, {170, 200, 255, 255}}, {1.0f, {240, 245, 255, 255}}}, 0.0f}};
+
+static const surfacepalette_t planetPalettes[] = {
+    // Terran
+    {7, {{0.0f, {10, 30, 90, 255}}, {0.45f, {30, 80, 160, 255}}, {0.5f, {210, 200, 140, 255}}, {0.55f, {60, 140, 60, 255}}, {0.7f, {40, 90, 40, 255}}, {0.85f, {120, 110, 100, 255}}, {1.0f, {250, 250, 250, 255}}}, 0.8f},
+    // Arid
+    {4, {{0.0f, {120, 60, 30, 255}}, {0.4f, {190, 110, 60, 255}}, {0.7f, {220, 170, 110, 255}}, {1.0f, {250, 220, 170, 255}}}, 0.0f},
+    // Ice
+    {3, {{0.0f, {120, 160, 200, 255}}, {0.5f, {200, 225, 240, 255}}, {1.0f, {255, 255, 255, 255}}}, 0.0f},
+    // Volcanic
+    {4, {{0.0f, {20, 10, 10, 255}}, {0.55f, {60, 30, 25, 255}}, {0.7f, {200, 60, 10, 255}}, {1.0f, {255, 200, 60, 255}}}, 0.0f}};
+
+static const surfacepalette_t moonPalettes[] = {
+    {3, {{0.0f, {60, 60, 65, 255}}, {0.5f, {130, 130, 135, 255}}, {1.0f, {210, 210, 210, 255}}}, 0.0f},
+    {3, {{0.0f, {80, 65, 50, 255}}, {0.5f, {150, 130, 105, 255}}, {1.0f, {215, 200, 180, 255}}}, 0.0f}};
+
+typedef struct SurfaceCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t width;
+    uint32_t height;
+} surfacecacheheader_t;
+
+planetsurface_t getDefaultPlanetSurface(CelestialType type, uint32_t seed)
+{
+    planetsurface_t surface = {.seed = seed, .type = type, .size = PLANET_TEXTURE_SIZE, .lacunarity = 2.0f, .gain = 0.5f};
+    switch (type)
+    {
+    case TYPE_STAR:
+        // Fine, low-contrast granulation
+        surface.octaves = 4;
+        surface.frequency = 6.0f;
+        break;
+    case TYPE_MOON:
+        surface.octaves = 5;
+        surface.frequency = 3.0f;
+        surface.gain = 0.6f;
+        break;
+    default:
+        // Continents, then detail down to a couple of pixels
+        surface.octaves = 6;
+        surface.frequency = 1.5f;
+        break;
+    }
+    return surface;
+}
+
+static const surfacepalette_t *getSurfacePalette(const planetsurface_t *surface)
+{
+    // The seed's high bits pick the palette, leaving the low bits to the noise
+    uint32_t pick = surface->seed >> 24;
+    switch (surface->type)
+    {
+    case TYPE_STAR:
+        return &starPalettes[pick % (sizeof(starPalettes) / sizeof(starPalettes[0]))];
+    case TYPE_MOON:
+        return &moonPalettes[pick % (sizeof(moonPalettes) / sizeof(moonPalettes[0]))];
+    default:
+        return &planetPalettes[pick % (sizeof(planetPalettes) / sizeof(planetPalettes[0]))];
+    }
+}
+
+static Color sampleSurfacePalette(const surfacepalette_t *palette, float height)
+{
+    const colourstop_t *stops = palette->stops;
+    if (height <= stops[0].height)
+        return stops[0].colour;
+    for (int i = 1; i < palette->numStops; i++)
+    {
+        if (height <= stops[i].height)
+        {
+            float t = (height - stops[i - 1].height) / (stops[i].height - stops[i - 1].height);
+            return ColorLerp(stops[i - 1].colour, stops[i].colour, t);
+        }
+    }
+    return stops[palette->numStops - 1].colour;
+}
+
+Image generatePlanetSurface(const planetsurface_t *surface)
+{
+    // Safe on any thread - only touches its own buffers
+    int size = surface->size;
+    Color *pixels = MemAlloc(sizeof(Color) * size * size);
+    float *buffers = malloc(sizeof(float) * size * 6);
+    if (!pixels || !buffers)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate a %dx%d planet surface", size, size);
+        MemFree(pixels);
+        free(buffers);
+        return (Image){0};
+    }
+    float *x = buffers, *y = x + size, *z = y + size, *noise = z + size, *discX = noise + size, *discZ = discX + size;
+
+    const surfacepalette_t *palette = getSurfacePalette(surface);
+    bool star = surface->type == TYPE_STAR;
+    for (int row = 0; row < size; row++)
+    {
+        // Gather the row's pixels that fall on the disc, lifted onto the front of a unit sphere
+        float v = (row + 0.5f) / size * 2 - 1;
+        int first = -1, count = 0;
+        for (int col = 0; col < size; col++)
+        {
+            float u = (col + 0.5f) / size * 2 - 1;
+            float r2 = u * u + v * v;
+            if (r2 > 1)
+                continue;
+            if (first < 0)
+                first = col;
+            discX[count] = u;
+            discZ[count] = sqrtf(1 - r2);
+            x[count] = u * surface->frequency;
+            y[count] = v * surface->frequency;
+            z[count] = discZ[count] * surface->frequency;
+            count++;
+        }
+        if (count == 0)
+            continue;
+        fbmNoise(x, y, z, count, surface->seed, surface->octaves, surface->lacunarity, surface->gain, noise);
+
+        // The disc is convex, so its pixels in a row are contiguous from first
+        for (int i = 0; i < count; i++)
+        {
+            float height = Clamp(0.5f + noise[i], 0, 1);
+            Color colour = sampleSurfacePalette(palette, height);
+            if (palette->iceCaps > 0 && fabsf(v) + noise[i] * 0.1f > palette->iceCaps)
+                colour = ColorLerp(colour, RAYWHITE, 0.85f);
+
+            // Darken towards the limb, less for stars, and soften the edge over about a pixel
+            float shade = star ? 0.75f + 0.25f * discZ[i] : 0.3f + 0.7f * sqrtf(discZ[i]);
+            float radius = sqrtf(discX[i] * discX[i] + v * v);
+            float alpha = Clamp((1 - radius) * size * 0.5f, 0, 1);
+            pixels[row * size + first + i] = (Color){
+                (unsigned char)(colour.r * shade),
+                (unsigned char)(colour.g * shade),
+                (unsigned char)(colour.b * shade),
+                (unsigned char)(255 * alpha)};
+        }
+    }
+    free(buffers);
+    return (Image){.data = pixels, .width = size, .height = size, .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+}
+
+static uint64_t hashPlanetSurface(const planetsurface_t *surface)
+{
+    // FNV-1a over each field rather than the struct, so padding never reaches the key
+    uint32_t fields[] = {PLANET_SURFACE_VERSION, surface->seed, (uint32_t)surface->type, (uint32_t)surface->size,
+                         (uint32_t)surface->octaves, 0, 0, 0};
+    memcpy(&fields[5], &surface->frequency, sizeof(float));
+    memcpy(&fields[6], &surface->lacunarity, sizeof(float));
+    memcpy(&fields[7], &surface->gain, sizeof(float));
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char *bytes = (const unsigned char *)fields;
+    for (size_t i = 0; i < sizeof(fields); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static Image readSurfaceCache(const char *path, uint64_t key, int size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return (Image){0};
+    surfacecacheheader_t header;
+    Color *pixels = NULL;
+    if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == PLANET_CACHE_MAGIC &&
+        header.version == PLANET_SURFACE_VERSION && header.key == key && header.width == (uint32_t)size &&
+        header.height == (uint32_t)size)
+    {
+        pixels = MemAlloc(sizeof(Color) * size * size);
+        if (pixels && fread(pixels, sizeof(Color), size * size, file) != (size_t)(size * size))
+        {
+            MemFree(pixels);
+            pixels = NULL;
+        }
+    }
+    fclose(file);
+    if (!pixels)
+    {
+        TraceLog(LOG_WARNING, "Planet surface cache %s is stale or corrupt, regenerating", path);
+        return (Image){0};
+    }
+    return (Image){.data = pixels, .width = size, .height = size, .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+}
+
+static void writeSurfaceCache(const char *path, uint64_t key, Image image)
+{
+    // Written under a unique name then renamed, so a reader never sees a partial file even if two workers race
+    if (mkdir(PLANET_CACHE_DIR, 0755) != 0 && errno != EEXIST)
+    {
+        TraceLog(LOG_WARNING, "Failed to create planet surface cache %s", PLANET_CACHE_DIR);
+        return;
+    }
+    char tmpPath[ASSET_PATH_CAPACITY + sizeof(".XXXXXX")];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.XXXXXX", path);
+    int fd = mkstemp(tmpPath);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!file)
+    {
+        if (fd >= 0)
+            close(fd);
+        TraceLog(LOG_WARNING, "Failed to write planet surface cache %s", path);
+        return;
+    }
+
+    surfacecacheheader_t header = {PLANET_CACHE_MAGIC, PLANET_SURFACE_VERSION, key, image.width, image.height};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(image.data, sizeof(Color), image.width * image.height, file) == (size_t)(image.width * image.height);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0)
+    {
+        remove(tmpPath);
+        TraceLog(LOG_WARNING, "Failed to write planet surface cache %s", path);
+    }
+}
+
+Image loadPlanetSurface(const planetsurface_t *surface)
+{
+    // From the disk cache when it has this exact surface, otherwise generated and added to it
+    uint64_t key = hashPlanetSurface(surface);
+    char path[ASSET_PATH_CAPACITY];
+    snprintf(path, sizeof(path), "%s/planet_%016llx.rgba", PLANET_CACHE_DIR, (unsigned long long)key);
+
+    Image image = readSurfaceCache(path, key, surface->size);
+    if (IsImageValid(image))
+        return image;
+    image = generatePlanetSurface(surface);
+    if (IsImageValid(image))
+        writeSurfaceCache(path, key, image);
+    return image;
+}
+
+static Image generateSurfaceAsset(const void *params)
+{
+    return loadPlanetSurface(params);
+}
+
+int registerPlanetSurface(const planetsurface_t *surface)
+{
+    char name[ASSET_PATH_CAPACITY];
+    snprintf(name, sizeof(name), "planet surface %08x", surface->seed);
+    return registerGeneratedTexture(name, generateSurfaceAsset, surface, sizeof(planetsurface_t));
+}
+
+static uint32_t hashBodyName(const char *name)
+{
+    // 32-bit FNV-1a over the NUL-padded name
+    uint32_t hash = 0x811c9dc5u;
+    for (int i = 0; i < BODY_NAME_LENGTH && name[i]; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+typedef struct SurfaceSlot
+{
+    uint32_t seed;
+    int textureId; // TEXTURE_NONE until the body is first drawn
+} surfaceslot_t;
+
+static surfaceslot_t *surfaceSlots = NULL;
+static int surfaceSlotCapacity = 0;
+
+int getProceduralSurface(int index, const celestialbody_t *body)
+{
+    // A surface is seeded from the body's name and index, so the same universe always looks the same and hits the same
+    // cache files. Registering on first draw rather than at load keeps loading from touching every body
+    if (index < 0)
+        return TEXTURE_NONE;
+    if (index >= surfaceSlotCapacity)
+    {
+        int capacity = surfaceSlotCapacity > 0 ? surfaceSlotCapacity : 64;
+        while (capacity <= index)
+            capacity *= 2;
+        surfaceslot_t *slots = realloc(surfaceSlots, sizeof(surfaceslot_t) * capacity);
+        if (!slots)
+            return TEXTURE_NONE;
+        for (int i = surfaceSlotCapacity; i < capacity; i++)
+            slots[i] = (surfaceslot_t){0, TEXTURE_NONE};
+        surfaceSlots = slots;
+        surfaceSlotCapacity = capacity;
+    }
+
+    // Slots are by index, so a body that replaced another at the same index (a new game or a load) has a new seed
+    uint32_t seed = hashBodyName(body->name) ^ (uint32_t)index * 0x9e3779b9u;
+    surfaceslot_t *slot = &surfaceSlots[index];
+    if (slot->textureId == TEXTURE_NONE || slot->seed != seed)
+    {
+        planetsurface_t surface = getDefaultPlanetSurface(body->type, seed);
+        slot->seed = seed;
+        slot->textureId = registerPlanetSurface(&surface);
+    }
+    return slot->textureId;
+}
+
+void freeProceduralSurfaces(void)
+{
+    free(surfaceSlots);
+    surfaceSlots = NULL;
+    surfaceSlotCapacity = 0;
+}
@@ -0,0 +1,426 @@
+#include "quadtree.h"
+
+void drawQuadtree(QuadTreeNode *node)
+{
+    if (node == NULL)
+        return;
+    DrawRectangleLines((int)node->bounds.x, (int)node->bounds.y,
+                       (int)node->bounds.width, (int)node->bounds.height, DARKGRAY);
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (node->children[i] != NULL)
+        {
+            drawQuadtree(node->children[i]);
+        }
+    }
+}
+
+static QuadTreeNode *createNode(Rectangle bounds)
+{
+    QuadTreeNode *node = (QuadTreeNode *)malloc(sizeof(QuadTreeNode));
+    node->bounds = bounds;
+    node->centerOfMass = (Vector2){0, 0};
+    node->totalMass = 0.0f;
+    node->quadXX = 0.0f;
+    node->quadXY = 0.0f;
+    node->quadYY = 0.0f;
+    node->maxMass = 0.0f;
+    node->maxRadius = 0.0f;
+    for (int i = 0; i < 4; i++)
+        node->children[i] = NULL;
+    node->body = NULL;
+    node->extraBodies = NULL;
+    node->numExtraBodies = 0;
+    return node;
+}
+
+static void subdivide(QuadTreeNode *node)
+{
+    float x = node->bounds.x;
+    float y = node->bounds.y;
+    float w = node->bounds.width / 2;
+    float h = node->bounds.height / 2;
+    node->children[0] = createNode((Rectangle){x, y, w, h});         // NW
+    node->children[1] = createNode((Rectangle){x + w, y, w, h});     // NE
+    node->children[2] = createNode((Rectangle){x, y + h, w, h});     // SW
+    node->children[3] = createNode((Rectangle){x + w, y + h, w, h}); // SE
+}
+
+static int childIndex(QuadTreeNode *node, Vector2 position)
+{
+    float midX = node->bounds.x + node->bounds.width / 2;
+    float midY = node->bounds.y + node->bounds.height / 2;
+    return (position.x < midX) ? (position.y < midY ? 0 : 2) : (position.y < midY ? 1 : 3);
+}
+
+static void appendExtraBody(QuadTreeNode *node, celestialbody_t *body)
+{
+    celestialbody_t **extraBodies = realloc(node->extraBodies, sizeof(celestialbody_t *) * (node->numExtraBodies + 1));
+    if (!extraBodies)
+    {
+        TraceLog(LOG_ERROR, "Failed to grow quadtree leaf");
+        return;
+    }
+    node->extraBodies = extraBodies;
+    node->extraBodies[node->numExtraBodies++] = body;
+}
+
+void insertBody(QuadTreeNode *node, celestialbody_t *body)
+{
+    // Mass moments are not maintained here - call refitQuadTree once all bodies are inserted
+    if (node->body != NULL && node->bounds.width <= QUADTREE_MIN_CELL_SIZE)
+    { // Leaf too small to split - bodies at (nearly) the same position share it
+        appendExtraBody(node, body);
+        return;
+    }
+    if (node->body != NULL)
+    { // Leaf with a body
+        celestialbody_t *existingBody = node->body;
+        subdivide(node);
+        // Insert existing body into appropriate child
+        insertBody(node->children[childIndex(node, existingBody->position)], existingBody);
+        node->body = NULL;
+    }
+    if (node->children[0] == NULL)
+    { // Leaf node
+        node->body = body;
+    }
+    else
+    { // Internal node
+        insertBody(node->children[childIndex(node, body->position)], body);
+    }
+}
+
+QuadTreeNode *buildQuadTree(celestialbody_t **bodies, int numBodies)
+{
+    if (numBodies == 0)
+    {
+        printf("No bodies");
+        return NULL;
+    }
+
+    float minX = bodies[0]->position.x, maxX = minX;
+    float minY = bodies[0]->position.y, maxY = minY;
+
+    for (int i = 1; i < numBodies; i++)
+    {
+        minX = fmin(minX, bodies[i]->position.x);
+        maxX = fmax(maxX, bodies[i]->position.x);
+        minY = fmin(minY, bodies[i]->position.y);
+        maxY = fmax(maxY, bodies[i]->position.y);
+    }
+    float width = maxX - minX, height = maxY - minY;
+    if (width > height)
+        minY -= (width - height) / 2;
+    else
+        minX -= (height - width) / 2;
+    Rectangle bounds = {minX, minY, fmax(width, height), fmax(width, height)};
+    QuadTreeNode *root = createNode(bounds);
+    for (int i = 0; i < numBodies; i++)
+    {
+        insertBody(root, bodies[i]);
+    }
+    refitQuadTree(root);
+    return root;
+}
+
+void refitQuadTree(QuadTreeNode *node)
+{
+    /*
+        Recomputes mass, center of mass and quadrupole moments bottom-up
+        Can be called again after bodies move without rebuilding, as long as they stay roughly in their cells
+    */
+    if (node->body != NULL)
+    {
+        double mass = node->body->mass;
+        double comX = (double)node->body->position.x * node->body->mass;
+        double comY = (double)node->body->position.y * node->body->mass;
+        node->maxMass = node->body->mass;
+        node->maxRadius = node->body->radius;
+        for (int i = 0; i < node->numExtraBodies; i++)
+        {
+            celestialbody_t *extra = node->extraBodies[i];
+            mass += extra->mass;
+            comX += (double)extra->position.x * extra->mass;
+            comY += (double)extra->position.y * extra->mass;
+            node->maxMass = fmaxf(node->maxMass, extra->mass);
+            node->maxRadius = fmaxf(node->maxRadius, extra->radius);
+        }
+        node->totalMass = (float)mass;
+        node->centerOfMass = mass > 0.0 ? (Vector2){(float)(comX / mass), (float)(comY / mass)} : node->body->position;
+        // Bodies sharing a leaf are within QUADTREE_MIN_CELL_SIZE of each other, so their quadrupole is negligible
+        node->quadXX = 0.0f;
+        node->quadXY = 0.0f;
+        node->quadYY = 0.0f;
+        return;
+    }
+
+    double mass = 0.0, comX = 0.0, comY = 0.0;
+    node->maxMass = 0.0f;
+    node->maxRadius = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        QuadTreeNode *child = node->children[i];
+        if (child == NULL)
+            continue;
+        refitQuadTree(child);
+        mass += child->totalMass;
+        comX += (double)child->centerOfMass.x * child->totalMass;
+        comY += (double)child->centerOfMass.y * child->totalMass;
+        node->maxMass = fmaxf(node->maxMass, child->maxMass);
+        node->maxRadius = fmaxf(node->maxRadius, child->maxRadius);
+    }
+
+    node->totalMass = (float)mass;
+    node->quadXX = 0.0f;
+    node->quadXY = 0.0f;
+    node->quadYY = 0.0f;
+    if (mass <= 0.0)
+    {
+        node->centerOfMass = (Vector2){0, 0};
+        return;
+    }
+    comX /= mass;
+    comY /= mass;
+    node->centerOfMass = (Vector2){(float)comX, (float)comY};
+
+    // Parallel axis theorem - shift each child's moment to this node's center of mass
+    double qxx = 0.0, qxy = 0.0, qyy = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        QuadTreeNode *child = node->children[i];
+        if (child == NULL || child->totalMass <= 0.0f)
+            continue;
+        double dx = child->centerOfMass.x - comX;
+        double dy = child->centerOfMass.y - comY;
+        double r2 = dx * dx + dy * dy;
+        qxx += child->quadXX + child->totalMass * (3.0 * dx * dx - r2);
+        qxy += child->quadXY + child->totalMass * (3.0 * dx * dy);
+        qyy += child->quadYY + child->totalMass * (3.0 * dy * dy - r2);
+    }
+    node->quadXX = (float)qxx;
+    node->quadXY = (float)qxy;
+    node->quadYY = (float)qyy;
+}
+
+static bool pointInBounds(Rectangle bounds, Vector2 position)
+{
+    return position.x >= bounds.x && position.x <= bounds.x + bounds.width &&
+           position.y >= bounds.y && position.y <= bounds.y + bounds.height;
+}
+
+Vector2 computeQuadTreeAcceleration(QuadTreeNode *node, Vector2 position, celestialbody_t *self, float theta)
+{
+    /*
+        Gravitational acceleration at position from every body in the tree except self
+        Accepted nodes use monopole + quadrupole terms, so the error falls as theta^3 rather than theta^2
+    */
+    if (node->totalMass == 0)
+        return (Vector2){0, 0};
+    if (node->body != NULL)
+    {
+        Vector2 accel = {0, 0};
+        for (int i = -1; i < node->numExtraBodies; i++)
+        {
+            celestialbody_t *body = i < 0 ? node->body : node->extraBodies[i];
+            if (body == self)
+                continue; // Skip self
+            Vector2 dir = Vector2Subtract(body->position, position);
+            float dist = Vector2Length(dir);
+            if (dist < 1e-5)
+                continue; // Avoid division by zero
+            float mag = (G * body->mass) / (dist * dist);
+            accel = Vector2Add(accel, Vector2Scale(Vector2Normalize(dir), mag));
+        }
+        return accel;
+    }
+    // r points from the center of mass to the evaluation point
+    double rx = position.x - node->centerOfMass.x;
+    double ry = position.y - node->centerOfMass.y;
+    double dist = sqrt(rx * rx + ry * ry);
+    if (dist < 1e-5)
+        dist = 1e-5; // Prevent singularity
+    float size = node->bounds.width;
+    // Never accept a node containing the point - the expansion diverges inside it
+    if (size / dist < theta && !pointInBounds(node->bounds, position))
+    {
+        // a = G * (-M r / r^3 + Q r / r^5 - 5/2 (r.Q.r) r / r^7)
+        double inv2 = 1.0 / (dist * dist);
+        double inv3 = inv2 / dist;
+        double inv5 = inv3 * inv2;
+        double qrx = node->quadXX * rx + node->quadXY * ry;
+        double qry = node->quadXY * rx + node->quadYY * ry;
+        double rqr = rx * qrx + ry * qry;
+        double radial = -node->totalMass * inv3 - 2.5 * rqr * inv5 * inv2;
+        return (Vector2){
+            (float)(G * (radial * rx + qrx * inv5)),
+            (float)(G * (radial * ry + qry * inv5))};
+    }
+    Vector2 accel = {0, 0};
+    for (int i = 0; i < 4; i++)
+    {
+        if (node->children[i])
+        {
+            accel = Vector2Add(accel, computeQuadTreeAcceleration(node->children[i], position, self, theta));
+        }
+    }
+    return accel;
+}
+
+Vector2 computeForce(QuadTreeNode *node, celestialbody_t *body, float theta)
+{
+    return Vector2Scale(computeQuadTreeAcceleration(node, body->position, body, theta), body->mass);
+}
+
+static float distanceSqrToBounds(Rectangle bounds, Vector2 position)
+{
+    float dx = fmaxf(fmaxf(bounds.x - position.x, 0.0f), position.x - (bounds.x + bounds.width));
+    float dy = fmaxf(fmaxf(bounds.y - position.y, 0.0f), position.y - (bounds.y + bounds.height));
+    return dx * dx + dy * dy;
+}
+
+static void offerNearestBody(celestialbody_t *body, float distance, int k, celestialbody_t **nearest, float *distances, int *count)
+{
+    // Keep the k best sorted by distance - k is small so insertion is cheapest
+    if (*count == k && distance >= distances[k - 1])
+        return;
+    int i = (*count < k) ? (*count)++ : k - 1;
+    while (i > 0 && distances[i - 1] > distance)
+    {
+        nearest[i] = nearest[i - 1];
+        distances[i] = distances[i - 1];
+        i--;
+    }
+    nearest[i] = body;
+    distances[i] = distance;
+}
+
+static void searchNearestBodies(QuadTreeNode *node, Vector2 position, int k, celestialbody_t **nearest, float *distances, int *count)
+{
+    if (node->body != NULL)
+    {
+        for (int i = -1; i < node->numExtraBodies; i++)
+        {
+            celestialbody_t *body = i < 0 ? node->body : node->extraBodies[i];
+            offerNearestBody(body, Vector2Distance(position, body->position) - body->radius, k, nearest, distances, count);
+        }
+        return;
+    }
+
+    // Visit closer quadrants first so the k-th distance shrinks quickly and prunes the rest
+    float bound[4];
+    int orderIdx[4], numChildren = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        QuadTreeNode *child = node->children[i];
+        if (child == NULL || (child->body == NULL && child->children[0] == NULL))
+            continue;
+        float childBound = sqrtf(distanceSqrToBounds(child->bounds, position)) - child->maxRadius;
+        int j = numChildren++;
+        while (j > 0 && bound[j - 1] > childBound)
+        {
+            bound[j] = bound[j - 1];
+            orderIdx[j] = orderIdx[j - 1];
+            j--;
+        }
+        bound[j] = childBound;
+        orderIdx[j] = i;
+    }
+    for (int i = 0; i < numChildren; i++)
+    {
+        if (*count == k && bound[i] >= distances[k - 1])
+            break;
+        searchNearestBodies(node->children[orderIdx[i]], position, k, nearest, distances, count);
+    }
+}
+
+int findNearestBodies(QuadTreeNode *root, Vector2 position, int k, celestialbody_t **nearest, float *distances)
+{
+    /*
+        Fills nearest with up to k bodies ordered by distance from position to their surface
+        Returns the number found
+    */
+    int count = 0;
+    if (root == NULL || k <= 0)
+        return 0;
+    searchNearestBodies(root, position, k, nearest, distances, &count);
+    return count;
+}
+
+static float bodyPull(celestialbody_t *body, Vector2 position)
+{
+    // Clamp to the surface so a ship inside a body does not see an infinite pull
+    float dist = fmaxf(Vector2Distance(position, body->position), fmaxf(body->radius, 1e-5f));
+    return body->mass / (dist * dist);
+}
+
+static void searchDominantBody(QuadTreeNode *node, Vector2 position, celestialbody_t **best, float *bestAccel)
+{
+    if (node->body != NULL)
+    {
+        for (int i = -1; i < node->numExtraBodies; i++)
+        {
+            celestialbody_t *body = i < 0 ? node->body : node->extraBodies[i];
+            float accel = bodyPull(body, position);
+            if (accel > *bestAccel)
+            {
+                *bestAccel = accel;
+                *best = body;
+            }
+        }
+        return;
+    }
+
+    // Upper bound on any single body's pull from a quadrant - heaviest body at the closest possible point
+    float bound[4];
+    int orderIdx[4], numChildren = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        QuadTreeNode *child = node->children[i];
+        if (child == NULL || child->maxMass <= 0.0f)
+            continue;
+        float distSqr = distanceSqrToBounds(child->bounds, position);
+        float childBound = distSqr > 0.0f ? child->maxMass / distSqr : INFINITY;
+        int j = numChildren++;
+        while (j > 0 && bound[j - 1] < childBound)
+        {
+            bound[j] = bound[j - 1];
+            orderIdx[j] = orderIdx[j - 1];
+            j--;
+        }
+        bound[j] = childBound;
+        orderIdx[j] = i;
+    }
+    for (int i = 0; i < numChildren; i++)
+    {
+        if (bound[i] <= *bestAccel)
+            break;
+        searchDominantBody(node->children[orderIdx[i]], position, best, bestAccel);
+    }
+}
+
+celestialbody_t *findDominantBody(QuadTreeNode *root, Vector2 position, celestialbody_t *hint)
+{
+    /*
+        Body exerting the strongest gravitational acceleration at position
+        Passing last tick's result as hint seeds the bound, so most of the tree is pruned straight away
+    */
+    celestialbody_t *best = hint;
+    float bestAccel = hint != NULL ? bodyPull(hint, position) : 0.0f;
+    if (root != NULL)
+        searchDominantBody(root, position, &best, &bestAccel);
+    return best;
+}
+
+void freeQuadTree(QuadTreeNode *node)
+{
+    if (!node)
+        return;
+    for (int i = 0; i < 4; i++)
+    {
+        freeQuadTree(node->children[i]);
+    }
+    free(node->extraBodies);
+    free(node);
+}
@@ -0,0 +1,176 @@
+#include "quality.h"
+
+// Each knob's setting at every level, as a multiple of its full-quality value
+static const float knobScales[QUALITY_KNOB_COUNT][QUALITY_LEVELS] = {
+    {1.0f, 0.5f, 0.25f, 0.1f},     // Grid density
+    {1.0f, 2.0f, 4.0f, 8.0f},      // Orbit tolerance
+    {1.0f, 2.0f, 4.0f, 10.0f},     // Ship icon zoom
+    {1.0f, 0.5f, 0.25f, 0.125f},   // Trajectory steps
+    {1.0f, 10.0f, 100.0f, 300.0f}  // Gravity tolerance
+};
+// Longer steps make up some of the horizon lost to fewer of them
+static const float trajectoryStepScales[QUALITY_LEVELS] = {1.0f, 1.5f, 2.0f, 3.0f};
+
+static const char *knobNames[QUALITY_KNOB_COUNT] = {"grid", "orbits", "ship icons", "trajectory", "gravity"};
+
+static bool isSimKnob(QualityKnob knob)
+{
+    return knob == QUALITY_KNOB_TRAJECTORY || knob == QUALITY_KNOB_GRAVITY;
+}
+
+qualitysettings_t getDefaultQualitySettings(void)
+{
+    return (qualitysettings_t){
+        .gridDensity = 1.0f,
+        .orbitTolerance = ORBIT_TOLERANCE,
+        .shipIconZoom = SHIP_ICON_ZOOM,
+        .trajectorySteps = MAX_FUTURE_POSITIONS,
+        .trajectoryStepTime = FUTURE_STEP_TIME,
+        .gravityTolerance = FMM_TOLERANCE};
+}
+
+void applyQualityLevel(qualitysettings_t *settings, QualityKnob knob, int level)
+{
+    // Sets one knob's fields from its level, leaving the others alone
+    level = level < 0 ? 0 : (level >= QUALITY_LEVELS ? QUALITY_LEVELS - 1 : level);
+    float scale = knobScales[knob][level];
+    switch (knob)
+    {
+    case QUALITY_KNOB_GRID:
+        settings->gridDensity = scale;
+        break;
+    case QUALITY_KNOB_ORBITS:
+        settings->orbitTolerance = ORBIT_TOLERANCE * scale;
+        break;
+    case QUALITY_KNOB_SHIP_ICONS:
+        settings->shipIconZoom = SHIP_ICON_ZOOM * scale;
+        break;
+    case QUALITY_KNOB_TRAJECTORY:
+        settings->trajectorySteps = (int)(MAX_FUTURE_POSITIONS * scale);
+        settings->trajectoryStepTime = FUTURE_STEP_TIME * trajectoryStepScales[level];
+        break;
+    case QUALITY_KNOB_GRAVITY:
+        settings->gravityTolerance = FMM_TOLERANCE * scale;
+        break;
+    default:
+        break;
+    }
+}
+
+const char *getQualityKnobName(QualityKnob knob)
+{
+    return knob >= 0 && knob < QUALITY_KNOB_COUNT ? knobNames[knob] : "unknown";
+}
+
+void initQualityGovernor(qualitygovernor_t *governor, int targetFPS, int tickRate)
+{
+    *governor = (qualitygovernor_t){0};
+    governor->enabled = true;
+    governor->frameBudget = QUALITY_BUDGET_FRACTION / targetFPS;
+    governor->tickBudget = QUALITY_BUDGET_FRACTION / tickRate;
+    governor->settings = getDefaultQualitySettings();
+}
+
+void setQualityLevel(qualitygovernor_t *governor, QualityKnob knob, int level)
+{
+    level = level < 0 ? 0 : (level >= QUALITY_LEVELS ? QUALITY_LEVELS - 1 : level);
+    if (level == governor->levels[knob])
+        return;
+    governor->levels[knob] = level;
+    governor->changed[knob] = true;
+    applyQualityLevel(&governor->settings, knob, level);
+}
+
+void reportQualityCost(qualitygovernor_t *governor, QualityKnob knob, float seconds)
+{
+    governor->costs[knob] += (seconds - governor->costs[knob]) * QUALITY_SMOOTHING;
+}
+
+static void adjustQualityBudget(qualitygovernor_t *governor, bool sim, float cost, float budget)
+{
+    int costliest = -1;
+    int cheapest = -1;
+    for (int k = 0; k < QUALITY_KNOB_COUNT; k++)
+    {
+        if (isSimKnob(k) != sim)
+            continue;
+        if (governor->levels[k] < QUALITY_LEVELS - 1 && (costliest < 0 || governor->costs[k] > governor->costs[costliest]))
+            costliest = k;
+        if (governor->levels[k] > 0 && (cheapest < 0 || governor->costs[k] < governor->costs[cheapest]))
+            cheapest = k;
+    }
+
+    // Raising the cheapest knob first means the one most likely to push back over budget is restored last
+    if (cost > budget && costliest >= 0)
+    {
+        setQualityLevel(governor, costliest, governor->levels[costliest] + 1);
+    }
+    else if (cost < budget * QUALITY_RAISE_HEADROOM && cheapest >= 0)
+    {
+        setQualityLevel(governor, cheapest, governor->levels[cheapest] - 1);
+    }
+}
+
+void updateQualityGovernor(qualitygovernor_t *governor, float frameSeconds, float tickSeconds)
+{
+    governor->frameCost += (frameSeconds - governor->frameCost) * QUALITY_SMOOTHING;
+    governor->tickCost += (tickSeconds - governor->tickCost) * QUALITY_SMOOTHING;
+    if (!governor->enabled)
+        return;
+
+    // One step per interval gives the smoothed costs time to show what the last step did
+    if (++governor->framesSinceAdjust < QUALITY_ADJUST_FRAMES)
+        return;
+    governor->framesSinceAdjust = 0;
+    adjustQualityBudget(governor, false, governor->frameCost, governor->frameBudget);
+    adjustQualityBudget(governor, true, governor->tickCost, governor->tickBudget);
+}
+
+static const char *formatQualitySetting(qualitysettings_t *settings, QualityKnob knob)
+{
+    switch (knob)
+    {
+    case QUALITY_KNOB_GRID:
+        return TextFormat("density %.2f", settings->gridDensity);
+    case QUALITY_KNOB_ORBITS:
+        return TextFormat("tolerance %.1fpx", settings->orbitTolerance);
+    case QUALITY_KNOB_SHIP_ICONS:
+        return TextFormat("below zoom %.3f", settings->shipIconZoom);
+    case QUALITY_KNOB_TRAJECTORY:
+        return TextFormat("%i steps of %.2fs", settings->trajectorySteps, settings->trajectoryStepTime);
+    case QUALITY_KNOB_GRAVITY:
+        return TextFormat("tolerance %.0e", settings->gravityTolerance);
+    default:
+        return "";
+    }
+}
+
+void drawQualityOverlay(drawlist_t *list, qualitygovernor_t *governor)
+{
+    // Debug overlay in the bottom left corner - formatted every frame, it is only on while tuning
+    if (!governor->overlay)
+        return;
+
+    int fontSize = 10;
+    int lineHeight = 14;
+    int numLines = 3 + QUALITY_KNOB_COUNT;
+    int x = 10;
+    int y = (int)list->screenSize.y - numLines * lineHeight - 20;
+    drawListRectangle(list, (Rectangle){0, y - 10, 380, numLines * lineHeight + 20}, Fade(BLACK, 0.6f));
+
+    drawListText(list, TextFormat("Quality governor: %s (F4)", governor->enabled ? "on" : "off"), x, y, fontSize, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    y += lineHeight;
+    Color frameColour = governor->frameCost > governor->frameBudget ? ORANGE : LIME;
+    drawListText(list, TextFormat("Frame %.2fms of %.2fms", governor->frameCost * 1000, governor->frameBudget * 1000), x, y, fontSize, DRAW_TEXT_ALIGN_LEFT, frameColour);
+    y += lineHeight;
+    Color tickColour = governor->tickCost > governor->tickBudget ? ORANGE : LIME;
+    drawListText(list, TextFormat("Tick %.2fms of %.2fms", governor->tickCost * 1000, governor->tickBudget * 1000), x, y, fontSize, DRAW_TEXT_ALIGN_LEFT, tickColour);
+    y += lineHeight;
+
+    for (int k = 0; k < QUALITY_KNOB_COUNT; k++)
+    {
+        drawListText(list, TextFormat("%-10s L%i %6.2fms", getQualityKnobName(k), governor->levels[k], governor->costs[k] * 1000), x, y, fontSize, DRAW_TEXT_ALIGN_LEFT, WHITE);
+        drawListText(list, formatQualitySetting(&governor->settings, k), x + 170, y, fontSize, DRAW_TEXT_ALIGN_LEFT, LIGHTGRAY);
+        y += lineHeight;
+    }
+}
@@ -1,10 +1,58 @@
 #include "rendering.h"
+#include "residency.h"
+#include "procedural.h"
 
-void drawBodies(celestialbody_t **bodies, int numBodies)
+static int compareVisibleEntries(const void *a, const void *b)
+{
+    const spatialentry_t *ea = *(const spatialentry_t **)a;
+    const spatialentry_t *eb = *(const spatialentry_t **)b;
+    if (ea->type != eb->type)
+        return ea->type - eb->type;
+    return ea->index - eb->index;
+}
+
+renderview_t createRenderView(void)
+{
+    renderview_t view = {0};
+    view.visible = createSpatialQuery(SPATIAL_QUERY_CAPACITY);
+    return view;
+}
+
+void freeRenderView(renderview_t *view)
+{
+    freeSpatialQuery(&view->visible);
+}
+
+void cullRenderView(renderview_t *view, spatialindex_t *index, Camera2D camera, Vector2 screenSize)
+{
+    view->bounds = getCameraWorldBounds(camera, screenSize);
+    view->zoom = camera.zoom;
+
+    // Pad by the zoomed-out ship icon so icons of ships just off screen are not clipped
+    float margin = CULL_MARGIN / camera.zoom;
+    Rectangle padded = {view->bounds.x - margin, view->bounds.y - margin, view->bounds.width + margin * 2, view->bounds.height + margin * 2};
+
+    querySpatialRect(index, padded, &view->visible);
+    if (view->visible.overflowed)
+    {
+        // Grow to hold every entry so nothing on screen is dropped
+        freeSpatialQuery(&view->visible);
+        view->visible = createSpatialQuery(index->numEntries);
+        querySpatialRect(index, padded, &view->visible);
+    }
+    qsort(view->visible.results, view->visible.count, sizeof(spatialentry_t *), compareVisibleEntries);
+}
+
+void drawBodies(drawlist_t *list, celestialbody_t **bodies, int numBodies, renderview_t *view)
 {
     Color bodyColour;
-    for (int i = numBodies - 1; i >= 0; i--)
+    // Visible entries are sorted by index, walk them backwards to keep the original draw order
+    for (int v = view->visible.count - 1; v >= 0; v--)
     {
+        spatialentry_t *entry = view->visible.results[v];
+        if (entry->type != SPATIAL_BODY || entry->index >= numBodies)
+            continue;
+        int i = entry->index;
         if (bodies[i]->type == TYPE_STAR)
         {
             bodyColour = RED;
@@ -17,222 +65,291 @@ void drawBodies(celestialbody_t **bodies, int numBodies)
         {
             bodyColour = WHITE;
         }
-        DrawCircleV(bodies[i]->position, bodies[i]->radius, bodyColour);
-        DrawCircleV(bodies[i]->position, bodies[i]->atmosphereRadius, bodies[i]->atmosphereColour);
-    }
-}
 
-void drawShips(ship_t **ships, int numShips, Camera2D *camera, Texture2D *shipLogoTexture)
-{
-    for (int i = 0; i < numShips; i++)
-    {
-        // DrawCircleV(ships[i]->position, 32.0f, YELLOW);
-
-        Rectangle source = {
-            0,
-            0,
-            (float)ships[i]->baseTexture.width,
-            (float)ships[i]->baseTexture.height};
-        Rectangle dest = {
-            (float)ships[i]->position.x,
-            (float)ships[i]->position.y,
-            (float)ships[i]->baseTexture.width * ships[i]->textureScale,
-            (float)ships[i]->baseTexture.height * ships[i]->textureScale};
-        Vector2 origin = {
-            (float)((ships[i]->baseTexture.width * ships[i]->textureScale) / 2),
-            (float)((ships[i]->baseTexture.height * ships[i]->textureScale) / 2)};
-
-        // Draw base texture
-        DrawTexturePro(ships[i]->baseTexture, source, dest, origin, ships[i]->rotation, WHITE);
-
-        if (ships[i]->mainEnginesOn)
-        {
-            DrawTexturePro(ships[i]->engineTexture, source, dest, origin, ships[i]->rotation, WHITE);
-        }
-        if (ships[i]->thrusterUp)
-        {
-            DrawTexturePro(ships[i]->thrusterUpTexture, source, dest, origin, ships[i]->rotation, WHITE);
-        }
-        if (ships[i]->thrusterDown)
-        {
-            DrawTexturePro(ships[i]->thrusterDownTexture, source, dest, origin, ships[i]->rotation, WHITE);
-        }
-        if (ships[i]->thrusterRight)
+        // Textured once it is big enough on screen to show and resident, a plain circle until then
+        Texture2D texture;
+        int textureId = bodies[i]->textureId;
+        bool textured = textureId != TEXTURE_NONE && bodies[i]->radius * view->zoom >= TEXTURE_RESIDENCY_MIN_PIXELS;
+        if (textured && textureId == TEXTURE_PROCEDURAL)
+            textureId = getProceduralSurface(i, bodies[i]);
+        if (textured && textureId != TEXTURE_NONE && useResidentTexture(textureId, &texture))
         {
-            DrawTexturePro(ships[i]->thrusterRightTexture, source, dest, origin, ships[i]->rotation, WHITE);
+            float scale = bodies[i]->textureScale > 0 ? bodies[i]->textureScale : 1.0f;
+            float diameter = bodies[i]->radius * 2 * scale;
+            Rectangle source = {0, 0, (float)texture.width, (float)texture.height};
+            Rectangle dest = {bodies[i]->position.x, bodies[i]->position.y, diameter, diameter};
+            drawListTexture(list, texture, source, dest, (Vector2){diameter / 2, diameter / 2}, bodies[i]->rotation, WHITE);
         }
-        if (ships[i]->thrusterLeft)
+        else
         {
-            DrawTexturePro(ships[i]->thrusterLeftTexture, source, dest, origin, ships[i]->rotation, WHITE);
+            drawListCircle(list, bodies[i]->position, bodies[i]->radius, bodyColour);
         }
-        if (ships[i]->thrusterRotateRight)
+        drawListCircle(list, bodies[i]->position, bodies[i]->atmosphereRadius, bodies[i]->atmosphereColour);
+    }
+}
+
+static bool ringVisible(Vector2 center, float radius, Rectangle bounds, float tolerance)
+{
+    // A ring crosses the view unless the view is entirely inside it or entirely outside it
+    float nearX = Clamp(center.x, bounds.x, bounds.x + bounds.width);
+    float nearY = Clamp(center.y, bounds.y, bounds.y + bounds.height);
+    float farX = fmaxf(fabsf(center.x - bounds.x), fabsf(center.x - (bounds.x + bounds.width)));
+    float farY = fmaxf(fabsf(center.y - bounds.y), fabsf(center.y - (bounds.y + bounds.height)));
+    float nearest = Vector2Distance(center, (Vector2){nearX, nearY});
+    float farthest = sqrtf(farX * farX + farY * farY);
+    return nearest <= radius + tolerance && farthest >= radius - tolerance;
+}
+
+/*
+    Orbit rings are tessellated from their projected radius so the chord error stays under tolerance pixels:
+        segments = pi / acos(1 - tolerance / radiusPx)
+    Points are cached around the parent (its local frame) and rebuilt only when zoom moves by ORBIT_RETESSELLATE_FACTOR
+    or the tolerance changes, then only the arcs that cross the view are drawn
+*/
+typedef struct OrbitCache
+{
+    celestialbody_t *body;
+    float radius;    // orbitalRadius the points were built for
+    float zoom;      // Camera zoom the segment count was chosen for
+    float tolerance; // Chord error in pixels the segment count was chosen for
+    int segments;
+    Vector2 *points; // Ring points relative to the parent body
+} orbitcache_t;
+
+static orbitcache_t *orbitCache = NULL;
+static int orbitCacheSize = 0;
+
+static int orbitSegments(float radius, float zoom, float tolerance)
+{
+    // Size for the most zoomed-in view this tessellation will be used at
+    double radiusPx = (double)radius * zoom * ORBIT_RETESSELLATE_FACTOR;
+    if (radiusPx <= tolerance)
+        return ORBIT_MIN_SEGMENTS;
+    double segments = ceil(PI / acos(1.0 - tolerance / radiusPx));
+    return (int)Clamp(segments, ORBIT_MIN_SEGMENTS, ORBIT_MAX_SEGMENTS);
+}
+
+static orbitcache_t *getOrbitCache(int index, celestialbody_t *body, float zoom, float tolerance)
+{
+    if (index >= orbitCacheSize)
+    {
+        orbitcache_t *cache = realloc(orbitCache, sizeof(orbitcache_t) * (index + 1));
+        if (!cache)
         {
-            DrawTexturePro(ships[i]->thrusterRotateRightTexture, source, dest, origin, ships[i]->rotation, WHITE);
+            TraceLog(LOG_ERROR, "Failed to grow orbit cache");
+            return NULL;
         }
-        if (ships[i]->thrusterRotateLeft)
+        for (int i = orbitCacheSize; i <= index; i++)
         {
-            DrawTexturePro(ships[i]->thrusterRotateLeftTexture, source, dest, origin, ships[i]->rotation, WHITE);
+            cache[i] = (orbitcache_t){0};
         }
+        orbitCache = cache;
+        orbitCacheSize = index + 1;
+    }
 
-        if (camera->zoom <= 0.05)
+    orbitcache_t *entry = &orbitCache[index];
+    float ratio = entry->zoom > 0 ? zoom / entry->zoom : 0;
+    if (entry->body == body && entry->radius == body->orbitalRadius && entry->tolerance == tolerance && entry->points != NULL &&
+        ratio <= ORBIT_RETESSELLATE_FACTOR && ratio >= 1.0f / ORBIT_RETESSELLATE_FACTOR)
+    {
+        return entry;
+    }
+
+    int segments = orbitSegments(body->orbitalRadius, zoom, tolerance);
+    if (segments != entry->segments || entry->points == NULL)
+    {
+        Vector2 *points = realloc(entry->points, sizeof(Vector2) * segments);
+        if (!points)
         {
-            source = (Rectangle){
-                0,
-                0,
-                (float)shipLogoTexture->width,
-                (float)shipLogoTexture->height};
-
-            // As zoom gets smaller, size of thing is bigger
-            float textureScale = (1 / camera->zoom) + 8;
-
-            dest = (Rectangle){
-                (float)ships[i]->position.x,
-                (float)ships[i]->position.y,
-                (float)shipLogoTexture->width * textureScale,
-                (float)shipLogoTexture->height * textureScale};
-            origin = (Vector2){
-                (float)((shipLogoTexture->width * textureScale) / 2),
-                (float)((shipLogoTexture->height * textureScale) / 2)};
-
-            DrawTexturePro(*shipLogoTexture, source, dest, origin, ships[i]->rotation, WHITE);
+            TraceLog(LOG_ERROR, "Failed to allocate %i orbit points", segments);
+            return NULL;
         }
+        entry->points = points;
+        entry->segments = segments;
+    }
+    for (int k = 0; k < segments; k++)
+    {
+        float angle = 2 * PI * k / segments;
+        entry->points[k] = (Vector2){body->orbitalRadius * cosf(angle), body->orbitalRadius * sinf(angle)};
     }
+    entry->body = body;
+    entry->radius = body->orbitalRadius;
+    entry->zoom = zoom;
+    entry->tolerance = tolerance;
+    return entry;
 }
 
-void drawOrbits(celestialbody_t **bodies, int numBodies, ColourScheme *colourScheme)
+void freeOrbitCache(void)
 {
-    for (int i = 0; i < numBodies; i++)
+    for (int i = 0; i < orbitCacheSize; i++)
     {
-        if (bodies[i]->orbitalRadius > 0 && bodies[i]->parentBody != NULL)
-        {
-            // DrawCircleLinesV(bodies[i]->parentBody->position, bodies[i]->orbitalRadius, ORBIT_COLOUR);
-            DrawEllipseLines(bodies[i]->parentBody->position.x, bodies[i]->parentBody->position.y, bodies[i]->orbitalRadius, bodies[i]->orbitalRadius, colourScheme->orbitColour);
-        }
+        free(orbitCache[i].points);
     }
+    free(orbitCache);
+    orbitCache = NULL;
+    orbitCacheSize = 0;
+}
+
+static void addRingCrossing(float *angles, int *count, Vector2 center, float x, float y)
+{
+    float angle = atan2f(y - center.y, x - center.x);
+    angles[(*count)++] = angle < 0 ? angle + 2 * PI : angle;
+}
+
+static int compareFloats(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
 }
 
-void drawTrajectories(ship_t **ships, int numShips, ColourScheme *colourScheme)
+static int visibleArcs(Vector2 center, float radius, Rectangle bounds, float *arcStart, float *arcEnd)
 {
-    for (int i = 0; i < numShips; i++)
+    // Angles where the ring crosses the view's edges split it into arcs that are wholly inside or outside
+    float angles[8];
+    int count = 0;
+    float xs[2] = {bounds.x, bounds.x + bounds.width};
+    float ys[2] = {bounds.y, bounds.y + bounds.height};
+    for (int e = 0; e < 2; e++)
     {
-        if (!ships[i]->drawTrajectory)
+        float dx = xs[e] - center.x;
+        if (fabsf(dx) <= radius)
         {
-            continue;
+            float dy = sqrtf(radius * radius - dx * dx);
+            if (center.y - dy >= ys[0] && center.y - dy <= ys[1])
+                addRingCrossing(angles, &count, center, xs[e], center.y - dy);
+            if (center.y + dy >= ys[0] && center.y + dy <= ys[1])
+                addRingCrossing(angles, &count, center, xs[e], center.y + dy);
         }
-        for (int j = 0; j < ships[i]->trajectorySize; j++)
+        float dy = ys[e] - center.y;
+        if (fabsf(dy) <= radius)
         {
-            if (j > 0)
-                DrawLineV(ships[i]->futurePositions[j - 1], ships[i]->futurePositions[j], colourScheme->orbitColour);
+            float dx = sqrtf(radius * radius - dy * dy);
+            if (center.x - dx >= xs[0] && center.x - dx <= xs[1])
+                addRingCrossing(angles, &count, center, center.x - dx, ys[e]);
+            if (center.x + dx >= xs[0] && center.x + dx <= xs[1])
+                addRingCrossing(angles, &count, center, center.x + dx, ys[e]);
         }
     }
-}
 
-void drawStaticGrid(float zoomLevel, int numQuadrants, ColourScheme *colourScheme)
-{
-    int numLines = sqrt(numQuadrants) - 1;
-
-    if (numLines < 1)
+    if (count == 0)
     {
-        return;
+        // No crossings - the ring is either wholly inside the view or not visible at all
+        if (!CheckCollisionPointRec((Vector2){center.x + radius, center.y}, bounds))
+            return 0;
+        arcStart[0] = 0;
+        arcEnd[0] = 2 * PI;
+        return 1;
     }
 
-    int screenWidth = GetScreenWidth();
-    int screenHeight = GetScreenHeight();
-
-    for (int i = 0; i < numLines; i++)
+    qsort(angles, count, sizeof(float), compareFloats);
+    int numArcs = 0;
+    for (int j = 0; j < count; j++)
     {
-        // Draw horizontal line
-        int horizontalHeight = screenHeight * (i + 1) / (numLines + 1);
-        DrawLine(-screenWidth, horizontalHeight, screenWidth, horizontalHeight, colourScheme->gridColour);
-        // Draw vertical line
-        int verticalWidth = screenWidth * (i + 1) / (numLines + 1);
-        DrawLine(verticalWidth, -screenHeight, verticalWidth, screenHeight, colourScheme->gridColour);
+        float a0 = angles[j];
+        float a1 = j + 1 < count ? angles[j + 1] : angles[0] + 2 * PI;
+        if (a1 - a0 < 1e-6f)
+            continue;
+        float mid = (a0 + a1) / 2;
+        if (CheckCollisionPointRec((Vector2){center.x + radius * cosf(mid), center.y + radius * sinf(mid)}, bounds))
+        {
+            arcStart[numArcs] = a0;
+            arcEnd[numArcs] = a1;
+            numArcs++;
+        }
     }
+    return numArcs;
 }
 
-void drawCelestialGrid(celestialbody_t **bodies, int numBodies, Camera2D camera, ColourScheme *colourScheme)
+static void drawOrbitArc(drawlist_t *list, orbitcache_t *cache, Vector2 center, float arcStart, float arcEnd, Color colour)
 {
-    /*
-        Draws a grid with origin (0, 0) to the edges of visible space
-        The grid should scale with the camera to demonstrate distance and velocity
-    */
-    int screenWidth = GetScreenWidth();
-    int screenHeight = GetScreenHeight();
-
-    int gridSpacing;
-
-    // Do not draw grid when zoomed in
-    if (camera.zoom >= 0.01f)
+    // Widen to whole cached segments so the arc runs off the view edges
+    float step = 2 * PI / cache->segments;
+    int first = (int)floorf(arcStart / step);
+    int last = (int)ceilf(arcEnd / step);
+    int count = last - first + 1;
+
+    // World-space points go straight into the list
+    int offset;
+    Vector2 *points = pushDrawPoints(list, count, &offset);
+    if (!points)
         return;
-
-    // Zoom level break points for grid size
-    if (camera.zoom >= 0.002f)
+    for (int k = 0; k < count; k++)
     {
-        gridSpacing = 1e5;
+        points[k] = Vector2Add(center, cache->points[(first + k) % cache->segments]);
     }
-    else if (camera.zoom >= 0.0002f)
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_LINE_STRIP);
+    if (command)
     {
-        gridSpacing = 1e6;
+        command->lineStrip.first = offset;
+        command->lineStrip.count = count;
+        command->lineStrip.colour = colour;
     }
-    else if (camera.zoom >= 0.00002f)
-    {
-        gridSpacing = 1e7;
-    }
-    else if (camera.zoom >= 0.000001f)
-    {
-        gridSpacing = 1e8;
-    }
-    else
+}
+
+void drawOrbits(drawlist_t *list, celestialbody_t **bodies, int numBodies, renderview_t *view, Camera2D *camera, float tolerance, ColourScheme *colourScheme)
+{
+    float margin = 1.0f / camera->zoom;
+    Rectangle padded = {view->bounds.x - margin, view->bounds.y - margin, view->bounds.width + margin * 2, view->bounds.height + margin * 2};
+    for (int i = 0; i < numBodies; i++)
     {
-        gridSpacing = 1e9;
-    }
+        celestialbody_t *parent = getBodyPtr(bodies[i]->parentIndex, bodies, numBodies);
+        if (bodies[i]->orbitalRadius <= 0 || parent == NULL)
+            continue;
+
+        Vector2 center = parent->position;
+        if (!ringVisible(center, bodies[i]->orbitalRadius, padded, 0))
+            continue;
+
+        orbitcache_t *cache = getOrbitCache(i, bodies[i], camera->zoom, tolerance);
+        if (cache == NULL)
+            continue;
 
-    // Calculate visible world-space bounds
-    Vector2 topLeft = GetScreenToWorld2D((Vector2){0, 0}, camera);
-    Vector2 bottomRight = GetScreenToWorld2D((Vector2){screenWidth, screenHeight}, camera);
+        float arcStart[4], arcEnd[4];
+        int numArcs = visibleArcs(center, bodies[i]->orbitalRadius, padded, arcStart, arcEnd);
+        for (int a = 0; a < numArcs; a++)
+        {
+            drawOrbitArc(list, cache, center, arcStart[a], arcEnd[a], colourScheme->orbitColour);
+        }
+    }
+}
 
-    // Snap grid bounds to the nearest gridSpacing multiple
-    float startX = floorf(topLeft.x / gridSpacing) * gridSpacing;
-    float startY = floorf(topLeft.y / gridSpacing) * gridSpacing;
-    float endX = ceilf(bottomRight.x / gridSpacing) * gridSpacing;
-    float endY = ceilf(bottomRight.y / gridSpacing) * gridSpacing;
+void drawStaticGrid(drawlist_t *list, float zoomLevel, int numQuadrants, ColourScheme *colourScheme)
+{
+    int numLines = sqrt(numQuadrants) - 1;
 
-    // Draw vertical lines
-    for (float x = startX; x <= endX; x += gridSpacing)
+    if (numLines < 1)
     {
-        DrawLineV((Vector2){x, startY}, (Vector2){x, endY}, colourScheme->gridColour);
+        return;
     }
 
-    // Draw horizontal lines
-    for (float y = startY; y <= endY; y += gridSpacing)
+    int screenWidth = (int)list->screenSize.x;
+    int screenHeight = (int)list->screenSize.y;
+
+    for (int i = 0; i < numLines; i++)
     {
-        DrawLineV((Vector2){startX, y}, (Vector2){endX, y}, colourScheme->gridColour);
+        // Draw horizontal line
+        int horizontalHeight = screenHeight * (i + 1) / (numLines + 1);
+        drawListLine(list, (Vector2){-screenWidth, horizontalHeight}, (Vector2){screenWidth, horizontalHeight}, colourScheme->gridColour);
+        // Draw vertical line
+        int verticalWidth = screenWidth * (i + 1) / (numLines + 1);
+        drawListLine(list, (Vector2){verticalWidth, -screenHeight}, (Vector2){verticalWidth, screenHeight}, colourScheme->gridColour);
     }
 }
 
-void drawPlayerStats(PlayerStats *playerStats)
+void drawPlayerStats(drawlist_t *list, PlayerStats *playerStats)
 {
-    DrawText("Money:", 10, 40, HUD_FONT_SIZE, WHITE);
-    DrawText(TextFormat("%i$", playerStats->money), 150 - MeasureText(TextFormat("%i$", playerStats->money), HUD_FONT_SIZE), 40, HUD_FONT_SIZE, WHITE);
+    drawListText(list, "Money:", 10, 40, HUD_FONT_SIZE, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(list, TextFormat("%i$", playerStats->money), 150, 40, HUD_FONT_SIZE, DRAW_TEXT_ALIGN_RIGHT, WHITE);
 }
 
-void drawPlayerHUD(HUD *playerHUD)
+static void recordHudStatic(drawlist_t *content, HUD *playerHUD)
 {
-    int screenWidth = GetScreenWidth();
-    int screenHeight = GetScreenHeight();
+    int screenWidth = (int)content->screenSize.x;
+    int screenHeight = (int)content->screenSize.y;
     float wMid = screenWidth / 2;
-    // float hMid = screenHeight / 2;
-    // DrawCircle(wMid, screenHeight - 100, 100, (Color){255, 255, 255, 100});
-    if (playerHUD->velocityTarget)
-    {
-        DrawText(TextFormat("Velocity Lock: %s", playerHUD->velocityTarget->name), screenWidth / 2 - MeasureText(TextFormat("Velocity Lock: %s", playerHUD->velocityTarget->name), 16) / 2, screenHeight - 120, 16, WHITE);
-    }
-    else
-    {
-        // char text = "Velocity Lock: Absolute";
-        DrawText("Velocity Lock: Absolute", screenWidth / 2 - MeasureText("Velocity Lock: Absolute", 16) / 2, screenHeight - 120, 16, WHITE);
-    }
-    DrawText(TextFormat("%.1fm/s", playerHUD->speed), screenWidth / 2 - MeasureText(TextFormat("%.1fm/s", playerHUD->speed), 16) / 2, screenHeight - 100, 16, WHITE);
+
+    drawListText(content, "Press ESC to pause & view controls", 10, 10, 20, DRAW_TEXT_ALIGN_LEFT, DARKGRAY);
 
     Rectangle compassSource = {
         0,
@@ -247,7 +364,59 @@ void drawPlayerHUD(HUD *playerHUD)
     Vector2 compassOrigin = {
         (float)((playerHUD->compassTexture.width) / 2),
         (float)((playerHUD->compassTexture.height) / 2)};
-    DrawTexturePro(playerHUD->compassTexture, compassSource, compassDest, compassOrigin, 0.0f, WHITE);
+    drawListTexture(content, playerHUD->compassTexture, compassSource, compassDest, compassOrigin, 0.0f, WHITE);
+}
+
+static void recordHudPause(drawlist_t *content)
+{
+    int screenWidth = (int)content->screenSize.x;
+    int screenHeight = (int)content->screenSize.y;
+
+    drawListRectangle(content, (Rectangle){0, 0, screenWidth, screenHeight}, Fade(GRAY, 0.5f));
+    drawListText(content, "Game Paused", screenWidth / 2, 200, 40, DRAW_TEXT_ALIGN_CENTRE, WHITE);
+    drawListText(content, "Press ESC to Resume", screenWidth / 2, 300, 20, DRAW_TEXT_ALIGN_CENTRE, WHITE);
+    drawListText(content, "Press S to Save", screenWidth / 2, 340, 20, DRAW_TEXT_ALIGN_CENTRE, WHITE);
+    drawListText(content, "Press Q to Quit", screenWidth / 2, 380, 20, DRAW_TEXT_ALIGN_CENTRE, WHITE);
+    drawListText(content, "Press 'C' to switch camera", 10, 40, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(content, "Press '.' and ',' to time warp", 10, 70, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(content, "Scroll to zoom", 10, 100, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(content, "Press 'V' to switch velocity lock (Auto follows strongest gravity)", 10, 130, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(content, "Click a ship or body to lock camera or velocity", 10, 160, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+    drawListText(content, "Press 'G' to toggle ship mutual gravity", 10, 190, 20, DRAW_TEXT_ALIGN_LEFT, WHITE);
+}
+
+void drawPlayerHUD(drawlist_t *list, HUD *playerHUD)
+{
+    /*
+        Only values that changed at display precision are re-formatted, and text is re-measured only after it changes
+        Labels, the compass and the pause screen are static and baked into layers
+    */
+    int screenWidth = (int)list->screenSize.x;
+    int screenHeight = (int)list->screenSize.y;
+    float wMid = screenWidth / 2;
+    // float hMid = screenHeight / 2;
+    // DrawCircle(wMid, screenHeight - 100, 100, (Color){255, 255, 255, 100});
+
+    drawlist_t *content = beginHudLayer(&playerHUD->staticLayer, list->screenSize);
+    if (content)
+    {
+        recordHudStatic(content, playerHUD);
+    }
+    drawListHudLayer(list, &playerHUD->staticLayer);
+
+    if (playerHUD->velocityTarget)
+    {
+        // Names live as long as their body, so the pointer identifies the text
+        long long key = (long long)(intptr_t)playerHUD->velocityTarget->name * 2 + playerHUD->velocityAuto;
+        setHudText(&playerHUD->lockText, key, "Velocity Lock: %.*s%s", BODY_NAME_LENGTH, playerHUD->velocityTarget->name, playerHUD->velocityAuto ? " (Auto)" : "");
+    }
+    else
+    {
+        setHudText(&playerHUD->lockText, 0, "Velocity Lock: Absolute");
+    }
+    drawListHudText(list, &playerHUD->lockText, screenWidth / 2, screenHeight - 120, 16, DRAW_TEXT_ALIGN_CENTRE, WHITE);
+    setHudNumber(&playerHUD->speedText, playerHUD->speed, 0.1, "%.1fm/s");
+    drawListHudText(list, &playerHUD->speedText, screenWidth / 2, screenHeight - 100, 16, DRAW_TEXT_ALIGN_CENTRE, WHITE);
 
     float widthScale = (playerHUD->arrowTexture.width * -0.5 / 2);
     float heightScale = (playerHUD->arrowTexture.height * -0.5 / 2);
@@ -264,7 +433,31 @@ void drawPlayerHUD(HUD *playerHUD)
     Vector2 arrowOrigin = {
         (float)((playerHUD->arrowTexture.width + widthScale) / 2),
         (float)((playerHUD->arrowTexture.height + heightScale) / 2)};
-    DrawTexturePro(playerHUD->arrowTexture, arrowSource, arrowDest, arrowOrigin, playerHUD->playerRotation, WHITE);
+    drawListTexture(list, playerHUD->arrowTexture, arrowSource, arrowDest, arrowOrigin, playerHUD->playerRotation, WHITE);
+
+    // Same colours as raylib's DrawFPS
+    int fps = GetFPS();
+    Color fpsColour = fps < 15 ? RED : fps < 30 ? ORANGE : LIME;
+    setHudNumber(&playerHUD->fpsText, fps, 1, "%2.0f FPS");
+    drawListHudText(list, &playerHUD->fpsText, screenWidth - 100, 10, 20, DRAW_TEXT_ALIGN_LEFT, fpsColour);
+    setHudNumber(&playerHUD->cameraText, playerHUD->cameraLock, 1, "Camera locked to Ship: %.0f");
+    drawListHudText(list, &playerHUD->cameraText, screenWidth - 280, 40, 20, DRAW_TEXT_ALIGN_LEFT, DARKGRAY);
+    setHudNumber(&playerHUD->timeScaleText, playerHUD->timeScale, 0.1, "Time Scale: %.1fx");
+    drawListHudText(list, &playerHUD->timeScaleText, screenWidth - 200, 70, 20, DRAW_TEXT_ALIGN_LEFT, DARKGRAY);
+    setHudNumber(&playerHUD->zoomText, playerHUD->zoom, 1e-6, "Camera zoom: %.6fx");
+    drawListHudText(list, &playerHUD->zoomText, screenWidth - 250, 100, 20, DRAW_TEXT_ALIGN_LEFT, DARKGRAY);
+    setHudNumber(&playerHUD->throttleText, playerHUD->throttle, 0.01, "Ship throttle: %.2fpct");
+    drawListHudText(list, &playerHUD->throttleText, screenWidth - 250, 130, 20, DRAW_TEXT_ALIGN_LEFT, DARKGRAY);
+
+    if (playerHUD->paused)
+    {
+        content = beginHudLayer(&playerHUD->pauseLayer, list->screenSize);
+        if (content)
+        {
+            recordHudPause(content);
+        }
+        drawListHudLayer(list, &playerHUD->pauseLayer);
+    }
 }
 
 // void drawPlayerInventory(CelestialBody *playerShip, Resource *resourceDefinitions)
@@ -279,35 +472,3 @@ void drawPlayerHUD(HUD *playerHUD)
 //         DrawText(TextFormat("%it", playerShip->shipSettings.inventory[i].quantity), 150 - MeasureText(TextFormat("%it", playerShip->shipSettings.inventory[i].quantity), HUD_FONT_SIZE), (initialHeight + (heightStep * i)), HUD_FONT_SIZE, WHITE);
 //     }
 // }
-
-// void drawBodies(CelestialBody **bodies, int numBodies)
-// {
-//     for (int i = numBodies - 1; i >= 0; i--)
-//     {
-//         float scale = ((bodies[i]->radius * 2) / bodies[i]->texture->width) * bodies[i]->textureScale;
-//         // Source rectangle (part of the texture to use for drawing i.e. the whole texture)
-//         Rectangle source = {
-//             0,
-//             0,
-//             (float)bodies[i]->texture->width,
-//             (float)bodies[i]->texture->height};
-
-//         // Destination rectangle (Screen rectangle locating where to draw the texture)
-//         float widthScale = (bodies[i]->texture->width * scale / 2);
-//         float heightScale = (bodies[i]->texture->height * scale / 2);
-//         Rectangle dest = {
-//             bodies[i]->position.x,
-//             bodies[i]->position.y,
-//             (float)bodies[i]->texture->width + widthScale,
-//             (float)bodies[i]->texture->height + heightScale};
-
-//         // Origin of the texture for rotation and scaling - centre for our purpose
-//         Vector2 origin = {
-//             (float)((bodies[i]->texture->width + widthScale) / 2),
-//             (float)((bodies[i]->texture->height + heightScale) / 2)};
-//         DrawTexturePro(*bodies[i]->texture, source, dest, origin, bodies[i]->rotation, WHITE);
-
-//         // Draw collider for debug
-//         // DrawCircle(bodies[i]->position.x, bodies[i]->position.y, bodies[i]->radius, WHITE);
-//     }
-// }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include "residency.h"
+
+typedef struct ResidentTexture
+{
+    bool held;               // Holds a texture cache reference
+    bool pending;            // Requested and not yet uploaded or failed
+    unsigned int lastUsed;   // Frame of the last useResidentTexture
+    unsigned int retryFrame; // First frame a failed texture may be requested again
+    int failures;            // Failed requests in a row, doubling the wait before each retry
+    size_t bytes;            // GPU size once uploaded, 0 while loading
+} residenttexture_t;
+
+static residenttexture_t *residents = NULL;
+static int numResidents = 0;
+static int numPending = 0; // Requests in flight, capped so streaming cannot fill the loader's slots
+static unsigned int residencyFrame = 1; // Starts at 1 so no texture counts as used before its first request
+
+static residenttexture_t *getResident(int id)
+{
+    if (id >= numResidents)
+    {
+        residenttexture_t *grown = realloc(residents, sizeof(residenttexture_t) * (id + 1));
+        if (!grown)
+        {
+            TraceLog(LOG_ERROR, "Failed to grow texture residency table");
+            return NULL;
+        }
+        for (int i = numResidents; i <= id; i++)
+        {
+            grown[i] = (residenttexture_t){0};
+        }
+        residents = grown;
+        numResidents = id + 1;
+    }
+    return &residents[id];
+}
+
+static void releaseResident(int id)
+{
+    UnloadTextureById(id);
+    if (residents[id].pending)
+        numPending--;
+    residents[id].held = false;
+    residents[id].pending = false;
+    residents[id].bytes = 0;
+}
+
+static void settleResident(int id)
+{
+    // Notices a pending request finishing - a failure drops its reference and backs off before it is asked for again
+    residenttexture_t *resident = &residents[id];
+    if (!resident->pending)
+        return;
+    AssetState state = getTextureState(id);
+    if (state == ASSET_PENDING)
+        return;
+    resident->pending = false;
+    numPending--;
+    if (state == ASSET_READY)
+    {
+        resident->failures = 0;
+        return;
+    }
+    int doublings = resident->failures < TEXTURE_RESIDENCY_MAX_BACKOFF ? resident->failures : TEXTURE_RESIDENCY_MAX_BACKOFF;
+    resident->retryFrame = residencyFrame + (TEXTURE_RESIDENCY_RETRY_FRAMES << doublings);
+    resident->failures++;
+    releaseResident(id);
+    TraceLog(LOG_WARNING, "Texture ID %d failed to stream in, retrying in %d frames", id, TEXTURE_RESIDENCY_RETRY_FRAMES << doublings);
+}
+
+bool useResidentTexture(int id, Texture2D *texture)
+{
+    // Returns true with the texture once it is uploaded, requesting it the first time it is wanted
+    if (id < 0)
+        return false;
+    residenttexture_t *resident = getResident(id);
+    if (!resident)
+        return false;
+    resident->lastUsed = residencyFrame;
+    if (!resident->held)
+    {
+        // Waits out the backoff after a failure, and leaves the request for a later frame while too many are in flight
+        if (residencyFrame < resident->retryFrame || numPending >= TEXTURE_RESIDENCY_MAX_PENDING)
+            return false;
+        requestTextureById(id);
+        resident->held = true;
+        resident->pending = true;
+        numPending++;
+    }
+
+    settleResident(id);
+    if (!resident->held || getTextureState(id) != ASSET_READY)
+        return false;
+    *texture = getTextureById(id);
+    if (resident->bytes == 0)
+        resident->bytes = GetPixelDataSize(texture->width, texture->height, texture->format);
+    return true;
+}
+
+size_t getResidentTextureBytes(void)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < numResidents; i++)
+    {
+        if (residents[i].held)
+            bytes += residents[i].bytes;
+    }
+    return bytes;
+}
+
+int getResidentTextureCount(void)
+{
+    int count = 0;
+    for (int i = 0; i < numResidents; i++)
+    {
+        count += residents[i].held && residents[i].bytes > 0;
+    }
+    return count;
+}
+
+void trimTextureResidency(size_t budgetBytes)
+{
+    // Call after EndDrawing, once the frame's draw list no longer references anything released here
+    // Requests for textures no longer drawn still finish, so they are settled here to free their in-flight places
+    for (int i = 0; i < numResidents; i++)
+    {
+        settleResident(i);
+    }
+
+    size_t bytes = getResidentTextureBytes();
+    while (bytes > budgetBytes)
+    {
+        // Only a handful of body textures are ever held, so a scan beats keeping an ordered list
+        int oldest = -1;
+        for (int i = 0; i < numResidents; i++)
+        {
+            if (residents[i].held && residents[i].lastUsed != residencyFrame &&
+                (oldest < 0 || residents[i].lastUsed < residents[oldest].lastUsed))
+                oldest = i;
+        }
+        if (oldest < 0)
+            break;
+        bytes -= residents[oldest].bytes;
+        releaseResident(oldest);
+    }
+    residencyFrame++;
+}
+
+void releaseTextureResidency(void)
+{
+    for (int i = 0; i < numResidents; i++)
+    {
+        if (residents[i].held)
+            releaseResident(i);
+    }
+    free(residents);
+    residents = NULL;
+    numResidents = 0;
+    numPending = 0;
+}
@@ -0,0 +1,976 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "config.h"
+#include "save.h"
+#include "physics.h"
+#include "compression.h"
+
+// Body records are the file format, so their layout must not drift without a version bump
+_Static_assert(sizeof(celestialbody_t) == 92, "celestialbody_t changed size - bump SAVE_VERSION");
+_Static_assert(SAVE_ALIGNMENT % _Alignof(celestialbody_t) == 0, "body section alignment too small");
+
+static int findBodyIndex(const celestialbody_t *body, celestialbody_t **bodies, int numBodies)
+{
+    // Bodies share one block, which turns a pointer into an index without a search
+    if (!body || numBodies <= 0)
+        return -1;
+    uintptr_t offset = (uintptr_t)body - (uintptr_t)bodies[0];
+    size_t index = offset / sizeof(celestialbody_t);
+    if (offset % sizeof(celestialbody_t) == 0 && index < (size_t)numBodies && bodies[index] == body)
+        return (int)index;
+    return getBodyIndex((celestialbody_t *)body, bodies, numBodies);
+}
+
+static uint64_t alignSaveOffset(uint64_t offset)
+{
+    return (offset + SAVE_ALIGNMENT - 1) / SAVE_ALIGNMENT * SAVE_ALIGNMENT;
+}
+
+static void packShip(const ship_t *ship, int landedIndex, savedship_t *record)
+{
+    *record = (savedship_t){
+        .position = ship->position,
+        .velocity = ship->velocity,
+        .landingPosition = ship->landingPosition,
+        .mass = ship->mass,
+        .rotation = ship->rotation,
+        .rotationSpeed = ship->rotationSpeed,
+        .radius = ship->radius,
+        .thrust = ship->thrust,
+        .throttle = ship->throttle,
+        .thrusterForce = ship->thrusterForce,
+        .fuel = ship->fuel,
+        .fuelConsumption = ship->fuelConsumption,
+        .textureScale = ship->textureScale,
+        .state = ship->state,
+        .type = ship->type,
+        .landedIndex = landedIndex,
+        .trajectorySize = ship->trajectorySize,
+        .textureIds = {ship->baseTextureId, ship->engineTextureId, ship->thrusterUpTextureId, ship->thrusterDownTextureId,
+                       ship->thrusterRightTextureId, ship->thrusterLeftTextureId, ship->thrusterRotateRightTextureId,
+                       ship->thrusterRotateLeftTextureId},
+        .flags = (ship->isSelected ? SAVED_SHIP_SELECTED : 0) | (ship->drawTrajectory ? SAVED_SHIP_DRAW_TRAJECTORY : 0)};
+}
+
+static void copyBodies(celestialbody_t *records, celestialbody_t **bodies, int numBodies)
+{
+    // Bodies normally sit in one block, so this is a single memcpy - the pointers are only followed to find the runs
+    for (int i = 0; i < numBodies;)
+    {
+        int run = 1;
+        while (i + run < numBodies && bodies[i + run] == bodies[i] + run)
+            run++;
+        memcpy(&records[i], bodies[i], sizeof(celestialbody_t) * run);
+        i += run;
+    }
+}
+
+static bool reserveSaveImage(saveimage_t *image, size_t size, const char *filename)
+{
+    if (image->capacity >= size)
+        return true;
+    unsigned char *grown = realloc(image->data, size);
+    if (!grown)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate save buffers for %s", filename);
+        return false;
+    }
+    image->data = grown;
+    image->capacity = size;
+    return true;
+}
+
+bool captureSave(gamestate_t *state, const char *filename, saveimage_t *image)
+{
+    // Lays the file out in image, growing it if the universe has - the state is only read, never walked twice
+    int numBodies = state->numBodies;
+    int numShips = state->numShips;
+    savesectionentry_t sections[] = {
+        {.type = SAVE_SECTION_STATE, .recordSize = sizeof(savedstate_t), .count = 1},
+        {.type = SAVE_SECTION_BODIES, .recordSize = sizeof(celestialbody_t), .count = numBodies},
+        {.type = SAVE_SECTION_SHIPS, .recordSize = sizeof(savedship_t), .count = numShips}};
+    int numSections = sizeof(sections) / sizeof(sections[0]);
+    uint64_t offset = sizeof(saveheader_t) + sizeof(sections);
+    for (int s = 0; s < numSections; s++)
+    {
+        sections[s].offset = alignSaveOffset(offset);
+        sections[s].storedSize = sections[s].count * sections[s].recordSize;
+        sections[s].encoding = SAVE_ENCODING_RAW;
+        offset = sections[s].offset + sections[s].storedSize;
+    }
+
+    image->size = 0;
+    snprintf(image->filename, sizeof(image->filename), "%s", filename);
+    if (!reserveSaveImage(image, offset, filename))
+        return false;
+
+    // Zero the header and the padding before each section, so the file holds nothing left over from the last save
+    unsigned char *data = image->data;
+    size_t written = 0;
+    for (int s = 0; s < numSections; s++)
+    {
+        memset(data + written, 0, sections[s].offset - written);
+        written = sections[s].offset + sections[s].count * sections[s].recordSize;
+    }
+    saveheader_t header = {.magic = SAVE_MAGIC, .version = SAVE_VERSION, .numSections = numSections};
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), sections, sizeof(sections));
+
+    savedstate_t savedState = {.gameTime = state->gameTime};
+    memcpy(data + sections[0].offset, &savedState, sizeof(savedState));
+    copyBodies((celestialbody_t *)(data + sections[1].offset), state->bodies, numBodies);
+    savedship_t *ships = (savedship_t *)(data + sections[2].offset);
+    for (int i = 0; i < numShips; i++)
+    {
+        packShip(state->ships[i], findBodyIndex(state->ships[i]->landedBody, state->bodies, numBodies), &ships[i]);
+    }
+    image->size = offset;
+    return true;
+}
+
+static uint32_t hashJournalPayload(const unsigned char *data, size_t size)
+{
+    // 32-bit FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool captureSaveJournal(gamestate_t *state, savejournal_t *journal, const char *filename, saveimage_t *image)
+{
+    // Lays out one journal entry in image. Returns false when the universe has changed shape since the journal was
+    // reset, as entries only replace records and a new base is needed
+    image->size = 0;
+    snprintf(image->filename, sizeof(image->filename), "%s", filename);
+    if (state->numBodies != journal->numBodies || state->numShips != journal->numShips)
+        return false;
+
+    size_t worstCase = sizeof(savejournalheader_t) + sizeof(savedshipchange_t) * state->numShips;
+    if (!reserveSaveImage(image, worstCase, filename))
+        return false;
+
+    // Only ships marked dirty since the last entry are packed - the bitset is missing only if resetSaveJournal could not
+    // allocate it, and then every ship is compared against its last record instead
+    unsigned char *out = image->data + sizeof(savejournalheader_t);
+    savejournalheader_t header = {.magic = SAVE_JOURNAL_MAGIC, .gameTime = state->gameTime};
+    int words = (state->numShips + 63) / 64;
+    for (int w = 0; w < words; w++)
+    {
+        uint64_t bits = state->dirtyShips ? state->dirtyShips[w] : ~0ull;
+        for (; bits; bits &= bits - 1)
+        {
+            int i = w * 64 + __builtin_ctzll(bits);
+            if (i >= state->numShips)
+                break;
+            savedshipchange_t change = {.index = i};
+            packShip(state->ships[i], findBodyIndex(state->ships[i]->landedBody, state->bodies, state->numBodies),
+                     &change.ship);
+            if (memcmp(&change.ship, &journal->ships[i], sizeof(savedship_t)) == 0)
+                continue;
+            journal->ships[i] = change.ship;
+            memcpy(out, &change, sizeof(change));
+            out += sizeof(change);
+            header.numShips++;
+        }
+        if (state->dirtyShips)
+            state->dirtyShips[w] = 0;
+    }
+
+    header.payloadSize = out - image->data - sizeof(header);
+    header.checksum = hashJournalPayload(image->data + sizeof(header), header.payloadSize);
+    memcpy(image->data, &header, sizeof(header));
+    image->size = out - image->data;
+    return true;
+}
+
+void resetSaveJournal(gamestate_t *state, savejournal_t *journal)
+{
+    // Called once a base has been captured - entries after it hold changes from what it holds
+    if (journal->numShips < state->numShips || !journal->ships)
+    {
+        savedship_t *grown = realloc(journal->ships, sizeof(savedship_t) * (state->numShips > 0 ? state->numShips : 1));
+        if (!grown)
+        {
+            // Leaves the journal unable to match the state, so the next autosave is another base
+            TraceLog(LOG_ERROR, "Failed to allocate save journal");
+            journal->numBodies = -1;
+            return;
+        }
+        journal->ships = grown;
+    }
+    for (int i = 0; i < state->numShips; i++)
+    {
+        packShip(state->ships[i], findBodyIndex(state->ships[i]->landedBody, state->bodies, state->numBodies),
+                 &journal->ships[i]);
+    }
+    journal->numShips = state->numShips;
+    journal->numBodies = state->numBodies;
+
+    // Sized afresh for each base, the only point the number of ships may have changed
+    free(state->dirtyShips);
+    state->dirtyShips = calloc((state->numShips + 63) / 64 > 0 ? (state->numShips + 63) / 64 : 1, sizeof(uint64_t));
+    if (!state->dirtyShips)
+        TraceLog(LOG_WARNING, "Failed to allocate ship dirty bits, journal entries will compare every ship");
+}
+
+void freeSaveJournal(savejournal_t *journal)
+{
+    free(journal->ships);
+    *journal = (savejournal_t){0};
+}
+
+static void syncParentDirectory(const char *filename)
+{
+    // The rename only survives a crash once the directory entry is on disk too
+    char directory[SAVE_PATH_CAPACITY];
+    snprintf(directory, sizeof(directory), "%s", filename);
+    char *slash = strrchr(directory, '/');
+    if (slash)
+        *slash = '\0';
+    int fd = open(slash ? directory : ".", O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t done = 0; done < size;)
+    {
+        ssize_t n = write(fd, bytes + done, size - done);
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+static void shuffleRecords(const unsigned char *src, unsigned char *dst, size_t count, size_t recordSize)
+{
+    // Byte j of every record together - a field's bytes are alike from record to record even when whole records differ
+    for (size_t j = 0; j < recordSize; j++)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[j * count + i] = src[i * recordSize + j];
+    }
+}
+
+static void unshuffleRecords(const unsigned char *src, unsigned char *dst, size_t count, size_t recordSize)
+{
+    for (size_t j = 0; j < recordSize; j++)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i * recordSize + j] = src[j * count + i];
+    }
+}
+
+static void omitDerivedFields(celestialbody_t *bodies, size_t first, size_t count)
+{
+    // A body on rails is placed from its parent every tick, in index order, so only a parent before it gives the same
+    // position again when loading repeats that
+    for (size_t i = 0; i < count; i++)
+    {
+        celestialbody_t *body = &bodies[i];
+        if (body->orbitalRadius > 0 && body->parentIndex >= 0 && (size_t)body->parentIndex < first + i)
+            body->position = (Vector2){0, 0};
+    }
+}
+
+static bool writeSaveBlocks(int fd, const unsigned char *records, savesectionentry_t *section, bool omitDerived)
+{
+    // Encodes one block at a time, so only a block's worth of the compressed section is ever held
+    size_t recordSize = section->recordSize;
+    size_t blockRecords = SAVE_BLOCK_SIZE / recordSize > 0 ? SAVE_BLOCK_SIZE / recordSize : 1;
+    size_t blockSize = blockRecords * recordSize;
+    size_t bound = compressBound(blockSize);
+    unsigned char *block = malloc(blockSize * 2 + bound);
+    if (!block)
+        return false;
+    unsigned char *shuffled = block + blockSize;
+    unsigned char *compressed = shuffled + blockSize;
+
+    bool ok = true;
+    uint64_t stored = 0;
+    for (size_t first = 0; first < section->count && ok; first += blockRecords)
+    {
+        size_t count = section->count - first < blockRecords ? section->count - first : blockRecords;
+        size_t size = count * recordSize;
+        memcpy(block, records + first * recordSize, size);
+        if (omitDerived)
+            omitDerivedFields((celestialbody_t *)block, first, count);
+        shuffleRecords(block, shuffled, count, recordSize);
+        size_t compressedSize = compressBlock(shuffled, size, compressed, bound);
+        bool keep = compressedSize > 0 && compressedSize < size;
+        saveblockheader_t header = {(uint32_t)size, (uint32_t)(keep ? compressedSize : size)};
+        ok = writeAll(fd, &header, sizeof(header)) && writeAll(fd, keep ? compressed : shuffled, header.storedSize);
+        stored += sizeof(header) + header.storedSize;
+    }
+    section->storedSize = stored;
+    section->encoding = SAVE_ENCODING_BLOCKS;
+    free(block);
+    return ok;
+}
+
+static bool writeCompressedSave(int fd, const saveimage_t *image)
+{
+    // Sections go out after room for the header and table, which are written last once the sections are placed
+    saveheader_t header;
+    savesectionentry_t sections[SAVE_MAX_SECTIONS];
+    memcpy(&header, image->data, sizeof(header));
+    size_t tableSize = sizeof(savesectionentry_t) * header.numSections;
+    memcpy(sections, image->data + sizeof(header), tableSize);
+    header.flags |= SAVE_COMPRESS_BODIES && SAVE_OMIT_DERIVED ? SAVE_FLAG_DERIVED_OMITTED : 0;
+
+    uint64_t offset = sizeof(header) + tableSize;
+    bool ok = true;
+    for (uint32_t s = 0; s < header.numSections && ok; s++)
+    {
+        const unsigned char *records = image->data + sections[s].offset;
+        if (sections[s].type == SAVE_SECTION_BODIES && !SAVE_COMPRESS_BODIES)
+        {
+            // Bodies stay raw and aligned, so loading still maps them in place - the gap before them reads as zeros
+            offset = alignSaveOffset(offset);
+            sections[s].offset = offset;
+            ok = lseek(fd, offset, SEEK_SET) == (off_t)offset && writeAll(fd, records, sections[s].storedSize);
+            offset += sections[s].storedSize;
+            continue;
+        }
+        bool omitDerived = SAVE_OMIT_DERIVED && sections[s].type == SAVE_SECTION_BODIES;
+        sections[s].offset = offset;
+        ok = lseek(fd, offset, SEEK_SET) == (off_t)offset && writeSaveBlocks(fd, records, &sections[s], omitDerived);
+        offset += sections[s].storedSize;
+    }
+    return ok && pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+           pwrite(fd, sections, tableSize, sizeof(header)) == (ssize_t)tableSize;
+}
+
+bool writeSaveImage(const saveimage_t *image)
+{
+    // Written beside the old save and renamed over it, so a crash leaves one whole save or the other, and a loaded save
+    // still mapped from the old file is never truncated underneath the game
+    char tempName[SAVE_PATH_CAPACITY + 4];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", image->filename);
+    int fd = open(tempName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        TraceLog(LOG_ERROR, "Failed to open file for saving: %s", tempName);
+        return false;
+    }
+    bool ok = SAVE_COMPRESSION ? writeCompressedSave(fd, image) : writeAll(fd, image->data, image->size);
+    ok = fsync(fd) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(tempName, image->filename) == 0;
+    if (!ok)
+    {
+        TraceLog(LOG_ERROR, "Write error saving %s", image->filename);
+        remove(tempName);
+        return false;
+    }
+    syncParentDirectory(image->filename);
+    return true;
+}
+
+static bool appendSaveJournal(const saveimage_t *image)
+{
+    // A torn append is caught by its checksum on load, and the writer starts a new base rather than append after it
+    int fd = open(image->filename, O_WRONLY | O_APPEND);
+    if (fd < 0)
+    {
+        TraceLog(LOG_ERROR, "Failed to open %s to journal to", image->filename);
+        return false;
+    }
+    bool ok = writeAll(fd, image->data, image->size);
+    ok = fsync(fd) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+    if (!ok)
+        TraceLog(LOG_ERROR, "Write error journaling to %s", image->filename);
+    return ok;
+}
+
+bool saveGame(const char *filename, gamestate_t *state)
+{
+    // Captures and writes on the calling thread - the game itself saves through a save writer
+    saveimage_t image = {0};
+    bool ok = captureSave(state, filename, &image) && writeSaveImage(&image);
+    if (ok)
+        TraceLog(LOG_INFO, "Game state saved to %s", filename);
+    free(image.data);
+    return ok;
+}
+
+static const savesectionentry_t *findSaveSection(const savesectionentry_t *sections, int numSections, SaveSection type)
+{
+    for (int s = 0; s < numSections; s++)
+    {
+        if (sections[s].type == (uint32_t)type)
+            return &sections[s];
+    }
+    return NULL;
+}
+
+static bool saveSectionFits(const savesectionentry_t *section, size_t fileSize)
+{
+    // Counts are already capped at INT32_MAX, so the raw size cannot overflow
+    uint64_t rawSize = section->count * section->recordSize;
+    if (section->recordSize == 0 || section->offset > fileSize || section->storedSize > fileSize - section->offset)
+        return false;
+    if (section->encoding == SAVE_ENCODING_RAW)
+        return rawSize == section->storedSize;
+    // No block expands its records more than the codec can, which bounds what decoding allocates by the file size
+    return section->encoding == SAVE_ENCODING_BLOCKS && rawSize / 256 <= section->storedSize;
+}
+
+static bool decodeSaveSection(const unsigned char *data, const savesectionentry_t *section, unsigned char *records)
+{
+    size_t recordSize = section->recordSize;
+    size_t total = section->count * recordSize;
+    const unsigned char *ip = data + section->offset;
+    const unsigned char *end = ip + section->storedSize;
+    unsigned char *scratch = NULL;
+    size_t scratchSize = 0;
+    size_t done = 0;
+    bool ok = true;
+    while (ok && done < total)
+    {
+        saveblockheader_t block;
+        if ((size_t)(end - ip) < sizeof(block))
+            break;
+        memcpy(&block, ip, sizeof(block));
+        ip += sizeof(block);
+        ok = block.rawSize > 0 && block.rawSize % recordSize == 0 && block.rawSize <= total - done &&
+             block.storedSize <= (size_t)(end - ip);
+        if (ok && block.rawSize > scratchSize)
+        {
+            unsigned char *grown = realloc(scratch, block.rawSize);
+            ok = grown != NULL;
+            scratch = ok ? grown : scratch;
+            scratchSize = ok ? block.rawSize : scratchSize;
+        }
+        if (ok && block.storedSize == block.rawSize)
+            memcpy(scratch, ip, block.rawSize);
+        else if (ok)
+            ok = decompressBlock(ip, block.storedSize, scratch, block.rawSize);
+        if (ok)
+        {
+            unshuffleRecords(scratch, records + done, block.rawSize / recordSize, recordSize);
+            ip += block.storedSize;
+            done += block.rawSize;
+        }
+    }
+    free(scratch);
+    return ok && done == total;
+}
+
+static const unsigned char *getSaveRecords(const unsigned char *data, const savesectionentry_t *section,
+                                           unsigned char **decoded)
+{
+    // Raw sections are read straight from the mapping, encoded ones are decoded into *decoded for the caller to free
+    *decoded = NULL;
+    if (section->encoding == SAVE_ENCODING_RAW)
+        return data + section->offset;
+    size_t size = section->count * section->recordSize;
+    *decoded = malloc(size > 0 ? size : 1);
+    if (*decoded && decodeSaveSection(data, section, *decoded))
+        return *decoded;
+    free(*decoded);
+    *decoded = NULL;
+    return NULL;
+}
+
+static void copySaveRecord(void *record, size_t recordSize, const unsigned char *records, size_t savedRecordSize,
+                           size_t index)
+{
+    // Older, shorter records are zero-extended and newer, longer ones truncated
+    size_t copy = recordSize < savedRecordSize ? recordSize : savedRecordSize;
+    memcpy(record, records + index * savedRecordSize, copy);
+    memset((unsigned char *)record + copy, 0, recordSize - copy);
+}
+
+static uint64_t getSaveJournalOffset(const savesectionentry_t *sections, int numSections)
+{
+    // Journal entries follow whichever section ends last
+    uint64_t end = 0;
+    for (int s = 0; s < numSections; s++)
+    {
+        if (sections[s].offset + sections[s].storedSize > end)
+            end = sections[s].offset + sections[s].storedSize;
+    }
+    return end;
+}
+
+static int replaySaveJournal(const char *filename, const unsigned char *data, size_t offset, size_t fileSize,
+                             savedship_t *ships, int numShips, float *gameTime)
+{
+    // Applies entries in order and returns how many, stopping at the first that is torn or does not fit this save
+    int applied = 0;
+    while (offset < fileSize)
+    {
+        savejournalheader_t header;
+        if (fileSize - offset < sizeof(header))
+            break;
+        memcpy(&header, data + offset, sizeof(header));
+        const unsigned char *payload = data + offset + sizeof(header);
+        uint64_t expected = (uint64_t)header.numShips * sizeof(savedshipchange_t);
+        if (header.magic != SAVE_JOURNAL_MAGIC || header.payloadSize != expected ||
+            header.payloadSize > fileSize - offset - sizeof(header) ||
+            hashJournalPayload(payload, header.payloadSize) != header.checksum)
+            break;
+
+        // Every index is checked before any change is applied, so an entry is taken whole or not at all
+        bool fits = true;
+        for (uint32_t i = 0; i < header.numShips && fits; i++)
+        {
+            uint32_t index;
+            memcpy(&index, payload + i * sizeof(savedshipchange_t), sizeof(index));
+            fits = index < (uint32_t)numShips;
+        }
+        if (!fits)
+            break;
+
+        for (uint32_t i = 0; i < header.numShips; i++)
+        {
+            savedshipchange_t change;
+            memcpy(&change, payload + i * sizeof(change), sizeof(change));
+            ships[change.index] = change.ship;
+        }
+        *gameTime = header.gameTime;
+        offset += sizeof(header) + header.payloadSize;
+        applied++;
+    }
+    if (offset < fileSize)
+        TraceLog(LOG_WARNING, "Dropped %zu bytes of torn journal at the end of %s", fileSize - offset, filename);
+    return applied;
+}
+
+static ship_t *unpackShip(const savedship_t *record, celestialbody_t **bodies, int numBodies)
+{
+    ship_t *ship = malloc(sizeof(ship_t));
+    if (!ship)
+        return NULL;
+    // Thruster and engine flags are input state and start off
+    *ship = (ship_t){
+        .position = record->position,
+        .velocity = record->velocity,
+        .landingPosition = record->landingPosition,
+        .mass = record->mass,
+        .rotation = record->rotation,
+        .rotationSpeed = record->rotationSpeed,
+        .radius = record->radius,
+        .thrust = record->thrust,
+        .throttle = record->throttle,
+        .thrusterForce = record->thrusterForce,
+        .fuel = record->fuel,
+        .fuelConsumption = record->fuelConsumption,
+        .textureScale = record->textureScale,
+        .state = record->state,
+        .type = record->type,
+        .landedBody = getBodyPtr(record->landedIndex, bodies, numBodies),
+        .trajectorySize = record->trajectorySize < 1 ? 1 : (record->trajectorySize > MAX_FUTURE_POSITIONS ? MAX_FUTURE_POSITIONS : record->trajectorySize),
+        .baseTextureId = record->textureIds[0],
+        .engineTextureId = record->textureIds[1],
+        .thrusterUpTextureId = record->textureIds[2],
+        .thrusterDownTextureId = record->textureIds[3],
+        .thrusterRightTextureId = record->textureIds[4],
+        .thrusterLeftTextureId = record->textureIds[5],
+        .thrusterRotateRightTextureId = record->textureIds[6],
+        .thrusterRotateLeftTextureId = record->textureIds[7],
+        .isSelected = record->flags & SAVED_SHIP_SELECTED,
+        .drawTrajectory = record->flags & SAVED_SHIP_DRAW_TRAJECTORY};
+    ship->futurePositions = malloc(sizeof(Vector2) * ship->trajectorySize);
+    if (!ship->futurePositions)
+    {
+        free(ship);
+        return NULL;
+    }
+    return ship;
+}
+
+bool loadGame(const char *filename, gamestate_t *state)
+{
+    // Maps the save into state, which should not hold any bodies or ships yet. The mapping is private, so the
+    // simulation writes to its own copy of each body page and never back to the file
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        TraceLog(LOG_ERROR, "Failed to open file for loading: %s", filename);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(saveheader_t))
+    {
+        TraceLog(LOG_ERROR, "%s is not a save file", filename);
+        close(fd);
+        return false;
+    }
+    size_t fileSize = info.st_size;
+    unsigned char *data = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        TraceLog(LOG_ERROR, "Failed to map %s", filename);
+        return false;
+    }
+
+    celestialbody_t *store = NULL;
+    unsigned char *decodedState = NULL, *decodedBodies = NULL, *decodedShips = NULL;
+    celestialbody_t **bodies = NULL;
+    savedship_t *shipStates = NULL;
+    ship_t **ships = NULL;
+    int numBodies = 0, numShips = 0;
+    bool inPlace = false;
+    bool ok = false;
+
+    saveheader_t header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SAVE_MAGIC)
+    {
+        TraceLog(LOG_ERROR, "%s is not a save file", filename);
+        goto cleanup;
+    }
+    if (header.version != SAVE_VERSION)
+    {
+        TraceLog(LOG_ERROR, "%s is save version %u, this build reads %u", filename, header.version, SAVE_VERSION);
+        goto cleanup;
+    }
+    if (header.numSections > SAVE_MAX_SECTIONS)
+    {
+        TraceLog(LOG_ERROR, "%s is truncated or corrupt", filename);
+        goto cleanup;
+    }
+    savesectionentry_t sections[SAVE_MAX_SECTIONS];
+    size_t tableSize = sizeof(savesectionentry_t) * header.numSections;
+    if (fileSize - sizeof(header) < tableSize)
+    {
+        TraceLog(LOG_ERROR, "Failed to read the section table of %s", filename);
+        goto cleanup;
+    }
+    memcpy(sections, data + sizeof(header), tableSize);
+
+    const savesectionentry_t *stateSection = findSaveSection(sections, header.numSections, SAVE_SECTION_STATE);
+    const savesectionentry_t *bodySection = findSaveSection(sections, header.numSections, SAVE_SECTION_BODIES);
+    const savesectionentry_t *shipSection = findSaveSection(sections, header.numSections, SAVE_SECTION_SHIPS);
+    if (!stateSection || !bodySection || !shipSection || stateSection->count != 1 || bodySection->count > INT32_MAX ||
+        shipSection->count > INT32_MAX)
+    {
+        TraceLog(LOG_ERROR, "%s is missing sections", filename);
+        goto cleanup;
+    }
+    if (!saveSectionFits(stateSection, fileSize) || !saveSectionFits(bodySection, fileSize) ||
+        !saveSectionFits(shipSection, fileSize))
+    {
+        TraceLog(LOG_ERROR, "%s is truncated or corrupt", filename);
+        goto cleanup;
+    }
+
+    const unsigned char *stateRecords = getSaveRecords(data, stateSection, &decodedState);
+    const unsigned char *shipRecords = getSaveRecords(data, shipSection, &decodedShips);
+    if (!stateRecords || !shipRecords)
+    {
+        TraceLog(LOG_ERROR, "%s is truncated or corrupt", filename);
+        goto cleanup;
+    }
+
+    // Records are not checked one by one, which would fault in every page - indices go through getBodyPtr and names
+    // are printed with a bounded length, so a bad record misbehaves rather than reading outside the save
+    int savedNumBodies = bodySection->count;
+    int savedNumShips = shipSection->count;
+    inPlace = bodySection->encoding == SAVE_ENCODING_RAW && bodySection->recordSize == sizeof(celestialbody_t) &&
+              bodySection->offset % _Alignof(celestialbody_t) == 0;
+    if (inPlace)
+    {
+        store = (celestialbody_t *)(data + bodySection->offset);
+    }
+    else
+    {
+        const unsigned char *bodyRecords = getSaveRecords(data, bodySection, &decodedBodies);
+        if (!bodyRecords)
+        {
+            TraceLog(LOG_ERROR, "%s is truncated or corrupt", filename);
+            goto cleanup;
+        }
+        if (decodedBodies && bodySection->recordSize == sizeof(celestialbody_t))
+        {
+            // Decoded records are already what the game runs on
+            store = (celestialbody_t *)decodedBodies;
+            decodedBodies = NULL;
+        }
+        else
+        {
+            store = malloc(sizeof(celestialbody_t) * (savedNumBodies > 0 ? savedNumBodies : 1));
+            if (!store)
+                goto cleanup;
+            for (int i = 0; i < savedNumBodies; i++)
+                copySaveRecord(&store[i], sizeof(celestialbody_t), bodyRecords, bodySection->recordSize, i);
+        }
+    }
+    bodies = malloc(sizeof(celestialbody_t *) * (savedNumBodies > 0 ? savedNumBodies : 1));
+    shipStates = malloc(sizeof(savedship_t) * (savedNumShips > 0 ? savedNumShips : 1));
+    ships = malloc(sizeof(ship_t *) * (savedNumShips > 0 ? savedNumShips : 1));
+    if (!bodies || !shipStates || !ships)
+        goto cleanup;
+    for (int i = 0; i < savedNumShips; i++)
+    {
+        copySaveRecord(&shipStates[i], sizeof(savedship_t), shipRecords, shipSection->recordSize, i);
+    }
+
+    // Journal entries replace records, so they are applied before anything is built from them
+    savedstate_t savedState;
+    copySaveRecord(&savedState, sizeof(savedState), stateRecords, stateSection->recordSize, 0);
+    int entries = replaySaveJournal(filename, data, getSaveJournalOffset(sections, header.numSections), fileSize,
+                                    shipStates, savedNumShips, &savedState.gameTime);
+
+    for (; numBodies < savedNumBodies; numBodies++)
+    {
+        bodies[numBodies] = &store[numBodies];
+    }
+    for (; numShips < savedNumShips; numShips++)
+    {
+        if (!(ships[numShips] = unpackShip(&shipStates[numShips], bodies, numBodies)))
+            goto cleanup;
+    }
+    if ((header.flags & SAVE_FLAG_DERIVED_OMITTED) || entries > 0)
+    {
+        // Landed ships are only journaled when something is done to them, so they are put back on their bodies too
+        updateCelestialPositions(bodies, numBodies, savedState.gameTime);
+        updateLandedShipPosition(ships, numShips, bodies, numBodies, savedState.gameTime);
+    }
+    state->gameTime = savedState.gameTime;
+    state->bodies = bodies;
+    state->numBodies = numBodies;
+    state->ships = ships;
+    state->numShips = numShips;
+    state->saveMapping = inPlace ? data : NULL;
+    state->saveMappingSize = inPlace ? fileSize : 0;
+    ok = true;
+    if (entries > 0)
+        TraceLog(LOG_INFO, "Game state loaded from %s with %d journal entries", filename, entries);
+    else
+        TraceLog(LOG_INFO, "Game state loaded from %s", filename);
+
+cleanup:
+    if (!ok)
+    {
+        if (!inPlace)
+            free(store);
+        free(bodies);
+        freeShips(ships, numShips);
+    }
+    if (!ok || !inPlace)
+        munmap(data, fileSize);
+    free(shipStates);
+    free(decodedState);
+    free(decodedBodies);
+    free(decodedShips);
+    return ok;
+}
+
+void unloadGame(gamestate_t *state)
+{
+    // Frees whatever initNewGame or loadGame left in state
+    freeShips(state->ships, state->numShips);
+    if (state->saveMapping)
+    {
+        free(state->bodies);
+        munmap(state->saveMapping, state->saveMappingSize);
+    }
+    else
+    {
+        freeCelestialBodies(state->bodies, state->numBodies);
+    }
+    state->bodies = NULL;
+    state->numBodies = 0;
+    state->ships = NULL;
+    state->numShips = 0;
+    state->saveMapping = NULL;
+    state->saveMappingSize = 0;
+    free(state->dirtyShips);
+    state->dirtyShips = NULL;
+}
+
+bool compactSave(const char *filename)
+{
+    // Rolls a base and its journal into a new base. Runs on the save writer thread, which is the only writer of the file
+    gamestate_t state = {0};
+    if (!loadGame(filename, &state))
+        return false;
+    bool ok = saveGame(filename, &state);
+    unloadGame(&state);
+    return ok;
+}
+
+const char *getNewestSave(const char *first, const char *second)
+{
+    // Whichever of two saves was written last, or whichever exists
+    struct stat firstInfo, secondInfo;
+    bool hasFirst = stat(first, &firstInfo) == 0;
+    bool hasSecond = stat(second, &secondInfo) == 0;
+    if (hasFirst && hasSecond)
+        return secondInfo.st_mtime > firstInfo.st_mtime ? second : first;
+    return hasSecond ? second : first;
+}
+
+static bool writeQueuedSave(savewriter_t *writer, const saveimage_t *image)
+{
+    // Returns false when the journal was lost and the next autosave has to be a base. Bases and entries are written
+    // in the order they were captured, so an entry always follows the base it was captured against
+    if (image->kind != SAVE_WRITE_JOURNAL)
+    {
+        bool replacesJournal = image->kind == SAVE_WRITE_BASE || strcmp(image->filename, writer->journalTarget) == 0;
+        bool ok = writeSaveImage(image);
+        if (ok)
+            TraceLog(LOG_INFO, "Game state saved to %s (%.2f ms to capture)", image->filename, image->captureSeconds * 1000);
+        if (replacesJournal)
+        {
+            snprintf(writer->journalTarget, sizeof(writer->journalTarget), "%s",
+                     ok && image->kind == SAVE_WRITE_BASE ? image->filename : "");
+            writer->journalBytes = 0;
+        }
+        return image->kind == SAVE_WRITE_BASE ? ok : !replacesJournal;
+    }
+
+    if (strcmp(image->filename, writer->journalTarget) != 0 || !appendSaveJournal(image))
+    {
+        writer->journalTarget[0] = '\0';
+        return false;
+    }
+    TraceLog(LOG_DEBUG, "Game state journaled to %s (%zu bytes, %.2f ms to capture)", image->filename, image->size,
+             image->captureSeconds * 1000);
+    writer->journalBytes += image->size;
+    if (writer->journalBytes <= SAVE_JOURNAL_LIMIT)
+        return true;
+
+    if (!compactSave(image->filename))
+    {
+        writer->journalTarget[0] = '\0';
+        return false;
+    }
+    TraceLog(LOG_INFO, "Compacted %zu bytes of journal into %s", writer->journalBytes, image->filename);
+    writer->journalBytes = 0;
+    return true;
+}
+
+static void *saveWriterThread(void *arg)
+{
+    savewriter_t *writer = arg;
+    pthread_mutex_lock(&writer->lock);
+    for (;;)
+    {
+        int next = -1;
+        for (int i = 0; i < 2; i++)
+        {
+            if (writer->states[i] == SAVE_IMAGE_PENDING && (next < 0 || writer->submitted[i] < writer->submitted[next]))
+                next = i;
+        }
+        if (next < 0)
+        {
+            // Pending saves are finished before stopping, so quitting straight after a save still keeps it
+            if (writer->stopping)
+                break;
+            pthread_cond_wait(&writer->wake, &writer->lock);
+            continue;
+        }
+
+        writer->states[next] = SAVE_IMAGE_WRITING;
+        saveimage_t *image = &writer->images[next];
+        pthread_mutex_unlock(&writer->lock);
+        bool journalKept = writeQueuedSave(writer, image);
+        pthread_mutex_lock(&writer->lock);
+        writer->states[next] = SAVE_IMAGE_FREE;
+        writer->needsBase |= !journalKept;
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+savewriter_t *createSaveWriter(void)
+{
+    savewriter_t *writer = calloc(1, sizeof(savewriter_t));
+    if (!writer)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate savewriter_t");
+        return NULL;
+    }
+    writer->needsBase = true;
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    if (pthread_create(&writer->thread, NULL, saveWriterThread, writer) != 0)
+    {
+        TraceLog(LOG_ERROR, "Failed to start save writer thread");
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->wake);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+saveimage_t *acquireSaveImage(savewriter_t *writer)
+{
+    // Returns an image to capture into, or NULL while both are still waiting to be written
+    saveimage_t *image = NULL;
+    pthread_mutex_lock(&writer->lock);
+    for (int i = 0; i < 2 && !image; i++)
+    {
+        if (writer->states[i] == SAVE_IMAGE_FREE)
+        {
+            writer->states[i] = SAVE_IMAGE_CAPTURING;
+            image = &writer->images[i];
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return image;
+}
+
+void submitSaveImage(savewriter_t *writer, saveimage_t *image)
+{
+    // An empty image is a capture that failed, handed back unwritten - a base that failed is asked for again
+    int i = image - writer->images;
+    pthread_mutex_lock(&writer->lock);
+    writer->states[i] = image->size > 0 ? SAVE_IMAGE_PENDING : SAVE_IMAGE_FREE;
+    writer->submitted[i] = writer->submissions++;
+    writer->needsBase |= image->size == 0 && image->kind == SAVE_WRITE_BASE;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+bool takeSaveBaseRequest(savewriter_t *writer)
+{
+    // True when the next journaled save has to be a base, which clears the request
+    pthread_mutex_lock(&writer->lock);
+    bool needsBase = writer->needsBase;
+    writer->needsBase = false;
+    pthread_mutex_unlock(&writer->lock);
+    return needsBase;
+}
+
+void freeSaveWriter(savewriter_t *writer)
+{
+    if (!writer)
+        return;
+    pthread_mutex_lock(&writer->lock);
+    writer->stopping = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    for (int i = 0; i < 2; i++)
+    {
+        free(writer->images[i].data);
+    }
+    free(writer);
+}
@@ -44,14 +44,6 @@ ship_t **initShips(int *numShips)
         exit(0);
     }
     ships[0]->futurePositions = malloc(sizeof(Vector2) * ships[0]->trajectorySize);
-    ships[0]->baseTexture = LoadTextureById(ships[0]->baseTextureId);
-    ships[0]->engineTexture = LoadTextureById(ships[0]->engineTextureId);
-    ships[0]->thrusterUpTexture = LoadTextureById(ships[0]->thrusterUpTextureId);
-    ships[0]->thrusterDownTexture = LoadTextureById(ships[0]->thrusterDownTextureId);
-    ships[0]->thrusterRightTexture = LoadTextureById(ships[0]->thrusterRightTextureId);
-    ships[0]->thrusterLeftTexture = LoadTextureById(ships[0]->thrusterLeftTextureId);
-    ships[0]->thrusterRotateRightTexture = LoadTextureById(ships[0]->thrusterRotateRightTextureId);
-    ships[0]->thrusterRotateLeftTexture = LoadTextureById(ships[0]->thrusterRotateLeftTextureId);
 
     ships[1] = malloc(sizeof(ship_t));
     *ships[1] = (ship_t){
@@ -70,6 +62,7 @@ ship_t **initShips(int *numShips)
         .drawTrajectory = true,
         .textureScale = 3,
         .baseTextureId = 8,
+        .engineTextureId = TEXTURE_NONE,
         .thrusterUpTextureId = 9,
         .thrusterDownTextureId = 10,
         .thrusterRightTextureId = 11,
@@ -90,137 +83,15 @@ ship_t **initShips(int *numShips)
         exit(0);
     }
     ships[1]->futurePositions = malloc(sizeof(Vector2) * ships[1]->trajectorySize);
-    ships[1]->baseTexture = LoadTextureById(ships[1]->baseTextureId);
-    ships[1]->thrusterUpTexture = LoadTextureById(ships[1]->thrusterUpTextureId);
-    ships[1]->thrusterDownTexture = LoadTextureById(ships[1]->thrusterDownTextureId);
-    ships[1]->thrusterRightTexture = LoadTextureById(ships[1]->thrusterRightTextureId);
-    ships[1]->thrusterLeftTexture = LoadTextureById(ships[1]->thrusterLeftTextureId);
-    ships[1]->thrusterRotateRightTexture = LoadTextureById(ships[1]->thrusterRotateRightTextureId);
-    ships[1]->thrusterRotateLeftTexture = LoadTextureById(ships[1]->thrusterRotateLeftTextureId);
 
     return ships;
 }
 
-bool saveShip(ship_t *ship, FILE *file, gamestate_t *state) {
-    // Serialises all ship attributes that cannot be re-computed
-    fwrite(&ship->position, sizeof(Vector2), 1, file);
-    fwrite(&ship->velocity, sizeof(Vector2), 1, file);
-    fwrite(&ship->mass, sizeof(float), 1, file);
-    fwrite(&ship->rotation, sizeof(float), 1, file);
-    fwrite(&ship->rotationSpeed, sizeof(float), 1, file);
-    fwrite(&ship->radius, sizeof(float), 1, file);
-    fwrite(&ship->thrust, sizeof(float), 1, file);
-    fwrite(&ship->thrusterForce, sizeof(float), 1, file);
-    fwrite(&ship->fuel, sizeof(float), 1, file);
-    fwrite(&ship->fuelConsumption, sizeof(float), 1, file);
-    fwrite(&ship->state, sizeof(ShipState), 1, file);
-    fwrite(&ship->type, sizeof(ShipType), 1, file);
-    int landedIndex = getBodyIndex(ship->landedBody, state->bodies, state->numBodies);
-    fwrite(&landedIndex, sizeof(int), 1, file);
-    fwrite(&ship->landingPosition, sizeof(Vector2), 1, file);
-    fwrite(&ship->trajectorySize, sizeof(int), 1, file);
-    fwrite(&ship->baseTextureId, sizeof(int), 1, file);
-    fwrite(&ship->engineTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterUpTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterDownTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterRightTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterLeftTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterRotateRightTextureId, sizeof(int), 1, file);
-    fwrite(&ship->thrusterRotateLeftTextureId, sizeof(int), 1, file);
-    fwrite(&ship->textureScale, sizeof(float), 1, file);
-
-    if (ferror(file)) {
-        TraceLog(LOG_ERROR, "Write error in saveShip");
-        return false;
-    }
-    return true;
-}
-
-ship_t* loadShip(FILE *file, gamestate_t* state) {
-    ship_t* ship = malloc(sizeof(ship_t));
-    if (!ship) {
-        TraceLog(LOG_ERROR, "Failed to allocate ship_t");
-        return NULL;
-    }
-
-    ship->futurePositions = NULL;
-    ship->landedBody = NULL;
-    int landedIndex = -1;
-
-    if (fread(&ship->position, sizeof(Vector2), 1, file) != 1 
-        || fread(&ship->velocity, sizeof(Vector2), 1, file) != 1 
-        || fread(&ship->mass, sizeof(float), 1, file) != 1
-        || fread(&ship->rotation, sizeof(float), 1, file) != 1
-        || fread(&ship->rotationSpeed, sizeof(float), 1, file) != 1
-        || fread(&ship->radius, sizeof(float), 1, file) != 1
-        || fread(&ship->thrust, sizeof(float), 1, file) != 1
-        || fread(&ship->thrusterForce, sizeof(float), 1, file) != 1
-        || fread(&ship->fuel, sizeof(float), 1, file) != 1
-        || fread(&ship->fuelConsumption, sizeof(float), 1, file) != 1
-        || fread(&ship->state, sizeof(ShipState), 1, file) != 1
-        || fread(&ship->type, sizeof(ShipType), 1, file) != 1
-        || fread(&landedIndex, sizeof(int), 1, file) != 1
-        || fread(&ship->landingPosition, sizeof(Vector2), 1, file) != 1
-        || fread(&ship->trajectorySize, sizeof(int), 1, file) != 1
-        || fread(&ship->baseTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->engineTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterUpTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterDownTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterRightTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterLeftTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterRotateRightTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->thrusterRotateLeftTextureId, sizeof(int), 1, file) != 1
-        || fread(&ship->textureScale, sizeof(float), 1, file) != 1)
-        {
-        TraceLog(LOG_ERROR, "Failed to read ship fields");
-        goto error;
-    }
-
-    ship->landedBody = getBodyPtr(landedIndex, state->bodies, state->numBodies);
-
-    // Load textures
-    ship->baseTexture = LoadTextureById(ship->baseTextureId);
-    ship->thrusterUpTexture = LoadTextureById(ship->thrusterUpTextureId);
-    ship->thrusterDownTexture = LoadTextureById(ship->thrusterDownTextureId);
-    ship->thrusterRightTexture = LoadTextureById(ship->thrusterRightTextureId);
-    ship->thrusterLeftTexture = LoadTextureById(ship->thrusterLeftTextureId);
-    ship->thrusterRotateRightTexture = LoadTextureById(ship->thrusterRotateRightTextureId);
-    ship->thrusterRotateLeftTexture = LoadTextureById(ship->thrusterRotateLeftTextureId);
-
-    // Initialise remaining attributes
-    ship->isSelected = false;
-    ship->drawTrajectory = true;
-    ship->mainEnginesOn = false;
-    ship->thrusterUp = false;
-    ship->thrusterDown = false;
-    ship->thrusterRight = false;
-    ship->thrusterLeft = false;
-    ship->thrusterRotateRight = false;
-    ship->thrusterRotateLeft = false;
-
-    return ship;
-
-    error:
-        freeShip(ship);
-        return NULL;
-}
-
 void freeShip(ship_t* ship) {
     if (ship->futurePositions)
     {
         free(ship->futurePositions);
     }
-    UnloadTexture(ship->baseTexture);
-    if (ship->type != SHIP_STATION)
-    {
-        UnloadTexture(ship->engineTexture);
-    }
-    UnloadTexture(ship->thrusterUpTexture);
-    UnloadTexture(ship->thrusterDownTexture);
-    UnloadTexture(ship->thrusterRightTexture);
-    UnloadTexture(ship->thrusterLeftTexture);
-    UnloadTexture(ship->thrusterRotateRightTexture);
-    UnloadTexture(ship->thrusterRotateLeftTexture);
     free(ship);
 }
 
@@ -237,6 +108,14 @@ void freeShips(ship_t **ships, int numShips)
 }
 
 
+void markShipDirty(gamestate_t *state, int index)
+{
+    // Anything that changes a ship's saved record calls this, so the next autosave journals it
+    if (index < 0 || index >= state->numShips || !state->dirtyShips)
+        return;
+    state->dirtyShips[index / 64] |= 1ull << (index % 64);
+}
+
 void takeoffShip(ship_t *ship)
 {
     if (ship->state != SHIP_LANDED || ship->landedBody == NULL)
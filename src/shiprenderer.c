@@ -0,0 +1,244 @@
+#include "shiprenderer.h"
+
+/*
+    Instance layout - raylib uploads each Matrix as m0, m1, m2 ... m15, so the shader sees column k as m[4k..4k+3]
+        instanceTransform[0] = position x, position y, rotation in radians, scale
+        instanceTransform[1] = base sprite id, active layer mask, layer ids 0-1
+        instanceTransform[2] = layer ids 2-5
+        instanceTransform[3] = layer id 6, unused
+    Ids travel as floats, which hold small integers exactly
+*/
+
+#define SHIP_STRINGIFY(x) #x
+#define SHIP_SHADER_SLOTS(x) "#define MAX_SPRITES " SHIP_STRINGIFY(x) "\n"
+
+static const char *shipVertexShader =
+    "#version 330\n"
+    SHIP_SHADER_SLOTS(SHIP_SPRITE_SLOTS)
+    "in vec3 vertexPosition;\n"
+    "in vec2 vertexTexCoord;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec4 regions[MAX_SPRITES];\n"
+    "out vec2 fragLocal;\n"
+    "flat out float fragBase;\n"
+    "flat out int fragMask;\n"
+    "flat out vec4 fragLayersA;\n"
+    "flat out vec3 fragLayersB;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 pose = instanceTransform[0];\n"
+    "    vec4 ids = instanceTransform[1];\n"
+    "    vec2 local = vertexPosition.xy * regions[int(ids.x)].zw * pose.w;\n"
+    "    float c = cos(pose.z);\n"
+    "    float s = sin(pose.z);\n"
+    "    vec2 world = pose.xy + vec2(local.x * c - local.y * s, local.x * s + local.y * c);\n"
+    "    fragLocal = vertexTexCoord;\n"
+    "    fragBase = ids.x;\n"
+    "    fragMask = int(ids.y);\n"
+    "    fragLayersA = vec4(ids.zw, instanceTransform[2].xy);\n"
+    "    fragLayersB = vec3(instanceTransform[2].zw, instanceTransform[3].x);\n"
+    "    gl_Position = mvp * vec4(world, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *shipFragmentShader =
+    "#version 330\n"
+    SHIP_SHADER_SLOTS(SHIP_SPRITE_SLOTS)
+    "in vec2 fragLocal;\n"
+    "flat in float fragBase;\n"
+    "flat in int fragMask;\n"
+    "flat in vec4 fragLayersA;\n"
+    "flat in vec3 fragLayersB;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "uniform vec4 regions[MAX_SPRITES];\n"
+    "uniform vec2 atlasSize;\n"
+    "out vec4 finalColor;\n"
+    "vec4 sampleSprite(float id)\n"
+    "{\n"
+    "    vec4 region = regions[int(id)];\n"
+    "    return texture(texture0, (region.xy + fragLocal * region.zw) / atlasSize);\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    float layers[7] = float[7](fragLayersA.x, fragLayersA.y, fragLayersA.z, fragLayersA.w, fragLayersB.x, fragLayersB.y, fragLayersB.z);\n"
+    "    vec4 base = sampleSprite(fragBase);\n"
+    "    vec3 colour = base.rgb * base.a;\n"
+    "    float alpha = base.a;\n"
+    "    for (int k = 0; k < 7; k++)\n"
+    "    {\n"
+    "        if ((fragMask & (1 << k)) != 0)\n"
+    "        {\n"
+    "            vec4 layer = sampleSprite(layers[k]);\n"
+    "            colour = layer.rgb * layer.a + colour * (1.0 - layer.a);\n"
+    "            alpha = layer.a + alpha * (1.0 - layer.a);\n"
+    "        }\n"
+    "    }\n"
+    "    if (alpha <= 0.0) discard;\n"
+    "    finalColor = vec4(colour / alpha, alpha) * colDiffuse;\n"
+    "}\n";
+
+static Mesh createShipQuad(void)
+{
+    // Unit quad centred on the origin, wound like raylib's own 2D quads - top left, bottom left, bottom right, top right
+    static const float vertices[] = {-0.5f, -0.5f, 0.0f, -0.5f, 0.5f, 0.0f, 0.5f, 0.5f, 0.0f, 0.5f, -0.5f, 0.0f};
+    static const float texcoords[] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f};
+    static const unsigned short indices[] = {0, 1, 2, 0, 2, 3};
+
+    Mesh mesh = {0};
+    mesh.vertexCount = 4;
+    mesh.triangleCount = 2;
+    mesh.vertices = MemAlloc(sizeof(vertices));
+    mesh.texcoords = MemAlloc(sizeof(texcoords));
+    mesh.indices = MemAlloc(sizeof(indices));
+    memcpy(mesh.vertices, vertices, sizeof(vertices));
+    memcpy(mesh.texcoords, texcoords, sizeof(texcoords));
+    memcpy(mesh.indices, indices, sizeof(indices));
+    UploadMesh(&mesh, false);
+    return mesh;
+}
+
+shiprenderer_t *createShipRenderer(void)
+{
+    // GPU objects are created on first replay, so ships can be recorded without a window
+    shiprenderer_t *renderer = malloc(sizeof(shiprenderer_t));
+    if (!renderer)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate shiprenderer_t");
+        return NULL;
+    }
+    renderer->loaded = false;
+    return renderer;
+}
+
+static void loadShipRenderer(shiprenderer_t *renderer)
+{
+    // Region uniforms are read from the sprite atlas, so it must already be loaded
+    renderer->shader = LoadShaderFromMemory(shipVertexShader, shipFragmentShader);
+
+    Vector4 regions[SHIP_SPRITE_SLOTS];
+    for (int i = 0; i < SHIP_SPRITE_SLOTS; i++)
+    {
+        Rectangle region = getSpriteRegion(i);
+        regions[i] = (Vector4){region.x, region.y, region.width, region.height};
+    }
+    Texture2D atlas = getSpriteAtlasTexture();
+    Vector2 atlasSize = {(float)atlas.width, (float)atlas.height};
+    SetShaderValueV(renderer->shader, GetShaderLocation(renderer->shader, "regions"), regions, SHADER_UNIFORM_VEC4, SHIP_SPRITE_SLOTS);
+    SetShaderValue(renderer->shader, GetShaderLocation(renderer->shader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
+
+    renderer->material = LoadMaterialDefault();
+    renderer->material.shader = renderer->shader;
+    renderer->defaultTexture = renderer->material.maps[MATERIAL_MAP_DIFFUSE].texture;
+    renderer->quad = createShipQuad();
+    renderer->loaded = true;
+}
+
+void freeShipRenderer(shiprenderer_t *renderer)
+{
+    if (!renderer)
+        return;
+    if (renderer->loaded)
+    {
+        // UnloadMaterial frees every map texture it does not recognise as raylib's default, the atlas included
+        renderer->material.maps[MATERIAL_MAP_DIFFUSE].texture = renderer->defaultTexture;
+        // Also unloads the custom shader
+        UnloadMaterial(renderer->material);
+        UnloadMesh(renderer->quad);
+    }
+    free(renderer);
+}
+
+static float spriteSlot(int id)
+{
+    // Ids the shader cannot address draw as the logo, like getSpriteRegion does for unknown ids
+    return (float)(id >= 0 && id < SHIP_SPRITE_SLOTS ? id : TEXTURE_SHIP_LOGO);
+}
+
+static Matrix shipInstance(ship_t *ship)
+{
+    struct
+    {
+        bool active;
+        int textureId;
+    } layers[SHIP_LAYER_COUNT] = {
+        [SHIP_LAYER_ENGINE] = {ship->mainEnginesOn, ship->engineTextureId},
+        [SHIP_LAYER_THRUSTER_UP] = {ship->thrusterUp, ship->thrusterUpTextureId},
+        [SHIP_LAYER_THRUSTER_DOWN] = {ship->thrusterDown, ship->thrusterDownTextureId},
+        [SHIP_LAYER_THRUSTER_RIGHT] = {ship->thrusterRight, ship->thrusterRightTextureId},
+        [SHIP_LAYER_THRUSTER_LEFT] = {ship->thrusterLeft, ship->thrusterLeftTextureId},
+        [SHIP_LAYER_ROTATE_RIGHT] = {ship->thrusterRotateRight, ship->thrusterRotateRightTextureId},
+        [SHIP_LAYER_ROTATE_LEFT] = {ship->thrusterRotateLeft, ship->thrusterRotateLeftTextureId}};
+
+    int mask = 0;
+    float ids[SHIP_LAYER_COUNT];
+    for (int l = 0; l < SHIP_LAYER_COUNT; l++)
+    {
+        if (layers[l].active && layers[l].textureId != TEXTURE_NONE)
+        {
+            mask |= 1 << l;
+        }
+        ids[l] = spriteSlot(layers[l].textureId);
+    }
+
+    return (Matrix){
+        .m0 = ship->position.x, .m1 = ship->position.y, .m2 = ship->rotation * DEG2RAD, .m3 = ship->textureScale,
+        .m4 = spriteSlot(ship->baseTextureId), .m5 = (float)mask, .m6 = ids[0], .m7 = ids[1],
+        .m8 = ids[2], .m9 = ids[3], .m10 = ids[4], .m11 = ids[5],
+        .m12 = ids[6]};
+}
+
+static Matrix shipIconInstance(ship_t *ship, float iconScale)
+{
+    return (Matrix){
+        .m0 = ship->position.x, .m1 = ship->position.y, .m2 = ship->rotation * DEG2RAD, .m3 = iconScale,
+        .m4 = TEXTURE_SHIP_LOGO};
+}
+
+void drawShips(drawlist_t *list, shiprenderer_t *renderer, ship_t **ships, int numShips, Camera2D *camera, renderview_t *view, float iconZoom)
+{
+    // Zoomed far enough out the sprites are a few pixels wide, so draw the logo instead - as zoom gets smaller, it gets bigger
+    bool icons = camera->zoom <= iconZoom;
+    float iconScale = (1 / camera->zoom) + 8;
+
+    int first;
+    Matrix *instances = pushDrawInstances(list, view->visible.count, &first);
+    if (!instances)
+        return;
+
+    // Visible entries are sorted by index, so instances keep the original draw order
+    int count = 0;
+    for (int v = 0; v < view->visible.count; v++)
+    {
+        spatialentry_t *entry = view->visible.results[v];
+        if (entry->type != SPATIAL_SHIP || entry->index >= numShips)
+            continue;
+        ship_t *ship = ships[entry->index];
+        instances[count++] = icons ? shipIconInstance(ship, iconScale) : shipInstance(ship);
+    }
+    // Hand back the slots reserved for bodies
+    list->numInstances = first + count;
+    if (count == 0)
+        return;
+
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_SHIPS);
+    if (command)
+    {
+        command->ships.renderer = renderer;
+        command->ships.first = first;
+        command->ships.count = count;
+    }
+}
+
+void replayShips(shiprenderer_t *renderer, const Matrix *instances, int count)
+{
+    if (!renderer->loaded)
+    {
+        loadShipRenderer(renderer);
+    }
+    renderer->material.maps[MATERIAL_MAP_DIFFUSE].texture = getSpriteAtlasTexture();
+    // Switching shader flushes the pending 2D batch, so bodies stay underneath the ships
+    BeginShaderMode(renderer->shader);
+    DrawMeshInstanced(renderer->quad, renderer->material, instances, count);
+    EndShaderMode();
+}
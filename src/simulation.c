@@ -0,0 +1,538 @@
+#include <time.h>
+#include "simulation.h"
+#include "physics.h"
+#include "fmm.h"
+#include "save.h"
+#include "ui.h"
+
+double getSimClock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool allocSnapshot(simsnapshot_t *snapshot, gamestate_t *state)
+{
+    int trajectoryPoints = 0;
+    for (int i = 0; i < state->numShips; i++)
+    {
+        trajectoryPoints += state->ships[i]->trajectorySize;
+    }
+
+    *snapshot = (simsnapshot_t){0};
+    snapshot->numBodies = state->numBodies;
+    snapshot->numShips = state->numShips;
+    snapshot->bodies = malloc(sizeof(celestialbody_t) * state->numBodies);
+    snapshot->previousBodyPositions = malloc(sizeof(Vector2) * state->numBodies);
+    snapshot->ships = malloc(sizeof(ship_t) * state->numShips);
+    snapshot->previousShipPositions = malloc(sizeof(Vector2) * state->numShips);
+    snapshot->previousShipRotations = malloc(sizeof(float) * state->numShips);
+    snapshot->landedIndices = malloc(sizeof(int) * state->numShips);
+    snapshot->trajectories = malloc(sizeof(Vector2) * trajectoryPoints);
+    snapshot->trajectoryRevisions = malloc(sizeof(unsigned int) * state->numShips);
+    if (!snapshot->bodies || !snapshot->previousBodyPositions || !snapshot->ships ||
+        !snapshot->previousShipPositions || !snapshot->previousShipRotations || !snapshot->landedIndices ||
+        (!snapshot->trajectories && trajectoryPoints > 0) || !snapshot->trajectoryRevisions)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate simulation snapshot");
+        return false;
+    }
+
+    // Force the first publish to copy every trajectory
+    for (int i = 0; i < state->numShips; i++)
+    {
+        snapshot->trajectoryRevisions[i] = state->ships[i]->trajectoryRevision - 1;
+    }
+    return true;
+}
+
+static void freeSnapshot(simsnapshot_t *snapshot)
+{
+    free(snapshot->bodies);
+    free(snapshot->previousBodyPositions);
+    free(snapshot->ships);
+    free(snapshot->previousShipPositions);
+    free(snapshot->previousShipRotations);
+    free(snapshot->landedIndices);
+    free(snapshot->trajectories);
+    free(snapshot->trajectoryRevisions);
+}
+
+static void capturePreviousPoses(simulation_t *sim)
+{
+    gamestate_t *state = sim->state;
+    for (int i = 0; i < state->numBodies; i++)
+    {
+        sim->previousBodyPositions[i] = state->bodies[i]->position;
+    }
+    for (int i = 0; i < state->numShips; i++)
+    {
+        sim->previousShipPositions[i] = state->ships[i]->position;
+        sim->previousShipRotations[i] = state->ships[i]->rotation;
+    }
+}
+
+static void publishSnapshot(simulation_t *sim, float tickSeconds)
+{
+    gamestate_t *state = sim->state;
+    simsnapshot_t *snapshot = &sim->snapshots[sim->writeSnapshot];
+
+    snapshot->tick = sim->tick;
+    snapshot->tickSeconds = tickSeconds;
+    snapshot->gameTime = state->gameTime;
+    snapshot->timeScale = sim->timeScale.val;
+    snapshot->paused = sim->paused;
+    snapshot->mutualGravity = sim->mutualGravity;
+    snapshot->velocityTarget = getBodyIndex(sim->velocityTarget, state->bodies, state->numBodies);
+    snapshot->velocityAuto = sim->velocityLock == VELOCITY_LOCK_AUTO;
+    snapshot->relativeSpeed = sim->relativeSpeed;
+    snapshot->workSeconds = sim->workSeconds;
+    snapshot->predictSeconds = sim->predictSeconds;
+    snapshot->gravitySeconds = sim->gravitySeconds;
+
+    for (int i = 0; i < state->numBodies; i++)
+    {
+        snapshot->bodies[i] = *state->bodies[i];
+        snapshot->previousBodyPositions[i] = sim->previousBodyPositions[i];
+    }
+
+    Vector2 *trajectory = snapshot->trajectories;
+    for (int i = 0; i < state->numShips; i++)
+    {
+        ship_t *ship = state->ships[i];
+        // Each slot keeps its own copy of the path, refreshed only when the prediction has changed since
+        if (ship->futurePositions != NULL && snapshot->trajectoryRevisions[i] != ship->trajectoryRevision)
+        {
+            memcpy(trajectory, ship->futurePositions, sizeof(Vector2) * ship->trajectorySize);
+            snapshot->trajectoryRevisions[i] = ship->trajectoryRevision;
+        }
+        snapshot->ships[i] = *ship;
+        snapshot->ships[i].futurePositions = ship->futurePositions != NULL ? trajectory : NULL;
+        snapshot->previousShipPositions[i] = sim->previousShipPositions[i];
+        snapshot->previousShipRotations[i] = sim->previousShipRotations[i];
+        snapshot->landedIndices[i] = getBodyIndex(ship->landedBody, state->bodies, state->numBodies);
+        trajectory += ship->trajectorySize;
+    }
+    snapshot->publishTime = getSimClock();
+
+    // Swap the finished slot into the middle and take whichever slot was there to write next
+    int previous = atomic_exchange_explicit(&sim->latestSnapshot, sim->writeSnapshot | SIM_SNAPSHOT_FRESH, memory_order_acq_rel);
+    sim->writeSnapshot = previous & ~SIM_SNAPSHOT_FRESH;
+}
+
+static void queueSave(simulation_t *sim, const char *filename, bool journaled)
+{
+    // Only the copy happens here, between ticks so the state is consistent - the writer thread does the file work.
+    // Journaled saves copy just what changed, unless the writer has no base for them to follow
+    saveimage_t *image = acquireSaveImage(sim->saveWriter);
+    if (!image)
+    {
+        TraceLog(LOG_WARNING, "Earlier saves are still writing, skipping save to %s", filename);
+        return;
+    }
+    double start = getSimClock();
+    image->kind = SAVE_WRITE_FULL;
+    if (journaled)
+        image->kind = takeSaveBaseRequest(sim->saveWriter) ? SAVE_WRITE_BASE : SAVE_WRITE_JOURNAL;
+    if (image->kind == SAVE_WRITE_JOURNAL && !captureSaveJournal(sim->state, &sim->saveJournal, filename, image))
+        image->kind = SAVE_WRITE_BASE;
+    if (image->kind != SAVE_WRITE_JOURNAL && captureSave(sim->state, filename, image) && image->kind == SAVE_WRITE_BASE)
+        resetSaveJournal(sim->state, &sim->saveJournal);
+    image->captureSeconds = getSimClock() - start;
+    submitSaveImage(sim->saveWriter, image);
+}
+
+static ship_t *getSelectedShip(gamestate_t *state)
+{
+    // The ship the HUD reports on - the first ship until one is picked
+    for (int i = 0; i < state->numShips; i++)
+    {
+        if (state->ships[i]->isSelected)
+            return state->ships[i];
+    }
+    return state->numShips > 0 ? state->ships[0] : NULL;
+}
+
+static void cycleVelocityLock(simulation_t *sim)
+{
+    // Steps auto -> nearest body -> next nearest ... -> auto, re-ranked from where the selected ship is now
+    ship_t *ship = getSelectedShip(sim->state);
+    celestialbody_t *nearest[VELOCITY_CYCLE_BODIES];
+    float distances[VELOCITY_CYCLE_BODIES];
+    int count = ship ? findNearestBodies(sim->bodyTree, ship->position, VELOCITY_CYCLE_BODIES, nearest, distances) : 0;
+    int next = 0;
+    if (sim->velocityLock != VELOCITY_LOCK_AUTO)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (nearest[i] == sim->velocityTarget)
+                next = i + 1;
+        }
+    }
+    if (next >= count)
+    {
+        sim->velocityLock = VELOCITY_LOCK_AUTO;
+        return;
+    }
+    sim->velocityTarget = nearest[next];
+    sim->velocityLock = getBodyIndex(nearest[next], sim->state->bodies, sim->state->numBodies);
+}
+
+static void processSimCommands(simulation_t *sim)
+{
+    gamestate_t *state = sim->state;
+    unsigned int tail = atomic_load_explicit(&sim->commandTail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&sim->commandHead, memory_order_acquire);
+    while (tail != head)
+    {
+        simcommand_t command = sim->commands[tail % SIM_COMMAND_CAPACITY];
+        switch (command.type)
+        {
+        case SIM_COMMAND_PAUSE:
+            sim->paused = true;
+            break;
+        case SIM_COMMAND_RESUME:
+            sim->paused = false;
+            break;
+        case SIM_COMMAND_SAVE:
+            queueSave(sim, SAVE_PATH, false);
+            break;
+        case SIM_COMMAND_TOGGLE_TRAJECTORY:
+            toggleDrawTrajectory(state->ships, state->numShips);
+            for (int i = 0; i < state->numShips; i++)
+            {
+                if (state->ships[i]->isSelected)
+                    markShipDirty(state, i);
+            }
+            break;
+        case SIM_COMMAND_TOGGLE_MUTUAL_GRAVITY:
+            sim->mutualGravity = !sim->mutualGravity;
+            break;
+        case SIM_COMMAND_SELECT_SHIP:
+            for (int i = 0; i < state->numShips; i++)
+            {
+                if (state->ships[i]->isSelected != (i == command.value))
+                    markShipDirty(state, i);
+                state->ships[i]->isSelected = i == command.value;
+            }
+            break;
+        case SIM_COMMAND_CYCLE_VELOCITY_LOCK:
+            cycleVelocityLock(sim);
+            break;
+        case SIM_COMMAND_VELOCITY_LOCK:
+            sim->velocityLock = command.value;
+            if (command.value != VELOCITY_LOCK_AUTO)
+            {
+                sim->velocityTarget = getBodyPtr(command.value, state->bodies, state->numBodies);
+            }
+            break;
+        case SIM_COMMAND_TRAJECTORY_QUALITY:
+            applyQualityLevel(&sim->quality, QUALITY_KNOB_TRAJECTORY, command.value);
+            break;
+        case SIM_COMMAND_GRAVITY_QUALITY:
+        {
+            applyQualityLevel(&sim->quality, QUALITY_KNOB_GRAVITY, command.value);
+            // The expansion order is baked into the solver's tables, so a new order needs a new solver
+            int order = fmmOrderForTolerance(sim->quality.gravityTolerance);
+            if (sim->fmmSolver == NULL || sim->fmmSolver->order != order)
+            {
+                freeFmmSolver(sim->fmmSolver);
+                sim->fmmSolver = createFmmSolver(order);
+            }
+            break;
+        }
+        }
+        tail++;
+    }
+    atomic_store_explicit(&sim->commandTail, tail, memory_order_release);
+}
+
+static void markMovingShipsDirty(gamestate_t *state)
+{
+    // Flying ships move every tick, while landed ones only follow their body, which loading puts back from the game time
+    for (int i = 0; i < state->numShips; i++)
+    {
+        if (state->ships[i]->state != SHIP_LANDED)
+            markShipDirty(state, i);
+    }
+}
+
+static void stepSimulation(simulation_t *sim, float dt)
+{
+    gamestate_t *state = sim->state;
+    unsigned int input = atomic_load_explicit(&sim->inputMask, memory_order_relaxed);
+
+    if (input & SIM_INPUT_WARP_UP)
+        incrementWarp(&sim->timeScale, dt);
+    if (input & SIM_INPUT_WARP_DOWN)
+        decrementWarp(&sim->timeScale, dt);
+
+    float scaledDt = dt * sim->timeScale.val;
+    state->gameTime += scaledDt;
+
+    // Ship controls only act on the selected ship, and ships flying before the tick may land during it
+    if (input & ~(SIM_INPUT_WARP_UP | SIM_INPUT_WARP_DOWN))
+    {
+        for (int i = 0; i < state->numShips; i++)
+        {
+            if (state->ships[i]->isSelected)
+                markShipDirty(state, i);
+        }
+    }
+    markMovingShipsDirty(state);
+
+    if (input & SIM_INPUT_THROTTLE_UP)
+        handleThrottle(state->ships, state->numShips, scaledDt, THROTTLE_UP);
+    if (input & SIM_INPUT_THROTTLE_DOWN)
+        handleThrottle(state->ships, state->numShips, scaledDt, THROTTLE_DOWN);
+
+    // Sets engine texture and resets thruster flags before input
+    updateShipTextureFlags(state->ships, state->numShips);
+
+    if (input & SIM_INPUT_ROTATE_RIGHT)
+        handleRotation(state->ships, state->numShips, scaledDt, ROTATION_RIGHT);
+    if (input & SIM_INPUT_ROTATE_LEFT)
+        handleRotation(state->ships, state->numShips, scaledDt, ROTATION_LEFT);
+    if (input & SIM_INPUT_THRUSTER_RIGHT)
+        handleThruster(state->ships, state->numShips, scaledDt, THRUSTER_RIGHT);
+    if (input & SIM_INPUT_THRUSTER_LEFT)
+        handleThruster(state->ships, state->numShips, scaledDt, THRUSTER_LEFT);
+    if (input & SIM_INPUT_THRUSTER_UP)
+        handleThruster(state->ships, state->numShips, scaledDt, THRUSTER_UP);
+    if (input & SIM_INPUT_THRUSTER_DOWN)
+        handleThruster(state->ships, state->numShips, scaledDt, THRUSTER_DOWN);
+    if (input & SIM_INPUT_CUT_ENGINES)
+        cutEngines(state->ships, state->numShips);
+
+    updateCelestialPositions(state->bodies, state->numBodies, state->gameTime);
+    double gravityStart = getSimClock();
+    if (sim->mutualGravity)
+    {
+        applyShipMutualGravity(state->ships, state->numShips, sim->fmmSolver, scaledDt);
+    }
+    sim->gravitySeconds = getSimClock() - gravityStart;
+    updateShipPositions(state->ships, state->numShips, state->bodies, state->numBodies, scaledDt);
+
+    updateLandedShipPosition(state->ships, state->numShips, state->bodies, state->numBodies, state->gameTime);
+
+    detectCollisions(state->ships, state->numShips, state->bodies, state->numBodies, state->gameTime);
+    markMovingShipsDirty(state); // Catches ships that took off this tick
+    double predictStart = getSimClock();
+    calculateShipFuturePositions(state->ships, state->numShips, state->bodies, state->numBodies, state->gameTime,
+                                 sim->quality.trajectorySteps, sim->quality.trajectoryStepTime);
+    sim->predictSeconds = getSimClock() - predictStart;
+
+    freeQuadTree(sim->bodyTree);
+    sim->bodyTree = buildQuadTree(state->bodies, state->numBodies);
+
+    ship_t *selected = getSelectedShip(state);
+    if (selected && sim->velocityLock == VELOCITY_LOCK_AUTO)
+    {
+        // Last tick's target is almost always still dominant, so it seeds the search
+        sim->velocityTarget = findDominantBody(sim->bodyTree, selected->position, sim->velocityTarget);
+    }
+    sim->relativeSpeed = selected ? calculateRelativeSpeed(selected, sim->velocityTarget, state->bodies, state->numBodies,
+                                                           state->gameTime)
+                                  : 0.0f;
+}
+
+static void *simulationThread(void *arg)
+{
+    simulation_t *sim = arg;
+    double tickPeriod = 1.0 / SIM_TICK_RATE;
+    double lastTick = getSimClock();
+
+    while (atomic_load_explicit(&sim->running, memory_order_acquire))
+    {
+        double start = getSimClock();
+        float dt = fminf(start - lastTick, SIM_MAX_TICK_SECONDS);
+        lastTick = start;
+
+        processSimCommands(sim);
+        capturePreviousPoses(sim);
+        if (!sim->paused)
+        {
+            stepSimulation(sim, dt);
+            sim->tick++;
+            if (start >= sim->nextAutosave)
+            {
+                queueSave(sim, AUTOSAVE_PATH, true);
+                sim->nextAutosave = start + AUTOSAVE_INTERVAL;
+            }
+        }
+        sim->workSeconds = getSimClock() - start;
+        publishSnapshot(sim, dt);
+
+        // A slow tick runs straight into the next one, a fast one sleeps off the rest of its period
+        double remaining = tickPeriod - (getSimClock() - start);
+        if (remaining > 0)
+        {
+            struct timespec sleep = {.tv_sec = 0, .tv_nsec = (long)(remaining * 1e9)};
+            nanosleep(&sleep, NULL);
+        }
+    }
+    return NULL;
+}
+
+simulation_t *createSimulation(gamestate_t *state, WarpController timeScale)
+{
+    simulation_t *sim = calloc(1, sizeof(simulation_t));
+    if (!sim)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate simulation_t");
+        return NULL;
+    }
+    sim->state = state;
+    sim->timeScale = timeScale;
+    sim->velocityLock = VELOCITY_LOCK_AUTO;
+    sim->quality = getDefaultQualitySettings();
+    sim->fmmSolver = createFmmSolver(fmmOrderForTolerance(sim->quality.gravityTolerance));
+    sim->saveWriter = createSaveWriter();
+    sim->previousBodyPositions = malloc(sizeof(Vector2) * state->numBodies);
+    sim->previousShipPositions = malloc(sizeof(Vector2) * state->numShips);
+    sim->previousShipRotations = malloc(sizeof(float) * state->numShips);
+    bool allocated = sim->previousBodyPositions && sim->previousShipPositions && sim->previousShipRotations &&
+                     sim->saveWriter;
+    for (int i = 0; i < 3 && allocated; i++)
+    {
+        allocated = allocSnapshot(&sim->snapshots[i], state);
+    }
+    if (!allocated)
+    {
+        freeSimulation(sim);
+        return NULL;
+    }
+
+    // Publish the starting state before the thread exists so the renderer always has a snapshot
+    atomic_init(&sim->latestSnapshot, 1);
+    atomic_init(&sim->commandHead, 0);
+    atomic_init(&sim->commandTail, 0);
+    atomic_init(&sim->inputMask, 0);
+    sim->writeSnapshot = 0;
+    sim->readSnapshot = 2;
+    capturePreviousPoses(sim);
+    publishSnapshot(sim, 0.0f);
+    sim->nextAutosave = getSimClock() + AUTOSAVE_INTERVAL;
+
+    atomic_init(&sim->running, true);
+    if (pthread_create(&sim->thread, NULL, simulationThread, sim) != 0)
+    {
+        TraceLog(LOG_ERROR, "Failed to start simulation thread");
+        atomic_store(&sim->running, false);
+        freeSimulation(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void freeSimulation(simulation_t *sim)
+{
+    // Stops the thread - the game state itself stays with the caller
+    if (!sim)
+        return;
+    if (atomic_load(&sim->running))
+    {
+        atomic_store(&sim->running, false);
+        pthread_join(sim->thread, NULL);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        freeSnapshot(&sim->snapshots[i]);
+    }
+    // After the sim thread has stopped, so nothing can submit while the writer drains
+    freeSaveWriter(sim->saveWriter);
+    freeSaveJournal(&sim->saveJournal);
+    freeFmmSolver(sim->fmmSolver);
+    freeQuadTree(sim->bodyTree);
+    free(sim->previousBodyPositions);
+    free(sim->previousShipPositions);
+    free(sim->previousShipRotations);
+    free(sim);
+}
+
+bool sendSimCommand(simulation_t *sim, SimCommandType type, int value)
+{
+    unsigned int head = atomic_load_explicit(&sim->commandHead, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&sim->commandTail, memory_order_acquire);
+    if (head - tail >= SIM_COMMAND_CAPACITY)
+    {
+        TraceLog(LOG_WARNING, "Simulation command queue full, dropping command %i", type);
+        return false;
+    }
+    sim->commands[head % SIM_COMMAND_CAPACITY] = (simcommand_t){type, value};
+    atomic_store_explicit(&sim->commandHead, head + 1, memory_order_release);
+    return true;
+}
+
+void setSimInput(simulation_t *sim, unsigned int inputMask)
+{
+    atomic_store_explicit(&sim->inputMask, inputMask, memory_order_relaxed);
+}
+
+simsnapshot_t *acquireSimSnapshot(simulation_t *sim)
+{
+    // Only swap when something new was published, otherwise keep drawing the slot already held
+    if (atomic_load_explicit(&sim->latestSnapshot, memory_order_relaxed) & SIM_SNAPSHOT_FRESH)
+    {
+        int latest = atomic_exchange_explicit(&sim->latestSnapshot, sim->readSnapshot, memory_order_acq_rel);
+        sim->readSnapshot = latest & ~SIM_SNAPSHOT_FRESH;
+    }
+    return &sim->snapshots[sim->readSnapshot];
+}
+
+static float lerpAngle(float from, float to, float t)
+{
+    // Rotations are in degrees - take the short way round
+    float delta = fmodf(to - from + 540.0f, 360.0f) - 180.0f;
+    return from + delta * t;
+}
+
+void updateSimMirror(simmirror_t *mirror, simsnapshot_t *snapshot, double now)
+{
+    if (mirror->numBodies != snapshot->numBodies || mirror->numShips != snapshot->numShips)
+    {
+        freeSimMirror(mirror);
+        mirror->bodyStore = malloc(sizeof(celestialbody_t) * snapshot->numBodies);
+        mirror->bodies = malloc(sizeof(celestialbody_t *) * snapshot->numBodies);
+        mirror->shipStore = malloc(sizeof(ship_t) * snapshot->numShips);
+        mirror->ships = malloc(sizeof(ship_t *) * snapshot->numShips);
+        if (!mirror->bodyStore || !mirror->bodies || !mirror->shipStore || !mirror->ships)
+        {
+            TraceLog(LOG_ERROR, "Failed to allocate simulation mirror");
+            freeSimMirror(mirror);
+            return;
+        }
+        for (int i = 0; i < snapshot->numBodies; i++)
+            mirror->bodies[i] = &mirror->bodyStore[i];
+        for (int i = 0; i < snapshot->numShips; i++)
+            mirror->ships[i] = &mirror->shipStore[i];
+        mirror->numBodies = snapshot->numBodies;
+        mirror->numShips = snapshot->numShips;
+    }
+
+    // The snapshot holds the start and end of its tick - play that tick back over the following tick's worth of time
+    float t = snapshot->tickSeconds > 0 ? Clamp((now - snapshot->publishTime) / snapshot->tickSeconds, 0.0f, 1.0f) : 1.0f;
+
+    for (int i = 0; i < mirror->numBodies; i++)
+    {
+        mirror->bodyStore[i] = snapshot->bodies[i];
+        mirror->bodyStore[i].position = Vector2Lerp(snapshot->previousBodyPositions[i], snapshot->bodies[i].position, t);
+    }
+    for (int i = 0; i < mirror->numShips; i++)
+    {
+        mirror->shipStore[i] = snapshot->ships[i];
+        mirror->shipStore[i].position = Vector2Lerp(snapshot->previousShipPositions[i], snapshot->ships[i].position, t);
+        mirror->shipStore[i].rotation = lerpAngle(snapshot->previousShipRotations[i], snapshot->ships[i].rotation, t);
+        mirror->shipStore[i].landedBody = getBodyPtr(snapshot->landedIndices[i], mirror->bodies, mirror->numBodies);
+    }
+}
+
+void freeSimMirror(simmirror_t *mirror)
+{
+    free(mirror->bodyStore);
+    free(mirror->bodies);
+    free(mirror->shipStore);
+    free(mirror->ships);
+    *mirror = (simmirror_t){0};
+}
@@ -0,0 +1,405 @@
+#include "spatial.h"
+
+/*
+    Region quadtree over bodies and ships, based on examples/quadtree_example.c
+    Entries live in the deepest node that fully contains them, so large bodies and their atmospheres
+    stay near the root while ships sink to small leaves
+    Nodes come from a pool on the index that each rebuild empties and refills, so after the first few frames
+    a rebuild allocates nothing - nodes refer to their children by index, as the pool moves when it grows
+*/
+
+static int createSpatialNode(spatialindex_t *index, Rectangle bounds, int depth)
+{
+    // Returns the node's index in the pool, or -1 if the pool could not grow
+    if (index->numNodes == index->allocatedNodes)
+    {
+        int newCapacity = index->allocatedNodes > 0 ? index->allocatedNodes * 2 : 64;
+        spatialnode_t *nodes = realloc(index->nodes, sizeof(spatialnode_t) * newCapacity);
+        if (!nodes)
+        {
+            TraceLog(LOG_ERROR, "Failed to grow spatial node pool to %i nodes", newCapacity);
+            return -1;
+        }
+        for (int i = index->allocatedNodes; i < newCapacity; i++)
+        {
+            nodes[i].entries = NULL;
+            nodes[i].entryCapacity = 0;
+        }
+        index->nodes = nodes;
+        index->allocatedNodes = newCapacity;
+    }
+
+    // A node left over from an earlier build keeps its entry buffer
+    spatialnode_t *node = &index->nodes[index->numNodes];
+    node->bounds = bounds;
+    node->entryCount = 0;
+    node->depth = depth;
+    for (int i = 0; i < 4; i++)
+        node->children[i] = -1;
+    return index->numNodes++;
+}
+
+static bool containsRect(Rectangle container, Rectangle contained)
+{
+    return (contained.x >= container.x &&
+            contained.y >= container.y &&
+            contained.x + contained.width <= container.x + container.width &&
+            contained.y + contained.height <= container.y + container.height);
+}
+
+static void appendSpatialEntry(spatialnode_t *node, spatialentry_t *entry)
+{
+    if (node->entryCount == node->entryCapacity)
+    {
+        int newCapacity = node->entryCapacity > 0 ? node->entryCapacity * 2 : 4;
+        spatialentry_t **entries = realloc(node->entries, sizeof(spatialentry_t *) * newCapacity);
+        if (!entries)
+        {
+            TraceLog(LOG_ERROR, "Failed to grow spatial node entries");
+            return;
+        }
+        node->entries = entries;
+        node->entryCapacity = newCapacity;
+    }
+    node->entries[node->entryCount++] = entry;
+}
+
+static bool subdivideSpatialNode(spatialindex_t *index, int parent)
+{
+    // Children are created together, so a failure part way leaves the parent a leaf
+    Rectangle bounds = index->nodes[parent].bounds;
+    int depth = index->nodes[parent].depth + 1;
+    float x = bounds.x;
+    float y = bounds.y;
+    float w = bounds.width / 2;
+    float h = bounds.height / 2;
+    Rectangle quadrants[4] = {
+        {x, y, w, h},         // NW
+        {x + w, y, w, h},     // NE
+        {x, y + h, w, h},     // SW
+        {x + w, y + h, w, h}, // SE
+    };
+    int first = index->numNodes;
+    for (int i = 0; i < 4; i++)
+    {
+        if (createSpatialNode(index, quadrants[i], depth) < 0)
+        {
+            index->numNodes = first;
+            return false;
+        }
+    }
+    for (int i = 0; i < 4; i++)
+        index->nodes[parent].children[i] = first + i;
+    return true;
+}
+
+static int childContaining(spatialindex_t *index, int parent, Rectangle bounds)
+{
+    const spatialnode_t *node = &index->nodes[parent];
+    if (node->children[0] < 0)
+        return -1;
+    for (int i = 0; i < 4; i++)
+    {
+        if (containsRect(index->nodes[node->children[i]].bounds, bounds))
+            return node->children[i];
+    }
+    return -1;
+}
+
+static void insertSpatialEntry(spatialindex_t *index, int n, spatialentry_t *entry)
+{
+    // Nodes are held by index, as inserting below may grow the pool and move them
+    int child = childContaining(index, n, entry->bounds);
+    if (child >= 0)
+    {
+        insertSpatialEntry(index, child, entry);
+        return;
+    }
+
+    spatialnode_t *node = &index->nodes[n];
+    appendSpatialEntry(node, entry);
+
+    if (node->children[0] >= 0 || node->entryCount <= index->nodeCapacity || node->depth >= SPATIAL_MAX_DEPTH)
+        return;
+
+    // Leaf is over capacity - push down everything that fits in a quadrant, or keep it all here if the pool is full
+    if (!subdivideSpatialNode(index, n))
+        return;
+    spatialentry_t **entries = index->nodes[n].entries;
+    int count = index->nodes[n].entryCount;
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        spatialentry_t *existing = entries[i];
+        child = childContaining(index, n, existing->bounds);
+        if (child >= 0)
+        {
+            insertSpatialEntry(index, child, existing);
+        }
+        else
+        {
+            entries[kept++] = existing;
+        }
+    }
+    index->nodes[n].entryCount = kept;
+}
+
+spatialindex_t *createSpatialIndex(int nodeCapacity)
+{
+    spatialindex_t *index = malloc(sizeof(spatialindex_t));
+    if (!index)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate spatialindex_t");
+        return NULL;
+    }
+    index->nodes = NULL;
+    index->numNodes = 0;
+    index->allocatedNodes = 0;
+    index->entries = NULL;
+    index->numEntries = 0;
+    index->maxEntries = 0;
+    index->nodeCapacity = nodeCapacity > 0 ? nodeCapacity : 1;
+    return index;
+}
+
+static spatialentry_t makeSpatialEntry(SpatialEntryType type, int index, Vector2 center, float radius)
+{
+    return (spatialentry_t){
+        .type = type,
+        .index = index,
+        .center = center,
+        .radius = radius,
+        .bounds = (Rectangle){center.x - radius, center.y - radius, radius * 2, radius * 2}};
+}
+
+bool buildSpatialIndex(spatialindex_t *index, celestialbody_t **bodies, int numBodies, ship_t **ships, int numShips)
+{
+    // Bodies and ships move every tick, so the tree is rebuilt rather than updated - returns false when it could not
+    // be built, leaving the index empty
+    index->numNodes = 0;
+    index->numEntries = 0;
+
+    int total = numBodies + numShips;
+    if (total == 0)
+        return true;
+
+    if (total > index->maxEntries)
+    {
+        spatialentry_t *entries = realloc(index->entries, sizeof(spatialentry_t) * total);
+        if (!entries)
+        {
+            TraceLog(LOG_ERROR, "Failed to allocate spatial index entries");
+            return false;
+        }
+        index->entries = entries;
+        index->maxEntries = total;
+    }
+
+    for (int i = 0; i < numBodies; i++)
+    {
+        float radius = fmaxf(bodies[i]->radius, bodies[i]->atmosphereRadius);
+        index->entries[index->numEntries++] = makeSpatialEntry(SPATIAL_BODY, i, bodies[i]->position, radius);
+    }
+    for (int i = 0; i < numShips; i++)
+    {
+        // Cover the whole sprite so culling never clips a visible corner
+        Rectangle sprite = getSpriteRegion(ships[i]->baseTextureId);
+        float spriteRadius = 0.5f * sqrtf(sprite.width * sprite.width + sprite.height * sprite.height);
+        float radius = fmaxf(ships[i]->radius, spriteRadius) * ships[i]->textureScale;
+        index->entries[index->numEntries++] = makeSpatialEntry(SPATIAL_SHIP, i, ships[i]->position, radius);
+    }
+
+    float minX = index->entries[0].bounds.x, maxX = minX + index->entries[0].bounds.width;
+    float minY = index->entries[0].bounds.y, maxY = minY + index->entries[0].bounds.height;
+    for (int i = 1; i < index->numEntries; i++)
+    {
+        Rectangle b = index->entries[i].bounds;
+        minX = fminf(minX, b.x);
+        maxX = fmaxf(maxX, b.x + b.width);
+        minY = fminf(minY, b.y);
+        maxY = fmaxf(maxY, b.y + b.height);
+    }
+    // Square root bounds so quadrants stay square
+    float size = fmaxf(maxX - minX, maxY - minY);
+    if (createSpatialNode(index, (Rectangle){minX, minY, size, size}, 0) < 0)
+    {
+        index->numEntries = 0;
+        return false;
+    }
+
+    for (int i = 0; i < index->numEntries; i++)
+    {
+        insertSpatialEntry(index, 0, &index->entries[i]);
+    }
+    return true;
+}
+
+void freeSpatialIndex(spatialindex_t *index)
+{
+    if (!index)
+        return;
+    for (int i = 0; i < index->allocatedNodes; i++)
+    {
+        free(index->nodes[i].entries);
+    }
+    free(index->nodes);
+    free(index->entries);
+    free(index);
+}
+
+spatialquery_t createSpatialQuery(int capacity)
+{
+    spatialquery_t query = {0};
+    query.results = malloc(sizeof(spatialentry_t *) * capacity);
+    if (!query.results)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate spatial query buffer of %i entries", capacity);
+        return query;
+    }
+    query.capacity = capacity;
+    return query;
+}
+
+void freeSpatialQuery(spatialquery_t *query)
+{
+    free(query->results);
+    query->results = NULL;
+    query->count = 0;
+    query->capacity = 0;
+}
+
+static void pushSpatialResult(spatialquery_t *query, spatialentry_t *entry)
+{
+    if (query->count < query->capacity)
+    {
+        query->results[query->count++] = entry;
+    }
+    else
+    {
+        query->overflowed = true;
+    }
+}
+
+static void queryRectNode(spatialindex_t *index, int n, Rectangle rect, spatialquery_t *query)
+{
+    const spatialnode_t *node = &index->nodes[n];
+    if (!CheckCollisionRecs(node->bounds, rect))
+        return;
+
+    // Whole subtree is inside the query - skip per-entry tests
+    bool inside = containsRect(rect, node->bounds);
+    for (int i = 0; i < node->entryCount; i++)
+    {
+        if (inside || CheckCollisionRecs(node->entries[i]->bounds, rect))
+        {
+            pushSpatialResult(query, node->entries[i]);
+        }
+    }
+
+    if (node->children[0] >= 0)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            queryRectNode(index, node->children[i], rect, query);
+        }
+    }
+}
+
+int querySpatialRect(spatialindex_t *index, Rectangle rect, spatialquery_t *query)
+{
+    query->count = 0;
+    query->overflowed = false;
+    if (index->numNodes > 0)
+    {
+        queryRectNode(index, 0, rect, query);
+    }
+    return query->count;
+}
+
+static void queryPointNode(spatialindex_t *index, int n, Vector2 point, float pickRadius, spatialquery_t *query)
+{
+    const spatialnode_t *node = &index->nodes[n];
+    if (!CheckCollisionCircleRec(point, pickRadius, node->bounds))
+        return;
+
+    for (int i = 0; i < node->entryCount; i++)
+    {
+        spatialentry_t *entry = node->entries[i];
+        if (CheckCollisionPointCircle(point, entry->center, entry->radius + pickRadius))
+        {
+            pushSpatialResult(query, entry);
+        }
+    }
+
+    if (node->children[0] >= 0)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            queryPointNode(index, node->children[i], point, pickRadius, query);
+        }
+    }
+}
+
+int querySpatialPoint(spatialindex_t *index, Vector2 point, float pickRadius, spatialquery_t *query)
+{
+    query->count = 0;
+    query->overflowed = false;
+    if (index->numNodes > 0)
+    {
+        queryPointNode(index, 0, point, pickRadius, query);
+    }
+    return query->count;
+}
+
+spatialentry_t *pickSpatialEntry(spatialindex_t *index, Vector2 point, float pickRadius, spatialquery_t *query)
+{
+    // Ships are drawn over bodies so they win ties, otherwise the closest centre wins
+    if (querySpatialPoint(index, point, pickRadius, query) == 0)
+        return NULL;
+
+    spatialentry_t *best = NULL;
+    float bestDist = 0;
+    for (int i = 0; i < query->count; i++)
+    {
+        spatialentry_t *entry = query->results[i];
+        float dist = Vector2Distance(point, entry->center);
+        if (best == NULL ||
+            (entry->type == SPATIAL_SHIP && best->type != SPATIAL_SHIP) ||
+            (entry->type == best->type && dist < bestDist))
+        {
+            best = entry;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+Rectangle getCameraWorldBounds(Camera2D camera, Vector2 screenSize)
+{
+    Vector2 corners[4] = {
+        GetScreenToWorld2D((Vector2){0, 0}, camera),
+        GetScreenToWorld2D((Vector2){screenSize.x, 0}, camera),
+        GetScreenToWorld2D((Vector2){0, screenSize.y}, camera),
+        GetScreenToWorld2D(screenSize, camera)};
+
+    // Take the min/max of all corners so a rotated camera is still covered
+    float minX = corners[0].x, maxX = minX;
+    float minY = corners[0].y, maxY = minY;
+    for (int i = 1; i < 4; i++)
+    {
+        minX = fminf(minX, corners[i].x);
+        maxX = fmaxf(maxX, corners[i].x);
+        minY = fminf(minY, corners[i].y);
+        maxY = fmaxf(maxY, corners[i].y);
+    }
+    return (Rectangle){minX, minY, maxX - minX, maxY - minY};
+}
+
+void drawSpatialIndex(spatialindex_t *index, Color colour)
+{
+    // Every node in the pool belongs to the current tree, so no walk is needed
+    for (int i = 0; i < index->numNodes; i++)
+    {
+        DrawRectangleLinesEx(index->nodes[i].bounds, 1.0f, colour);
+    }
+}
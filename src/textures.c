@@ -1,34 +1,331 @@
 #include "textures.h"
+#include <stdlib.h>
 #include <string.h>
+#include "config.h"
 
 static struct {
     int id;
     const char *filename;
+    bool sprite; // Packed into the sprite atlas, otherwise only loaded through the texture cache
 } textureMap[] = {
-    {0, "assets/ship/ship_1/ship_1.png"},
-    {1, "assets/ship/ship_1/ship_1_thrust.png"},
-    {2, "assets/ship/ship_1/ship_1_move_up.png"},
-    {3, "assets/ship/ship_1/ship_1_move_down.png"},
-    {4, "assets/ship/ship_1/ship_1_move_right.png"},
-    {5, "assets/ship/ship_1/ship_1_move_left.png"},
-    {6, "assets/ship/ship_1/ship_1_rotate_right.png"},
-    {7, "assets/ship/ship_1/ship_1_rotate_left.png"},
-    {8, "assets/ship/station_1/station_1_base.png"},
-    {9, "assets/ship/station_1/station_1_move_up.png"},
-    {10, "assets/ship/station_1/station_1_move_down.png"},
-    {11, "assets/ship/station_1/station_1_move_right.png"},
-    {12, "assets/ship/station_1/station_1_move_left.png"},
-    {13, "assets/ship/station_1/station_1_rotate_right.png"},
-    {14, "assets/ship/station_1/station_1_rotate_left.png"},
-    {-1, NULL}
+    {0, "assets/ship/ship_1/ship_1.png", true},
+    {1, "assets/ship/ship_1/ship_1_thrust.png", true},
+    {2, "assets/ship/ship_1/ship_1_move_up.png", true},
+    {3, "assets/ship/ship_1/ship_1_move_down.png", true},
+    {4, "assets/ship/ship_1/ship_1_move_right.png", true},
+    {5, "assets/ship/ship_1/ship_1_move_left.png", true},
+    {6, "assets/ship/ship_1/ship_1_rotate_right.png", true},
+    {7, "assets/ship/ship_1/ship_1_rotate_left.png", true},
+    {8, "assets/ship/station_1/station_1_base.png", true},
+    {9, "assets/ship/station_1/station_1_move_up.png", true},
+    {10, "assets/ship/station_1/station_1_move_down.png", true},
+    {11, "assets/ship/station_1/station_1_move_right.png", true},
+    {12, "assets/ship/station_1/station_1_move_left.png", true},
+    {13, "assets/ship/station_1/station_1_rotate_right.png", true},
+    {14, "assets/ship/station_1/station_1_rotate_left.png", true},
+    {15, "assets/icons/logo_ship.png", true},
+    {16, "assets/hud/compass.png", false},
+    {17, "assets/hud/arrow_2.png", false},
+    {18, "assets/planet/earth.png", false},
+    {19, "assets/planet/mars.png", false},
+    {20, "assets/planet/planet_1.png", false},
+    {21, "assets/planet/planet_2.png", false},
+    {22, "assets/planet/planet_3.png", false},
+    {23, "assets/planet/planet_4.png", false},
+    {24, "assets/planet/planet_5.png", false},
+    {25, "assets/moon/moon.png", false},
+    {26, "assets/moon/moon_1.png", false},
+    {27, "assets/star/sun.png", false},
+    {-1, NULL, false}
 };
 
-Texture2D LoadTextureById(int id) {
+/*
+    Texture cache
+    Standalone textures are shared by id - the first request queues the file with the asset loader, later ones only bump
+    the reference count, and the GPU copy goes when the last user calls UnloadTextureById
+    requestTextureById returns at once and getTextureById gives the placeholder until the upload lands, while
+    LoadTextureById waits for the texture like a plain LoadTexture would
+*/
+typedef struct TextureCacheEntry {
+    int asset; // Asset loader handle
+    int refCount;
+} texturecacheentry_t;
+
+static texturecacheentry_t *textureCache = NULL;
+static int textureCacheSize = 0;
+
+// Textures built by a generator rather than loaded from a file, given ids from TEXTURE_GENERATED_FIRST up
+typedef struct GeneratedTexture {
+    char name[ASSET_PATH_CAPACITY];
+    AssetGenerator generate;
+    unsigned char params[ASSET_PARAMS_CAPACITY];
+    size_t paramsSize;
+} generatedtexture_t;
+
+static generatedtexture_t *generatedTextures = NULL;
+static int numGeneratedTextures = 0;
+
+static const char *getTextureFilename(int id) {
     for (int i = 0; textureMap[i].id != -1; i++) {
         if (textureMap[i].id == id) {
-            return LoadTexture(textureMap[i].filename);
+            return textureMap[i].filename;
+        }
+    }
+    return NULL;
+}
+
+bool getTextureMapEntry(int index, int *id, const char **filename) {
+    // Walks the texture map for tools, false once past the end
+    for (int i = 0; i <= index; i++) {
+        if (textureMap[i].id == -1) {
+            return false;
+        }
+    }
+    *id = textureMap[index].id;
+    *filename = textureMap[index].filename;
+    return true;
+}
+
+int registerGeneratedTexture(const char *name, AssetGenerator generate, const void *params, size_t paramsSize) {
+    // Returns the new texture's id, or TEXTURE_NONE - it loads through the cache like any other
+    if (paramsSize > ASSET_PARAMS_CAPACITY) {
+        TraceLog(LOG_ERROR, "Parameters for %s are %zu bytes, the limit is %d", name, paramsSize, ASSET_PARAMS_CAPACITY);
+        return TEXTURE_NONE;
+    }
+    generatedtexture_t *grown = realloc(generatedTextures, sizeof(generatedtexture_t) * (numGeneratedTextures + 1));
+    if (!grown) {
+        TraceLog(LOG_ERROR, "Failed to register generated texture %s", name);
+        return TEXTURE_NONE;
+    }
+    generatedTextures = grown;
+    generatedtexture_t *texture = &generatedTextures[numGeneratedTextures];
+    *texture = (generatedtexture_t){.generate = generate, .paramsSize = paramsSize};
+    strncpy(texture->name, name, ASSET_PATH_CAPACITY - 1);
+    memcpy(texture->params, params, paramsSize);
+    return TEXTURE_GENERATED_FIRST + numGeneratedTextures++;
+}
+
+static generatedtexture_t *getGeneratedTexture(int id) {
+    int index = id - TEXTURE_GENERATED_FIRST;
+    return index >= 0 && index < numGeneratedTextures ? &generatedTextures[index] : NULL;
+}
+
+static int resolveTextureId(int id) {
+    if (getTextureFilename(id) == NULL && getGeneratedTexture(id) == NULL) {
+        TraceLog(LOG_WARNING, "Texture ID %d not found, using default", id);
+        return TEXTURE_SHIP_LOGO;
+    }
+    return id;
+}
+
+static texturecacheentry_t *getTextureCacheEntry(int id) {
+    if (id >= textureCacheSize) {
+        texturecacheentry_t *cache = realloc(textureCache, sizeof(texturecacheentry_t) * (id + 1));
+        if (!cache) {
+            TraceLog(LOG_ERROR, "Failed to grow texture cache");
+            return NULL;
+        }
+        for (int i = textureCacheSize; i <= id; i++) {
+            cache[i] = (texturecacheentry_t){.asset = -1};
+        }
+        textureCache = cache;
+        textureCacheSize = id + 1;
+    }
+    return &textureCache[id];
+}
+
+void requestTextureById(int id) {
+    id = resolveTextureId(id);
+    texturecacheentry_t *entry = getTextureCacheEntry(id);
+    if (!entry) {
+        return;
+    }
+    if (entry->refCount == 0) {
+        generatedtexture_t *generated = getGeneratedTexture(id);
+        entry->asset = generated ? requestGeneratedAsset(generated->name, generated->generate, generated->params, generated->paramsSize, ASSET_TEXTURE)
+                                 : requestAsset(getTextureFilename(id), ASSET_TEXTURE);
+    }
+    entry->refCount++;
+}
+
+Texture2D LoadTextureById(int id) {
+    requestTextureById(id);
+    id = resolveTextureId(id);
+    if (id >= textureCacheSize) {
+        return getPlaceholderTexture();
+    }
+    waitForAsset(textureCache[id].asset);
+    return getAssetTexture(textureCache[id].asset);
+}
+
+Texture2D getTextureById(int id) {
+    // The placeholder until the texture is ready, or if it failed or was never requested
+    if (id < 0 || id >= textureCacheSize || textureCache[id].refCount == 0) {
+        return getPlaceholderTexture();
+    }
+    return getAssetTexture(textureCache[id].asset);
+}
+
+AssetState getTextureState(int id) {
+    if (id < 0 || id >= textureCacheSize || textureCache[id].refCount == 0) {
+        return ASSET_FAILED;
+    }
+    return getAssetState(textureCache[id].asset);
+}
+
+void UnloadTextureById(int id) {
+    id = resolveTextureId(id);
+    if (id >= textureCacheSize || textureCache[id].refCount <= 0) {
+        TraceLog(LOG_WARNING, "Texture ID %d released more times than it was loaded", id);
+        return;
+    }
+    if (--textureCache[id].refCount == 0) {
+        releaseAsset(textureCache[id].asset);
+        textureCache[id].asset = -1;
+    }
+}
+
+int getTextureRefCount(int id) {
+    return id >= 0 && id < textureCacheSize ? textureCache[id].refCount : 0;
+}
+
+void unloadTextureCache(void) {
+    // Anything still referenced at shutdown is a missing UnloadTextureById
+    for (int i = 0; i < textureCacheSize; i++) {
+        if (textureCache[i].refCount > 0) {
+            TraceLog(LOG_WARNING, "Texture ID %d still has %d references at shutdown", i, textureCache[i].refCount);
+            releaseAsset(textureCache[i].asset);
+        }
+    }
+    free(textureCache);
+    textureCache = NULL;
+    textureCacheSize = 0;
+    free(generatedTextures);
+    generatedTextures = NULL;
+    numGeneratedTextures = 0;
+}
+
+static spriteatlas_t spriteAtlas = {0};
+
+typedef struct AtlasSprite {
+    int id;
+    Image image;
+} atlassprite_t;
+
+static int compareSpriteHeights(const void *a, const void *b) {
+    // Tallest first keeps shelves tight
+    return ((const atlassprite_t *)b)->image.height - ((const atlassprite_t *)a)->image.height;
+}
+
+static bool packSprites(atlassprite_t *sprites, int count, int size, Rectangle *regions) {
+    // Shelf packing - fill rows left to right, starting a new row below the tallest sprite of the last one
+    int x = ATLAS_PADDING, y = ATLAS_PADDING, shelfHeight = 0;
+    for (int i = 0; i < count; i++) {
+        int w = sprites[i].image.width;
+        int h = sprites[i].image.height;
+        if (x + w + ATLAS_PADDING > size) {
+            x = ATLAS_PADDING;
+            y += shelfHeight + ATLAS_PADDING;
+            shelfHeight = 0;
+        }
+        if (x + w + ATLAS_PADDING > size || y + h + ATLAS_PADDING > size) {
+            return false;
+        }
+        regions[sprites[i].id] = (Rectangle){x, y, w, h};
+        x += w + ATLAS_PADDING;
+        shelfHeight = h > shelfHeight ? h : shelfHeight;
+    }
+    return true;
+}
+
+bool loadSpriteAtlas(void) {
+    int count = 0, maxId = -1;
+    for (int i = 0; textureMap[i].id != -1; i++) {
+        if (!textureMap[i].sprite) {
+            continue;
+        }
+        count++;
+        maxId = textureMap[i].id > maxId ? textureMap[i].id : maxId;
+    }
+
+    atlassprite_t *sprites = malloc(sizeof(atlassprite_t) * count);
+    int *handles = malloc(sizeof(int) * count);
+    spriteAtlas.regions = calloc(maxId + 1, sizeof(Rectangle));
+    if (!sprites || !handles || !spriteAtlas.regions) {
+        TraceLog(LOG_ERROR, "Failed to allocate sprite atlas");
+        free(sprites);
+        free(handles);
+        return false;
+    }
+    spriteAtlas.numRegions = maxId + 1;
+
+    // Queue every sprite first so the asset workers decode them in parallel, then collect them in map order
+    for (int i = 0, s = 0; textureMap[i].id != -1; i++) {
+        if (textureMap[i].sprite) {
+            handles[s++] = requestAsset(textureMap[i].filename, ASSET_IMAGE);
+        }
+    }
+
+    int loaded = 0;
+    for (int i = 0, s = 0; textureMap[i].id != -1; i++) {
+        if (!textureMap[i].sprite) {
+            continue;
+        }
+        Image image = takeAssetImage(handles[s++]);
+        if (!IsImageValid(image)) {
+            TraceLog(LOG_WARNING, "Sprite %d (%s) failed to load, using default", textureMap[i].id, textureMap[i].filename);
+            continue;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        sprites[loaded++] = (atlassprite_t){textureMap[i].id, image};
+    }
+    free(handles);
+    qsort(sprites, loaded, sizeof(atlassprite_t), compareSpriteHeights);
+
+    int size = ATLAS_MIN_SIZE;
+    while (size <= ATLAS_MAX_SIZE && !packSprites(sprites, loaded, size, spriteAtlas.regions)) {
+        size *= 2;
+    }
+    if (size > ATLAS_MAX_SIZE) {
+        TraceLog(LOG_ERROR, "Sprites do not fit in a %dx%d atlas", ATLAS_MAX_SIZE, ATLAS_MAX_SIZE);
+        for (int i = 0; i < loaded; i++) {
+            UnloadImage(sprites[i].image);
         }
+        free(sprites);
+        return false;
+    }
+
+    Image atlas = GenImageColor(size, size, BLANK);
+    for (int i = 0; i < loaded; i++) {
+        Image image = sprites[i].image;
+        ImageDraw(&atlas, image, (Rectangle){0, 0, image.width, image.height}, spriteAtlas.regions[sprites[i].id], WHITE);
+        UnloadImage(image);
+    }
+    free(sprites);
+
+    spriteAtlas.texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    TraceLog(LOG_INFO, "Packed %d sprites into a %dx%d atlas", loaded, size, size);
+    return true;
+}
+
+void unloadSpriteAtlas(void) {
+    UnloadTexture(spriteAtlas.texture);
+    free(spriteAtlas.regions);
+    spriteAtlas = (spriteatlas_t){0};
+}
+
+Texture2D getSpriteAtlasTexture(void) {
+    return spriteAtlas.texture;
+}
+
+Rectangle getSpriteRegion(int id) {
+    // Unknown or unloaded ids fall back to the ship logo, like LoadTextureById
+    if (id >= 0 && id < spriteAtlas.numRegions && spriteAtlas.regions[id].width > 0) {
+        return spriteAtlas.regions[id];
+    }
+    if (TEXTURE_SHIP_LOGO < spriteAtlas.numRegions) {
+        return spriteAtlas.regions[TEXTURE_SHIP_LOGO];
     }
-    TraceLog(LOG_WARNING, "Texture ID %d not found, using default", id);
-    return LoadTexture("assets/icons/logo_ship.png");
-}
\ No newline at end of file
+    return (Rectangle){0};
+}
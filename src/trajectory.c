@@ -0,0 +1,334 @@
+#include "trajectory.h"
+
+/*
+    Each segment A->B becomes a quad of two triangles. Every vertex stores its path point in vertices and a unit
+    perpendicular (+n or -n) in normals, and the shader expands it by halfWidth = pixels / zoom
+    raylib meshes use 16-bit indices, which cannot address a full 36000 point path, so the triangles are not indexed
+*/
+
+// Mesh vertex buffer slots used by UploadMesh (rlgl's default attribute locations)
+#define TRAJECTORY_BUFFER_POSITION 0
+#define TRAJECTORY_BUFFER_NORMAL 2
+
+static const char *trajectoryVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec3 vertexNormal;\n"
+    "uniform mat4 mvp;\n"
+    "uniform float halfWidth;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = mvp * vec4(vertexPosition.xy + vertexNormal.xy * halfWidth, vertexPosition.z, 1.0);\n"
+    "}\n";
+
+static const char *trajectoryFragmentShader =
+    "#version 330\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    finalColor = colDiffuse;\n"
+    "}\n";
+
+trajectoryrenderer_t *createTrajectoryRenderer(void)
+{
+    // The shader is loaded on first replay, so paths can be recorded without a window
+    trajectoryrenderer_t *renderer = malloc(sizeof(trajectoryrenderer_t));
+    if (!renderer)
+    {
+        TraceLog(LOG_ERROR, "Failed to allocate trajectoryrenderer_t");
+        return NULL;
+    }
+    renderer->loaded = false;
+    renderer->meshes = NULL;
+    renderer->numMeshes = 0;
+    renderer->retired = NULL;
+    renderer->numRetired = 0;
+    renderer->retiredCapacity = 0;
+    return renderer;
+}
+
+static void loadTrajectoryShader(trajectoryrenderer_t *renderer)
+{
+    renderer->shader = LoadShaderFromMemory(trajectoryVertexShader, trajectoryFragmentShader);
+    renderer->halfWidthLoc = GetShaderLocation(renderer->shader, "halfWidth");
+    renderer->material = LoadMaterialDefault();
+    renderer->material.shader = renderer->shader;
+    renderer->loaded = true;
+}
+
+static void unloadRetiredMeshes(trajectoryrenderer_t *renderer)
+{
+    for (int i = 0; i < renderer->numRetired; i++)
+    {
+        UnloadMesh(renderer->retired[i]);
+    }
+    renderer->numRetired = 0;
+}
+
+static bool retireTrajectoryMesh(trajectoryrenderer_t *renderer, trajectorymesh_t *trajectory)
+{
+    // Hands the uploaded chunks to replay to unload - fails without changing anything if the list cannot grow
+    int uploaded = 0;
+    for (int i = 0; i < trajectory->numChunks; i++)
+    {
+        uploaded += trajectory->chunks[i].uploaded;
+    }
+    if (renderer->numRetired + uploaded > renderer->retiredCapacity)
+    {
+        int capacity = (renderer->numRetired + uploaded) * 2;
+        Mesh *retired = realloc(renderer->retired, sizeof(Mesh) * capacity);
+        if (!retired)
+        {
+            TraceLog(LOG_ERROR, "Failed to retire %i trajectory chunks", uploaded);
+            return false;
+        }
+        renderer->retired = retired;
+        renderer->retiredCapacity = capacity;
+    }
+    for (int i = 0; i < trajectory->numChunks; i++)
+    {
+        if (trajectory->chunks[i].uploaded)
+        {
+            renderer->retired[renderer->numRetired++] = trajectory->chunks[i].mesh;
+        }
+    }
+    free(trajectory->chunks);
+    *trajectory = (trajectorymesh_t){0};
+    return true;
+}
+
+static void unloadTrajectoryMesh(trajectorymesh_t *trajectory)
+{
+    for (int i = 0; i < trajectory->numChunks; i++)
+    {
+        if (trajectory->chunks[i].uploaded)
+        {
+            UnloadMesh(trajectory->chunks[i].mesh);
+        }
+    }
+    free(trajectory->chunks);
+    *trajectory = (trajectorymesh_t){0};
+}
+
+void freeTrajectoryRenderer(trajectoryrenderer_t *renderer)
+{
+    if (!renderer)
+        return;
+    for (int i = 0; i < renderer->numMeshes; i++)
+    {
+        unloadTrajectoryMesh(&renderer->meshes[i]);
+    }
+    free(renderer->meshes);
+    unloadRetiredMeshes(renderer);
+    free(renderer->retired);
+    if (renderer->loaded)
+    {
+        // Also unloads the custom shader
+        UnloadMaterial(renderer->material);
+    }
+    free(renderer);
+}
+
+static void fillTrajectoryVertices(Mesh *mesh, const Vector2 *points, int segmentCount)
+{
+    float *v = mesh->vertices;
+    float *n = mesh->normals;
+    for (int i = 0; i < segmentCount; i++)
+    {
+        Vector2 a = points[i];
+        Vector2 b = points[i + 1];
+        Vector2 dir = Vector2Subtract(b, a);
+        float length = Vector2Length(dir);
+        // Repeated points (e.g. after a collision) give zero-area triangles
+        Vector2 perp = length > 0.0f ? (Vector2){-dir.y / length, dir.x / length} : Vector2Zero();
+
+        // A-n, A+n, B+n and A-n, B+n, B-n - counter-clockwise on screen like raylib's own quads
+        Vector2 corners[6] = {a, a, b, a, b, b};
+        float sides[6] = {-1, 1, 1, -1, 1, -1};
+        for (int k = 0; k < 6; k++)
+        {
+            *v++ = corners[k].x;
+            *v++ = corners[k].y;
+            *v++ = 0.0f;
+            *n++ = perp.x * sides[k];
+            *n++ = perp.y * sides[k];
+            *n++ = 0.0f;
+        }
+    }
+}
+
+static bool syncTrajectoryBounds(trajectoryrenderer_t *renderer, trajectorymesh_t *trajectory, ship_t *ship)
+{
+    int segmentCount = ship->trajectorySize - 1;
+
+    if (trajectory->ship != ship || trajectory->segmentCount != segmentCount)
+    {
+        // New ship in this slot or a resized path - start again, chunks upload on first sight
+        if (!retireTrajectoryMesh(renderer, trajectory))
+            return false;
+        int numChunks = (segmentCount + TRAJECTORY_CHUNK_SEGMENTS - 1) / TRAJECTORY_CHUNK_SEGMENTS;
+        trajectory->chunks = calloc(numChunks, sizeof(trajectorychunk_t));
+        if (!trajectory->chunks)
+        {
+            TraceLog(LOG_ERROR, "Failed to allocate %i trajectory chunks", numChunks);
+            return false;
+        }
+        trajectory->ship = ship;
+        trajectory->segmentCount = segmentCount;
+        trajectory->numChunks = numChunks;
+        trajectory->revision = ship->trajectoryRevision - 1;
+    }
+
+    if (trajectory->revision != ship->trajectoryRevision)
+    {
+        // Bounds are cheap to refresh for every chunk - vertex data waits until a chunk is actually visible
+        for (int c = 0; c < trajectory->numChunks; c++)
+        {
+            int first = c * TRAJECTORY_CHUNK_SEGMENTS;
+            int last = first + TRAJECTORY_CHUNK_SEGMENTS < segmentCount ? first + TRAJECTORY_CHUNK_SEGMENTS : segmentCount;
+            Vector2 min = ship->futurePositions[first];
+            Vector2 max = min;
+            for (int i = first + 1; i <= last; i++)
+            {
+                min = Vector2Min(min, ship->futurePositions[i]);
+                max = Vector2Max(max, ship->futurePositions[i]);
+            }
+            trajectory->chunks[c].bounds = (Rectangle){min.x, min.y, max.x - min.x, max.y - min.y};
+        }
+        trajectory->revision = ship->trajectoryRevision;
+    }
+    return true;
+}
+
+static bool syncTrajectoryChunk(trajectorychunk_t *chunk, ship_t *ship, int first, int segmentCount)
+{
+    const Vector2 *points = ship->futurePositions + first;
+
+    if (!chunk->uploaded)
+    {
+        Mesh mesh = {0};
+        mesh.vertexCount = segmentCount * 6;
+        mesh.triangleCount = segmentCount * 2;
+        mesh.vertices = MemAlloc(sizeof(float) * 3 * mesh.vertexCount);
+        mesh.normals = MemAlloc(sizeof(float) * 3 * mesh.vertexCount);
+        if (!mesh.vertices || !mesh.normals)
+        {
+            TraceLog(LOG_ERROR, "Failed to allocate trajectory chunk of %i segments", segmentCount);
+            MemFree(mesh.vertices);
+            MemFree(mesh.normals);
+            return false;
+        }
+        fillTrajectoryVertices(&mesh, points, segmentCount);
+        UploadMesh(&mesh, true);
+        chunk->mesh = mesh;
+        chunk->uploaded = true;
+        chunk->revision = ship->trajectoryRevision;
+        return true;
+    }
+
+    if (chunk->revision != ship->trajectoryRevision)
+    {
+        int dataSize = sizeof(float) * 3 * chunk->mesh.vertexCount;
+        fillTrajectoryVertices(&chunk->mesh, points, segmentCount);
+        UpdateMeshBuffer(chunk->mesh, TRAJECTORY_BUFFER_POSITION, chunk->mesh.vertices, dataSize, 0);
+        UpdateMeshBuffer(chunk->mesh, TRAJECTORY_BUFFER_NORMAL, chunk->mesh.normals, dataSize, 0);
+        chunk->revision = ship->trajectoryRevision;
+    }
+    return true;
+}
+
+void drawTrajectories(drawlist_t *list, trajectoryrenderer_t *renderer, ship_t **ships, int numShips, Camera2D *camera, Rectangle view, ColourScheme *colourScheme)
+{
+    if (numShips > renderer->numMeshes)
+    {
+        trajectorymesh_t *meshes = realloc(renderer->meshes, sizeof(trajectorymesh_t) * numShips);
+        if (!meshes)
+        {
+            TraceLog(LOG_ERROR, "Failed to grow trajectory meshes");
+            return;
+        }
+        for (int i = renderer->numMeshes; i < numShips; i++)
+        {
+            meshes[i] = (trajectorymesh_t){0};
+        }
+        renderer->meshes = meshes;
+        renderer->numMeshes = numShips;
+    }
+
+    float halfWidth = TRAJECTORY_LINE_WIDTH / 2 / camera->zoom;
+
+    // Chunk bounds hold the path points only, so widen the view by the line's half width instead
+    Rectangle padded = {view.x - halfWidth, view.y - halfWidth, view.width + halfWidth * 2, view.height + halfWidth * 2};
+
+    drawcommand_t *begin = pushDrawCommand(list, DRAW_OP_TRAJECTORIES_BEGIN);
+    if (!begin)
+        return;
+    begin->trajectories.renderer = renderer;
+    begin->trajectories.halfWidth = halfWidth;
+    begin->trajectories.colour = colourScheme->orbitColour;
+
+    for (int i = 0; i < numShips; i++)
+    {
+        if (!ships[i]->drawTrajectory || ships[i]->futurePositions == NULL || ships[i]->trajectorySize < 2)
+        {
+            continue;
+        }
+        trajectorymesh_t *trajectory = &renderer->meshes[i];
+        if (!syncTrajectoryBounds(renderer, trajectory, ships[i]))
+        {
+            continue;
+        }
+        for (int c = 0; c < trajectory->numChunks; c++)
+        {
+            if (!CheckCollisionRecs(trajectory->chunks[c].bounds, padded))
+            {
+                continue;
+            }
+            drawcommand_t *command = pushDrawCommand(list, DRAW_OP_TRAJECTORY_CHUNK);
+            if (!command)
+                break;
+            int first = c * TRAJECTORY_CHUNK_SEGMENTS;
+            command->trajectoryChunk.renderer = renderer;
+            command->trajectoryChunk.mesh = i;
+            command->trajectoryChunk.chunk = c;
+            command->trajectoryChunk.first = first;
+            command->trajectoryChunk.segmentCount = trajectory->segmentCount - first < TRAJECTORY_CHUNK_SEGMENTS ? trajectory->segmentCount - first : TRAJECTORY_CHUNK_SEGMENTS;
+            command->trajectoryChunk.bounds = trajectory->chunks[c].bounds;
+        }
+    }
+
+    drawcommand_t *end = pushDrawCommand(list, DRAW_OP_TRAJECTORIES_END);
+    if (end)
+        end->trajectories.renderer = renderer;
+}
+
+void beginTrajectoryReplay(trajectoryrenderer_t *renderer, float halfWidth, Color colour)
+{
+    if (!renderer->loaded)
+    {
+        loadTrajectoryShader(renderer);
+    }
+    SetShaderValue(renderer->shader, renderer->halfWidthLoc, &halfWidth, SHADER_UNIFORM_FLOAT);
+    renderer->material.maps[MATERIAL_MAP_DIFFUSE].color = colour;
+
+    // Switching shader flushes the pending 2D batch, so the grid and orbits stay underneath the paths
+    BeginShaderMode(renderer->shader);
+}
+
+void replayTrajectoryChunk(trajectoryrenderer_t *renderer, int mesh, int chunk, int first, int segmentCount)
+{
+    // Vertex data is only built for chunks that were in view when recorded
+    trajectorymesh_t *trajectory = &renderer->meshes[mesh];
+    if (syncTrajectoryChunk(&trajectory->chunks[chunk], trajectory->ship, first, segmentCount))
+    {
+        DrawMesh(trajectory->chunks[chunk].mesh, renderer->material, MatrixIdentity());
+    }
+}
+
+void endTrajectoryReplay(trajectoryrenderer_t *renderer)
+{
+    EndShaderMode();
+    // This frame's ops all point at current chunks, so the ones retired while recording it are no longer drawn
+    unloadRetiredMeshes(renderer);
+}
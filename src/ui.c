@@ -0,0 +1,140 @@
+#include "ui.h"
+#include <math.h>
+#include <stdio.h>
+
+// rlgl is built into libraylib but its header is not bundled - these match its declarations and GL enum values
+void rlSetBlendFactorsSeparate(int glSrcRGB, int glDstRGB, int glSrcAlpha, int glDstAlpha, int glEqRGB, int glEqAlpha);
+#define RL_ONE 1
+#define RL_SRC_ALPHA 0x0302
+#define RL_ONE_MINUS_SRC_ALPHA 0x0303
+#define RL_FUNC_ADD 0x8006
+
+long long quantiseHudValue(double value, double precision)
+{
+    return llround(value / precision);
+}
+
+bool setHudText(hudtext_t *widget, long long key, const char *format, ...)
+{
+    // Returns whether the text changed
+    if (widget->valid && widget->key == key)
+    {
+        return false;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(widget->text, HUD_TEXT_CAPACITY, format, args);
+    va_end(args);
+    widget->key = key;
+    widget->valid = true;
+    widget->width = -1;
+    return true;
+}
+
+bool setHudNumber(hudtext_t *widget, double value, double precision, const char *format)
+{
+    // Formats the quantised value, so the text only ever changes when the key does
+    long long key = quantiseHudValue(value, precision);
+    return setHudText(widget, key, format, key * precision);
+}
+
+drawlist_t *beginHudLayer(hudlayer_t *layer, Vector2 screenSize)
+{
+    // Returns the content list to record into when the layer needs it, or NULL to keep the last recording
+    if (layer->content.commands != NULL && layer->content.screenSize.x == screenSize.x && layer->content.screenSize.y == screenSize.y)
+    {
+        return NULL;
+    }
+    clearDrawList(&layer->content, screenSize);
+    layer->baked = false;
+    return &layer->content;
+}
+
+void invalidateHudLayer(hudlayer_t *layer)
+{
+    // Forces the next beginHudLayer to record again, e.g. once a texture the layer shows has finished loading
+    layer->content.screenSize = (Vector2){0, 0};
+}
+
+void freeHudLayer(hudlayer_t *layer)
+{
+    if (layer->target.id != 0)
+    {
+        UnloadRenderTexture(layer->target);
+    }
+    freeDrawList(&layer->content);
+    *layer = (hudlayer_t){0};
+}
+
+void drawListHudText(drawlist_t *list, hudtext_t *widget, int x, int y, int fontSize, TextAlign align, Color colour)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_HUD_TEXT);
+    if (command)
+    {
+        command->hudText.widget = widget;
+        command->hudText.x = x;
+        command->hudText.y = y;
+        command->hudText.fontSize = fontSize;
+        command->hudText.align = align;
+        command->hudText.colour = colour;
+    }
+}
+
+void drawListHudLayer(drawlist_t *list, hudlayer_t *layer)
+{
+    drawcommand_t *command = pushDrawCommand(list, DRAW_OP_HUD_LAYER);
+    if (command)
+        command->hudLayer = layer;
+}
+
+void replayHudText(hudtext_t *widget, int x, int y, int fontSize, TextAlign align, Color colour)
+{
+    if (align != DRAW_TEXT_ALIGN_LEFT && (widget->width < 0 || widget->measuredSize != fontSize))
+    {
+        widget->width = MeasureText(widget->text, fontSize);
+        widget->measuredSize = fontSize;
+    }
+    if (align == DRAW_TEXT_ALIGN_CENTRE)
+        x -= widget->width / 2;
+    else if (align == DRAW_TEXT_ALIGN_RIGHT)
+        x -= widget->width;
+    DrawText(widget->text, x, y, fontSize, colour);
+}
+
+void replayHudLayer(hudlayer_t *layer)
+{
+    int width = (int)layer->content.screenSize.x;
+    int height = (int)layer->content.screenSize.y;
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    if (!layer->baked)
+    {
+        if (layer->target.id == 0 || layer->target.texture.width != width || layer->target.texture.height != height)
+        {
+            if (layer->target.id != 0)
+            {
+                UnloadRenderTexture(layer->target);
+            }
+            layer->target = LoadRenderTexture(width, height);
+        }
+        // Colour blends as usual, leaving it multiplied by coverage, but alpha accumulates as a + dst * (1 - a).
+        // Plain alpha blending would store a^2 and weaken every translucent part when composited
+        BeginTextureMode(layer->target);
+        ClearBackground(BLANK);
+        rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+        BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+        replayDrawList(&layer->content);
+        EndBlendMode();
+        EndTextureMode();
+        layer->baked = true;
+    }
+
+    // The baked layer is premultiplied - colour is c * a with coverage a - so composite it premultiplied
+    // Render textures are stored bottom-up, so flip the source
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(layer->target.texture, (Rectangle){0, 0, (float)width, (float)-height}, (Vector2){0, 0}, WHITE);
+    EndBlendMode();
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "config.h"
+#include "textures.h"
+#include "assetpack.h"
+
+/*
+    Asset pack builder
+    Decodes every file in the texture map to RGBA8 and writes them into one pack the game maps at startup instead of
+    decoding PNGs. The pack is written beside its final path and renamed over it once complete, then mapped back and
+    compared against the decoded images, so a failed build never leaves a half-written pack for the game to find
+
+    Usage: pack_builder [output]   (default ASSET_PACK_PATH)
+*/
+
+typedef struct PackImage
+{
+    assetpackentry_t entry;
+    const char *filename;
+    Image image;
+} packimage_t;
+
+static int comparePathHashes(const void *a, const void *b)
+{
+    uint64_t ha = ((const packimage_t *)a)->entry.pathHash;
+    uint64_t hb = ((const packimage_t *)b)->entry.pathHash;
+    return (ha > hb) - (ha < hb);
+}
+
+static uint64_t alignPackOffset(uint64_t offset)
+{
+    return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+}
+
+static int loadPackImages(packimage_t **images)
+{
+    // Returns how many were decoded, or -1 if any file failed
+    int count = 0, id;
+    const char *filename;
+    while (getTextureMapEntry(count, &id, &filename))
+        count++;
+
+    *images = calloc(count, sizeof(packimage_t));
+    if (!*images)
+        return -1;
+    for (int i = 0; i < count; i++)
+    {
+        getTextureMapEntry(i, &id, &filename);
+        Image image = LoadImage(filename);
+        if (!IsImageValid(image))
+        {
+            fprintf(stderr, "Failed to decode %s (texture %d)\n", filename, id);
+            for (int j = 0; j < i; j++)
+                UnloadImage((*images)[j].image);
+            free(*images);
+            return -1;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        (*images)[i] = (packimage_t){
+            .entry = {
+                .pathHash = hashAssetPath(filename),
+                .size = (uint64_t)image.width * image.height * 4,
+                .id = id,
+                .width = image.width,
+                .height = image.height,
+                .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8},
+            .filename = filename,
+            .image = image};
+    }
+    return count;
+}
+
+static bool writePack(const char *path, packimage_t *images, int count)
+{
+    // Lay the pixels out after the index, each at an aligned offset
+    uint64_t offset = sizeof(assetpackheader_t) + sizeof(assetpackentry_t) * count;
+    for (int i = 0; i < count; i++)
+    {
+        offset = alignPackOffset(offset);
+        images[i].entry.offset = offset;
+        offset += images[i].entry.size;
+    }
+
+    char tmpPath[ASSET_PATH_CAPACITY];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", tmpPath);
+        return false;
+    }
+
+    assetpackheader_t header = {.magic = ASSET_PACK_MAGIC, .version = ASSET_PACK_VERSION, .numEntries = count};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; i < count && ok; i++)
+        ok = fwrite(&images[i].entry, sizeof(assetpackentry_t), 1, file) == 1;
+    static const unsigned char padding[ASSET_PACK_ALIGNMENT] = {0};
+    for (int i = 0; i < count && ok; i++)
+    {
+        long gap = (long)images[i].entry.offset - ftell(file);
+        ok = (gap == 0 || fwrite(padding, gap, 1, file) == 1) &&
+             fwrite(images[i].image.data, images[i].entry.size, 1, file) == 1;
+    }
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tmpPath, path) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+static bool verifyPack(const char *path, packimage_t *images, int count)
+{
+    if (!openAssetPack(path))
+        return false;
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++)
+    {
+        Image byPath, byId;
+        ok = findPackedImage(images[i].filename, &byPath) && findPackedImageById(images[i].entry.id, &byId) &&
+             byPath.data == byId.data && memcmp(byPath.data, images[i].image.data, images[i].entry.size) == 0;
+        if (!ok)
+            fprintf(stderr, "Pack does not match %s\n", images[i].filename);
+    }
+    closeAssetPack();
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : ASSET_PACK_PATH;
+    SetTraceLogLevel(LOG_WARNING);
+
+    packimage_t *images;
+    int count = loadPackImages(&images);
+    if (count < 0)
+        return 1;
+    qsort(images, count, sizeof(packimage_t), comparePathHashes);
+    for (int i = 1; i < count; i++)
+    {
+        if (images[i].entry.pathHash == images[i - 1].entry.pathHash)
+        {
+            fprintf(stderr, "%s and %s have the same path hash\n", images[i - 1].filename, images[i].filename);
+            return 1;
+        }
+    }
+
+    bool ok = writePack(path, images, count) && verifyPack(path, images, count);
+    uint64_t bytes = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bytes += images[i].entry.size;
+        UnloadImage(images[i].image);
+    }
+    free(images);
+    if (!ok)
+        return 1;
+    printf("Packed %d images, %.1f KiB of pixels, into %s\n", count, bytes / 1024.0, path);
+    return 0;
+}